@@ -0,0 +1,122 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#include "AllocationCounter.h"
+
+#include <cstdlib>
+#include <new>
+
+#include <boost/atomic.hpp>
+#include <boost/config.hpp>
+
+namespace {
+
+boost::atomic<boost::uint64_t> numAllocations(0);
+boost::atomic<boost::uint64_t> numBytes(0);
+boost::atomic<bool>            counting(true);
+
+void* allocate(std::size_t size) {
+    if (counting.load(boost::memory_order_relaxed)) {
+        numAllocations.fetch_add(1, boost::memory_order_relaxed);
+        numBytes.fetch_add(size, boost::memory_order_relaxed);
+    }
+    return std::malloc(size ? size : 1);
+}
+
+}
+
+// Replacements of the global allocation functions. They only count
+// and forward to malloc and free.
+
+void* operator new(std::size_t size) {
+    void* result = allocate(size);
+    if (!result) {
+        throw std::bad_alloc();
+    }
+    return result;
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) BOOST_NOEXCEPT {
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) BOOST_NOEXCEPT {
+    return allocate(size);
+}
+
+void operator delete(void* pointer) BOOST_NOEXCEPT {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer) BOOST_NOEXCEPT {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) BOOST_NOEXCEPT {
+    std::free(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) BOOST_NOEXCEPT {
+    std::free(pointer);
+}
+
+namespace rsb {
+namespace bench {
+
+AllocationCount currentAllocationCount() {
+    AllocationCount result;
+    result.allocations = numAllocations.load();
+    result.bytes       = numBytes.load();
+    return result;
+}
+
+PauseMeasurement::PauseMeasurement(benchmark::State& state) :
+    state(state) {
+    this->state.PauseTiming();
+    counting.store(false);
+}
+
+PauseMeasurement::~PauseMeasurement() {
+    counting.store(true);
+    this->state.ResumeTiming();
+}
+
+void reportAllocations(benchmark::State& state, const AllocationCount& start) {
+    AllocationCount end = currentAllocationCount();
+    state.counters["allocs/op"]
+        = benchmark::Counter(double(end.allocations - start.allocations),
+                             benchmark::Counter::kAvgIterations);
+    state.counters["alloc_bytes/op"]
+        = benchmark::Counter(double(end.bytes - start.bytes),
+                             benchmark::Counter::kAvgIterations);
+}
+
+}
+}
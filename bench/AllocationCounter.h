@@ -0,0 +1,73 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#pragma once
+
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <benchmark/benchmark.h>
+
+namespace rsb {
+namespace bench {
+
+/**
+ * Number and total size of the allocations made via the global
+ * operator new of the benchmark executable.
+ */
+struct AllocationCount {
+    boost::uint64_t allocations;
+    boost::uint64_t bytes;
+};
+
+/**
+ * Returns the allocations counted so far.
+ */
+AllocationCount currentAllocationCount();
+
+/**
+ * Stops timing of @a state and counting of allocations for the
+ * lifetime of the instance. Used to exclude setup from the
+ * measurement of an iteration.
+ *
+ * @author jmoringe
+ */
+class PauseMeasurement : boost::noncopyable {
+public:
+    explicit PauseMeasurement(benchmark::State& state);
+    ~PauseMeasurement();
+private:
+    benchmark::State& state;
+};
+
+/**
+ * Adds the counters @c allocs/op and @c alloc_bytes/op for the
+ * allocations made since @a start to @a state.
+ */
+void reportAllocations(benchmark::State& state, const AllocationCount& start);
+
+}
+}
@@ -0,0 +1,94 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <rsc/misc/langutils.h>
+
+#include <rsb/protocol/Notification.pb.h>
+
+#include <rsb/transport/spread/Assembly.h>
+
+#include "AllocationCounter.h"
+
+using namespace std;
+
+using namespace rsb;
+using namespace rsb::bench;
+using namespace rsb::transport::spread;
+
+namespace {
+
+const unsigned int FRAGMENT_SIZE = 1000;
+
+void BM_AssemblyPoolAdd(benchmark::State& state) {
+    const unsigned int numParts = state.range(0);
+
+    vector<protocol::FragmentedNotification> templates(numParts);
+    for (unsigned int i = 0; i < numParts; ++i) {
+        protocol::Notification* notification
+            = templates[i].mutable_notification();
+        notification->mutable_event_id()->set_sender_id("0123456789abcdef");
+        if (i == 0) {
+            notification->set_scope("/bench/assembly");
+        }
+        notification->set_data(rsc::misc::randAlnumStr(FRAGMENT_SIZE));
+        templates[i].set_data_part(i);
+        templates[i].set_num_data_parts(numParts);
+    }
+
+    AssemblyPool pool;
+    vector<protocol::FragmentedNotificationPtr> fragments(numParts);
+    boost::uint32_t sequenceNumber = 0;
+
+    AllocationCount start = currentAllocationCount();
+    while (state.KeepRunning()) {
+        {
+            PauseMeasurement pause(state);
+            ++sequenceNumber;
+            for (unsigned int i = 0; i < numParts; ++i) {
+                fragments[i].reset(new protocol::FragmentedNotification(templates[i]));
+                fragments[i]->mutable_notification()->mutable_event_id()
+                    ->set_sequence_number(sequenceNumber);
+            }
+        }
+
+        protocol::NotificationPtr result;
+        for (unsigned int i = 0; i < numParts; ++i) {
+            result = pool.add(fragments[i]);
+        }
+        benchmark::DoNotOptimize(result.get());
+    }
+    reportAllocations(state, start);
+    state.SetBytesProcessed(state.iterations() * numParts * FRAGMENT_SIZE);
+}
+
+}
+
+BENCHMARK(BM_AssemblyPoolAdd)->Arg(2)->Arg(8)->Arg(32);
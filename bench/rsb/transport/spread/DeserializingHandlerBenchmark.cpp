@@ -0,0 +1,111 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <rsc/misc/langutils.h>
+
+#include <rsb/protocol/Notification.pb.h>
+
+#include <rsb/transport/spread/DeserializingHandler.h>
+
+#include "AllocationCounter.h"
+
+using namespace std;
+
+using namespace rsb;
+using namespace rsb::bench;
+using namespace rsb::transport::spread;
+
+namespace {
+
+vector<protocol::FragmentedNotification> makeFragments(unsigned int numParts,
+                                                       unsigned int partSize) {
+    vector<protocol::FragmentedNotification> fragments(numParts);
+    for (unsigned int i = 0; i < numParts; ++i) {
+        protocol::Notification* notification
+            = fragments[i].mutable_notification();
+        notification->mutable_event_id()->set_sender_id("0123456789abcdef");
+        if (i == 0) {
+            notification->set_scope("/bench/deserializing/handler");
+            notification->set_wire_schema("utf-8-string");
+            notification->mutable_meta_data()->set_create_time(1);
+            notification->mutable_meta_data()->set_send_time(2);
+        }
+        notification->set_data(rsc::misc::randAlnumStr(partSize));
+        fragments[i].set_data_part(i);
+        fragments[i].set_num_data_parts(numParts);
+    }
+    return fragments;
+}
+
+// Handles one notification of range(0) fragments of range(1) bytes
+// each per iteration. Each notification has a new sequence number
+// such that neither the assembly pool nor the loss detection treat
+// it as a duplicate.
+void BM_DeserializingHandlerHandleMessage(benchmark::State& state) {
+    const unsigned int numParts = state.range(0);
+    const unsigned int partSize = state.range(1);
+
+    vector<protocol::FragmentedNotification> fragments
+        = makeFragments(numParts, partSize);
+    vector<SpreadMessage> messages(numParts, SpreadMessage(SpreadMessage::REGULAR));
+    for (unsigned int i = 0; i < numParts; ++i) {
+        messages[i].setSender("#bench#localhost");
+    }
+
+    DeserializingHandler handler;
+    boost::uint32_t sequenceNumber = 0;
+
+    AllocationCount start = currentAllocationCount();
+    while (state.KeepRunning()) {
+        {
+            PauseMeasurement pause(state);
+            ++sequenceNumber;
+            for (unsigned int i = 0; i < numParts; ++i) {
+                fragments[i].mutable_notification()->mutable_event_id()
+                    ->set_sequence_number(sequenceNumber);
+                fragments[i].SerializeToString(&messages[i].mutableData());
+            }
+        }
+
+        IncomingNotificationPtr result;
+        for (unsigned int i = 0; i < numParts; ++i) {
+            result = handler.handleMessage(messages[i]);
+        }
+        benchmark::DoNotOptimize(result.get());
+    }
+    reportAllocations(state, start);
+    state.SetBytesProcessed(state.iterations() * numParts * partSize);
+}
+
+}
+
+BENCHMARK(BM_DeserializingHandlerHandleMessage)
+->Args({1, 64})->Args({1, 65536})->Args({4, 65536})->Args({16, 65536});
@@ -0,0 +1,79 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#include <string>
+
+#include <boost/format.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <rsb/transport/spread/GroupNameCache.h>
+
+#include "AllocationCounter.h"
+
+using namespace std;
+
+using namespace rsb;
+using namespace rsb::bench;
+using namespace rsb::transport::spread;
+
+namespace {
+
+Scope makeScope(unsigned int depth) {
+    string scope;
+    for (unsigned int i = 0; i < depth; ++i) {
+        scope += boost::str(boost::format("/level%1%") % i);
+    }
+    return Scope(scope.empty() ? "/" : scope);
+}
+
+void BM_GroupNameCacheScopeToGroups(benchmark::State& state) {
+    GroupNameCache cache;
+    Scope scope = makeScope(state.range(0));
+    cache.scopeToGroups(scope);
+
+    AllocationCount start = currentAllocationCount();
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(&cache.scopeToGroups(scope));
+    }
+    reportAllocations(state, start);
+}
+
+void BM_GroupNameCacheScopeToGroup(benchmark::State& state) {
+    Scope scope = makeScope(state.range(0));
+
+    AllocationCount start = currentAllocationCount();
+    while (state.KeepRunning()) {
+        string group = GroupNameCache::scopeToGroup(scope);
+        benchmark::DoNotOptimize(group.data());
+    }
+    reportAllocations(state, start);
+}
+
+}
+
+BENCHMARK(BM_GroupNameCacheScopeToGroups)->Arg(1)->Arg(4)->Arg(16);
+BENCHMARK(BM_GroupNameCacheScopeToGroup)->Arg(1)->Arg(4)->Arg(16);
@@ -0,0 +1,139 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#include <string>
+
+#include <boost/shared_ptr.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <rsc/misc/langutils.h>
+#include <rsc/misc/UUID.h>
+#include <rsc/runtime/TypeStringTools.h>
+
+#include <rsb/Event.h>
+
+#include <rsb/converter/Repository.h>
+
+#include <rsb/transport/spread/OutConnector.h>
+
+#include "AllocationCounter.h"
+
+using namespace std;
+
+using namespace rsb;
+using namespace rsb::bench;
+using namespace rsb::transport::spread;
+
+namespace {
+
+// A bus which discards outgoing notifications such that only the
+// work of the connector is measured.
+class NullBus : public Bus {
+public:
+    NullBus() :
+        metrics(new MetricsRegistry()) {
+    }
+
+    const string getTransportURL() const {
+        return "spread://null";
+    }
+
+    void activate() {
+    }
+
+    void deactivate() {
+    }
+
+    void addSink(const Scope& /*scope*/, SinkPtr /*sink*/) {
+    }
+
+    void removeSink(const Scope& /*scope*/, const Sink* /*sink*/) {
+    }
+
+    void handleOutgoingNotification(OutgoingNotificationPtr /*notification*/) {
+    }
+
+    void handleIncomingNotification(IncomingNotificationPtr /*notification*/) {
+    }
+
+    void handleControlMessage(const SpreadMessage& /*message*/) {
+    }
+
+    void handleError(const std::exception& /*error*/) {
+    }
+
+    MetricsRegistryPtr getMetrics() const {
+        return this->metrics;
+    }
+
+    bool getScopeMetrics() const {
+        return false;
+    }
+private:
+    MetricsRegistryPtr metrics;
+};
+
+void handleEvents(benchmark::State& state, bool compact) {
+    boost::shared_ptr<rsb::transport::spread::OutConnector> connector
+        (new rsb::transport::spread::OutConnector
+         (converter::converterRepository<string>()
+          ->getConvertersForSerialization(),
+          BusPtr(new NullBus()), 100000));
+    connector->setCompactFragments(compact);
+    connector->activate();
+
+    boost::shared_ptr<string> data
+        (new string(rsc::misc::randAlnumStr(state.range(0))));
+    EventPtr event(new Event(Scope("/bench/out/connector"), data,
+                             rsc::runtime::typeName<string>()));
+    event->setId(rsc::misc::UUID(), 1);
+
+    AllocationCount start = currentAllocationCount();
+    while (state.KeepRunning()) {
+        connector->handle(event);
+    }
+    reportAllocations(state, start);
+    state.SetBytesProcessed(state.iterations() * data->size());
+
+    connector->deactivate();
+}
+
+void BM_OutConnectorHandle(benchmark::State& state) {
+    handleEvents(state, false);
+}
+
+void BM_OutConnectorHandleCompact(benchmark::State& state) {
+    handleEvents(state, true);
+}
+
+}
+
+// Sizes below and above the fragment size of 100000 bytes.
+BENCHMARK(BM_OutConnectorHandle)
+->Arg(64)->Arg(4096)->Arg(65536)->Arg(150000)->Arg(1000000);
+BENCHMARK(BM_OutConnectorHandleCompact)
+->Arg(150000)->Arg(1000000);
@@ -0,0 +1,755 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/format.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+#include <boost/algorithm/string.hpp>
+
+#include <boost/program_options.hpp>
+
+#include <rsc/misc/langutils.h>
+#include <rsc/misc/UUID.h>
+
+#include <rsc/runtime/Properties.h>
+#include <rsc/runtime/TypeStringTools.h>
+
+#include <rsc/subprocess/Subprocess.h>
+
+#include <rsb/Event.h>
+#include <rsb/Handler.h>
+#include <rsb/QualityOfServiceSpec.h>
+#include <rsb/Scope.h>
+
+#include <rsb/converter/Repository.h>
+#include <rsb/converter/converters.h>
+
+#include <rsb/transport/spread/Factory.h>
+
+#include "benchconfig.h"
+
+using namespace std;
+
+using namespace rsb;
+using namespace rsb::transport;
+
+namespace po = boost::program_options;
+
+// rsbspread-bench
+//
+// Measures publish throughput and round-trip latency of the Spread
+// transport against a Spread daemon. Each subscriber uses its own
+// bus and therefore its own daemon connection, such that all events
+// pass through the daemon even though publisher and subscribers run
+// in one process. Results are written as JSON.
+
+namespace {
+
+typedef converter::ConverterSelectionStrategy<string>::Ptr ConverterSelectionStrategyPtr;
+
+const Scope BASE_SCOPE("/rsbspread-bench");
+const Scope REPLY_SCOPE("/rsbspread-bench-reply");
+
+struct Options {
+    string               host;
+    unsigned int         port;
+    bool                 startDaemon;
+
+    vector<unsigned int> payloadSizes;
+    vector<unsigned int> subscriberCounts;
+    vector<unsigned int> scopeDepths;
+    vector<string>       qualities;
+
+    unsigned int         numEvents;
+    unsigned int         numRoundTrips;
+    unsigned int         timeoutMs;
+
+    map<string, string>  transportOptions;
+
+    string               output;
+};
+
+vector<unsigned int> parseNumbers(const string& value) {
+    vector<string> items;
+    boost::split(items, value, boost::is_any_of(","));
+    vector<unsigned int> result;
+    for (vector<string>::const_iterator it = items.begin();
+         it != items.end(); ++it) {
+        result.push_back(boost::lexical_cast<unsigned int>(boost::trim_copy(*it)));
+    }
+    return result;
+}
+
+QualityOfServiceSpec parseQualityOfService(const string& name) {
+    if (name == "unreliable") {
+        return QualityOfServiceSpec(QualityOfServiceSpec::UNORDERED,
+                                    QualityOfServiceSpec::UNRELIABLE);
+    } else if (name == "reliable") {
+        return QualityOfServiceSpec(QualityOfServiceSpec::UNORDERED,
+                                    QualityOfServiceSpec::RELIABLE);
+    } else if (name == "ordered-unreliable") {
+        return QualityOfServiceSpec(QualityOfServiceSpec::ORDERED,
+                                    QualityOfServiceSpec::UNRELIABLE);
+    } else if (name == "ordered") {
+        return QualityOfServiceSpec(QualityOfServiceSpec::ORDERED,
+                                    QualityOfServiceSpec::RELIABLE);
+    } else {
+        throw invalid_argument(boost::str(boost::format("Invalid quality of "
+                                                        "service '%1%'")
+                                          % name));
+    }
+}
+
+/**
+ * Parses the commandline into @a options.
+ *
+ * @return @c false if the program should exit without running the
+ *         benchmark.
+ */
+bool parseOptions(int argc, char* argv[], Options& options) {
+    string sizes, subscribers, depths, qualities;
+    vector<string> transportOptions;
+
+    po::options_description description("Allowed options");
+    description.add_options()
+        ("help,h", "Print this help and exit.")
+        ("host", po::value<string>(&options.host)->default_value("localhost"),
+         "Host of the Spread daemon.")
+        ("port", po::value<unsigned int>(&options.port)->default_value(SPREAD_PORT),
+         "Port of the Spread daemon.")
+        ("start-daemon", po::bool_switch(&options.startDaemon),
+         "Start a local Spread daemon on the configured port for the "
+         "duration of the benchmark.")
+        ("sizes", po::value<string>(&sizes)
+         ->default_value("64,1024,16384,99000,101000,400000"),
+         "Comma-separated payload sizes in bytes. The defaults cross "
+         "the default fragment size of 100000 bytes.")
+        ("subscribers", po::value<string>(&subscribers)->default_value("1,4"),
+         "Comma-separated numbers of subscribers.")
+        ("depths", po::value<string>(&depths)->default_value("1,8"),
+         "Comma-separated numbers of scope components.")
+        ("qos", po::value<string>(&qualities)->default_value("unreliable,reliable"),
+         "Comma-separated qualities of service. One of unreliable, "
+         "reliable, ordered-unreliable and ordered.")
+        ("events", po::value<unsigned int>(&options.numEvents)->default_value(1000),
+         "Number of events published per throughput measurement.")
+        ("roundtrips", po::value<unsigned int>(&options.numRoundTrips)
+         ->default_value(200),
+         "Number of round trips per latency measurement.")
+        ("timeout", po::value<unsigned int>(&options.timeoutMs)->default_value(2000),
+         "Time in milliseconds after which missing events are "
+         "considered lost.")
+        ("option,o", po::value< vector<string> >(&transportOptions)->composing(),
+         "Spread transport option of the form NAME=VALUE, for example "
+         "maxfragmentsize=50000 or connections=4. Can be repeated.")
+        ("output", po::value<string>(&options.output)->default_value("-"),
+         "File to which results should be written. - for standard "
+         "output.");
+
+    po::variables_map map;
+    po::store(po::parse_command_line(argc, argv, description), map);
+    po::notify(map);
+
+    if (map.count("help")) {
+        cout << "Usage: " << argv[0] << " [OPTIONS]" << endl << endl
+             << description << endl;
+        return false;
+    }
+
+    options.payloadSizes     = parseNumbers(sizes);
+    options.subscriberCounts = parseNumbers(subscribers);
+    options.scopeDepths      = parseNumbers(depths);
+    boost::split(options.qualities, qualities, boost::is_any_of(","));
+    for (vector<string>::const_iterator it = options.qualities.begin();
+         it != options.qualities.end(); ++it) {
+        parseQualityOfService(*it);
+    }
+    for (vector<string>::const_iterator it = transportOptions.begin();
+         it != transportOptions.end(); ++it) {
+        string::size_type index = it->find('=');
+        if (index == string::npos) {
+            throw invalid_argument(boost::str(boost::format("Invalid transport "
+                                                            "option '%1%'")
+                                              % *it));
+        }
+        options.transportOptions[it->substr(0, index)] = it->substr(index + 1);
+    }
+    if (options.startDaemon && (options.port != SPREAD_PORT)) {
+        throw invalid_argument(boost::str(boost::format("The started daemon "
+                                                        "uses port %1%")
+                                          % SPREAD_PORT));
+    }
+    return true;
+}
+
+rsc::runtime::Properties makeTransportOptions(const Options&                options,
+                                              ConverterSelectionStrategyPtr converters) {
+    rsc::runtime::Properties result;
+    result["host"] = options.host;
+    result["port"] = boost::lexical_cast<string>(options.port);
+    for (map<string, string>::const_iterator it
+             = options.transportOptions.begin();
+         it != options.transportOptions.end(); ++it) {
+        result[it->first] = it->second;
+    }
+    result["converters"] = converters;
+    return result;
+}
+
+Scope makeScope(unsigned int depth) {
+    Scope scope = BASE_SCOPE;
+    for (unsigned int i = 1; i < depth; ++i) {
+        scope = scope.concat(Scope(boost::str(boost::format("/level%1%") % i)));
+    }
+    return scope;
+}
+
+rsc::subprocess::SubprocessPtr startSpread() {
+    vector<string> spreadArgs;
+    spreadArgs.push_back("-n");
+    spreadArgs.push_back("localhost");
+    spreadArgs.push_back("-c");
+    spreadArgs.push_back(SPREAD_CONFIG_FILE);
+    cerr << "Starting " << SPREAD_EXECUTABLE << " with " << SPREAD_CONFIG_FILE
+         << endl;
+    rsc::subprocess::SubprocessPtr process
+        = rsc::subprocess::Subprocess::newInstance(SPREAD_EXECUTABLE,
+                                                   spreadArgs);
+    boost::this_thread::sleep(boost::posix_time::seconds(2));
+    return process;
+}
+
+/**
+ * A receiving participant with its own bus. Counts received events
+ * and, if enabled, answers each of them with an empty event on @ref
+ * REPLY_SCOPE which carries the sequence number of the received
+ * event.
+ */
+class Subscriber {
+public:
+    Subscriber(const Options& options, const Scope& scope) :
+        replyData(new string()), echo(false), numReceived(0), lastReceiveTime(0) {
+        this->in.reset(this->factory.createInConnector
+                       (makeTransportOptions(options,
+                                             converter::converterRepository<string>()
+                                             ->getConvertersForDeserialization())));
+        this->out.reset(this->factory.createOutConnector
+                        (makeTransportOptions(options,
+                                              converter::converterRepository<string>()
+                                              ->getConvertersForSerialization())));
+        this->out->activate();
+        this->in->setScope(scope);
+        this->in->addHandler(HandlerPtr
+                             (new EventFunctionHandler
+                              (boost::bind(&Subscriber::handle, this, _1))));
+        this->in->activate();
+    }
+
+    ~Subscriber() {
+        this->in->deactivate();
+        this->out->deactivate();
+    }
+
+    void setEcho(bool echo) {
+        boost::mutex::scoped_lock lock(this->mutex);
+        this->echo = echo;
+    }
+
+    void reset() {
+        boost::mutex::scoped_lock lock(this->mutex);
+        this->numReceived     = 0;
+        this->lastReceiveTime = 0;
+    }
+
+    unsigned int getNumReceived() const {
+        boost::mutex::scoped_lock lock(this->mutex);
+        return this->numReceived;
+    }
+
+    boost::uint64_t getLastReceiveTime() const {
+        boost::mutex::scoped_lock lock(this->mutex);
+        return this->lastReceiveTime;
+    }
+
+    void handle(EventPtr event) {
+        boost::uint64_t now = rsc::misc::currentTimeMicros();
+        bool echo;
+        {
+            boost::mutex::scoped_lock lock(this->mutex);
+            ++this->numReceived;
+            this->lastReceiveTime = now;
+            echo = this->echo;
+        }
+
+        if (echo) {
+            EventPtr reply(new Event(REPLY_SCOPE, this->replyData,
+                                     rsc::runtime::typeName<string>()));
+            reply->setId(this->id, event->getId().getSequenceNumber());
+            this->out->handle(reply);
+        }
+    }
+private:
+    // The factory has to outlive the connectors.
+    spread::Factory           factory;
+    InConnectorPtr            in;
+    OutConnectorPtr           out;
+
+    rsc::misc::UUID           id;
+    boost::shared_ptr<string> replyData;
+
+    mutable boost::mutex      mutex;
+    bool                      echo;
+    unsigned int              numReceived;
+    boost::uint64_t           lastReceiveTime;
+};
+
+typedef boost::shared_ptr<Subscriber> SubscriberPtr;
+
+/**
+ * The sending participant. Publishes events and collects the
+ * replies of subscribers to one event at a time.
+ */
+class Publisher {
+public:
+    Publisher(const Options& options) :
+        sequenceNumber(0), expectedSequenceNumber(0) {
+        this->out.reset(this->factory.createOutConnector
+                        (makeTransportOptions(options,
+                                              converter::converterRepository<string>()
+                                              ->getConvertersForSerialization())));
+        this->in.reset(this->factory.createInConnector
+                       (makeTransportOptions(options,
+                                             converter::converterRepository<string>()
+                                             ->getConvertersForDeserialization())));
+        this->out->activate();
+        this->in->setScope(REPLY_SCOPE);
+        this->in->addHandler(HandlerPtr
+                             (new EventFunctionHandler
+                              (boost::bind(&Publisher::handleReply, this, _1))));
+        this->in->activate();
+    }
+
+    ~Publisher() {
+        this->in->deactivate();
+        this->out->deactivate();
+    }
+
+    void setQualityOfServiceSpecs(const QualityOfServiceSpec& specs) {
+        this->out->setQualityOfServiceSpecs(specs);
+    }
+
+    /**
+     * Publishes @a data on @a scope and returns the sequence number
+     * of the event.
+     */
+    boost::uint32_t publish(const Scope& scope, boost::shared_ptr<string> data) {
+        EventPtr event(new Event(scope, data, rsc::runtime::typeName<string>()));
+        event->setId(this->id, ++this->sequenceNumber);
+        this->out->handle(event);
+        return this->sequenceNumber;
+    }
+
+    /**
+     * Publishes @a data on @a scope and waits for up to
+     * @a numReplies replies.
+     *
+     * @return The round-trip times of the replies in microseconds.
+     */
+    vector<boost::uint64_t> roundTrip(const Scope&              scope,
+                                      boost::shared_ptr<string> data,
+                                      unsigned int              numReplies,
+                                      unsigned int              timeoutMs) {
+        boost::mutex::scoped_lock lock(this->replyMutex);
+        this->expectedSequenceNumber = this->sequenceNumber + 1;
+        this->replyTimes.clear();
+
+        boost::uint64_t start = rsc::misc::currentTimeMicros();
+        publish(scope, data);
+
+        boost::system_time deadline = boost::get_system_time()
+            + boost::posix_time::milliseconds(timeoutMs);
+        while (this->replyTimes.size() < numReplies) {
+            if (!this->replyCondition.timed_wait(lock, deadline)) {
+                break;
+            }
+        }
+
+        vector<boost::uint64_t> result;
+        for (vector<boost::uint64_t>::const_iterator it
+                 = this->replyTimes.begin(); it != this->replyTimes.end(); ++it) {
+            result.push_back(*it - start);
+        }
+        return result;
+    }
+
+    void handleReply(EventPtr event) {
+        boost::uint64_t now = rsc::misc::currentTimeMicros();
+
+        boost::mutex::scoped_lock lock(this->replyMutex);
+        if (event->getId().getSequenceNumber() == this->expectedSequenceNumber) {
+            this->replyTimes.push_back(now);
+            this->replyCondition.notify_all();
+        }
+    }
+private:
+    spread::Factory           factory;
+    OutConnectorPtr           out;
+    InConnectorPtr            in;
+
+    rsc::misc::UUID           id;
+    boost::uint32_t           sequenceNumber;
+
+    boost::mutex              replyMutex;
+    boost::condition_variable replyCondition;
+    boost::uint32_t           expectedSequenceNumber;
+    vector<boost::uint64_t>   replyTimes;
+};
+
+struct ThroughputResult {
+    double       publishSeconds;
+    unsigned int minReceived;
+    unsigned int maxReceived;
+    double       minReceiveRate;
+};
+
+struct LatencyResult {
+    vector<boost::uint64_t> samples;
+    unsigned int            lost;
+};
+
+struct Result {
+    unsigned int     numSubscribers;
+    unsigned int     scopeDepth;
+    string           quality;
+    unsigned int     payloadSize;
+    ThroughputResult throughput;
+    LatencyResult    latency;
+};
+
+/**
+ * Publishes small events until each subscriber has received one such
+ * that the group memberships of all subscribers are established.
+ */
+bool waitForSubscribers(Publisher&                   publisher,
+                        const vector<SubscriberPtr>& subscribers,
+                        const Scope&                 scope,
+                        unsigned int                 timeoutMs) {
+    boost::shared_ptr<string> data(new string("warm-up"));
+    boost::uint64_t deadline = rsc::misc::currentTimeMicros()
+        + boost::uint64_t(timeoutMs) * 1000;
+    while (rsc::misc::currentTimeMicros() < deadline) {
+        publisher.publish(scope, data);
+        boost::this_thread::sleep(boost::posix_time::milliseconds(50));
+
+        bool ready = true;
+        for (vector<SubscriberPtr>::const_iterator it = subscribers.begin();
+             it != subscribers.end(); ++it) {
+            ready = ready && ((*it)->getNumReceived() > 0);
+        }
+        if (ready) {
+            return true;
+        }
+    }
+    return false;
+}
+
+ThroughputResult measureThroughput(Publisher&                   publisher,
+                                   const vector<SubscriberPtr>& subscribers,
+                                   const Scope&                 scope,
+                                   boost::shared_ptr<string>    data,
+                                   const Options&               options) {
+    for (vector<SubscriberPtr>::const_iterator it = subscribers.begin();
+         it != subscribers.end(); ++it) {
+        (*it)->reset();
+    }
+
+    boost::uint64_t start = rsc::misc::currentTimeMicros();
+    for (unsigned int i = 0; i < options.numEvents; ++i) {
+        publisher.publish(scope, data);
+    }
+    boost::uint64_t end = rsc::misc::currentTimeMicros();
+
+    // Wait until all events have been received or until there has
+    // been no progress for the timeout.
+    unsigned int previousTotal = 0;
+    boost::uint64_t lastProgress = rsc::misc::currentTimeMicros();
+    while (true) {
+        unsigned int total = 0;
+        for (vector<SubscriberPtr>::const_iterator it = subscribers.begin();
+             it != subscribers.end(); ++it) {
+            total += (*it)->getNumReceived();
+        }
+        boost::uint64_t now = rsc::misc::currentTimeMicros();
+        if (total == options.numEvents * subscribers.size()) {
+            break;
+        } else if (total != previousTotal) {
+            previousTotal = total;
+            lastProgress  = now;
+        } else if (now - lastProgress > boost::uint64_t(options.timeoutMs) * 1000) {
+            break;
+        }
+        boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+    }
+
+    ThroughputResult result;
+    result.publishSeconds = (end - start) / 1e6;
+    result.minReceived    = options.numEvents;
+    result.maxReceived    = 0;
+    result.minReceiveRate = -1;
+    for (vector<SubscriberPtr>::const_iterator it = subscribers.begin();
+         it != subscribers.end(); ++it) {
+        unsigned int received = (*it)->getNumReceived();
+        result.minReceived = min(result.minReceived, received);
+        result.maxReceived = max(result.maxReceived, received);
+        double seconds = ((*it)->getLastReceiveTime() - start) / 1e6;
+        double rate = (received > 0) ? received / seconds : 0;
+        if ((result.minReceiveRate < 0) || (rate < result.minReceiveRate)) {
+            result.minReceiveRate = rate;
+        }
+    }
+    return result;
+}
+
+LatencyResult measureLatency(Publisher&                   publisher,
+                             const vector<SubscriberPtr>& subscribers,
+                             const Scope&                 scope,
+                             boost::shared_ptr<string>    data,
+                             const Options&               options) {
+    for (vector<SubscriberPtr>::const_iterator it = subscribers.begin();
+         it != subscribers.end(); ++it) {
+        (*it)->setEcho(true);
+    }
+
+    LatencyResult result;
+    result.lost = 0;
+    for (unsigned int i = 0; i < options.numRoundTrips; ++i) {
+        vector<boost::uint64_t> times
+            = publisher.roundTrip(scope, data, subscribers.size(),
+                                  options.timeoutMs);
+        result.samples.insert(result.samples.end(), times.begin(), times.end());
+        result.lost += subscribers.size() - times.size();
+    }
+    sort(result.samples.begin(), result.samples.end());
+
+    for (vector<SubscriberPtr>::const_iterator it = subscribers.begin();
+         it != subscribers.end(); ++it) {
+        (*it)->setEcho(false);
+    }
+    return result;
+}
+
+vector<Result> runBenchmark(const Options& options) {
+    vector<Result> results;
+
+    Publisher publisher(options);
+    for (vector<unsigned int>::const_iterator depth = options.scopeDepths.begin();
+         depth != options.scopeDepths.end(); ++depth) {
+        Scope scope = makeScope(*depth);
+        for (vector<unsigned int>::const_iterator numSubscribers
+                 = options.subscriberCounts.begin();
+             numSubscribers != options.subscriberCounts.end(); ++numSubscribers) {
+            vector<SubscriberPtr> subscribers;
+            for (unsigned int i = 0; i < *numSubscribers; ++i) {
+                subscribers.push_back(SubscriberPtr(new Subscriber(options, scope)));
+            }
+            if (!waitForSubscribers(publisher, subscribers, scope, 10000)) {
+                throw runtime_error("Subscribers did not receive events");
+            }
+
+            for (vector<string>::const_iterator quality = options.qualities.begin();
+                 quality != options.qualities.end(); ++quality) {
+                publisher.setQualityOfServiceSpecs(parseQualityOfService(*quality));
+                for (vector<unsigned int>::const_iterator size
+                         = options.payloadSizes.begin();
+                     size != options.payloadSizes.end(); ++size) {
+                    cerr << boost::format("subscribers = %1%, depth = %2%, "
+                                          "qos = %3%, size = %4%")
+                        % *numSubscribers % *depth % *quality % *size
+                         << endl;
+
+                    boost::shared_ptr<string> data
+                        (new string(rsc::misc::randAlnumStr(*size)));
+
+                    Result result;
+                    result.numSubscribers = *numSubscribers;
+                    result.scopeDepth     = *depth;
+                    result.quality        = *quality;
+                    result.payloadSize    = *size;
+                    result.throughput     = measureThroughput
+                        (publisher, subscribers, scope, data, options);
+                    result.latency        = measureLatency
+                        (publisher, subscribers, scope, data, options);
+                    results.push_back(result);
+                }
+            }
+        }
+    }
+    return results;
+}
+
+// JSON output
+
+string jsonString(const string& value) {
+    ostringstream stream;
+    stream << '"';
+    for (string::const_iterator it = value.begin(); it != value.end(); ++it) {
+        switch (*it) {
+        case '"':  stream << "\\\""; break;
+        case '\\': stream << "\\\\"; break;
+        case '\n': stream << "\\n";  break;
+        case '\t': stream << "\\t";  break;
+        default:
+            if (static_cast<unsigned char>(*it) < 0x20) {
+                stream << boost::format("\\u%04x") % unsigned(*it);
+            } else {
+                stream << *it;
+            }
+        }
+    }
+    stream << '"';
+    return stream.str();
+}
+
+boost::uint64_t percentile(const vector<boost::uint64_t>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t rank = size_t(p * sorted.size() + 0.5);
+    return sorted[min(sorted.size() - 1, rank > 0 ? rank - 1 : 0)];
+}
+
+void writeLatency(ostream& stream, const LatencyResult& latency) {
+    const vector<boost::uint64_t>& samples = latency.samples;
+    double mean = 0;
+    for (vector<boost::uint64_t>::const_iterator it = samples.begin();
+         it != samples.end(); ++it) {
+        mean += double(*it) / samples.size();
+    }
+    stream << "{\"samples\": " << samples.size()
+           << ", \"lost\": " << latency.lost
+           << ", \"min_us\": " << (samples.empty() ? 0 : samples.front())
+           << ", \"mean_us\": " << mean
+           << ", \"p50_us\": " << percentile(samples, 0.5)
+           << ", \"p90_us\": " << percentile(samples, 0.9)
+           << ", \"p99_us\": " << percentile(samples, 0.99)
+           << ", \"p999_us\": " << percentile(samples, 0.999)
+           << ", \"max_us\": " << (samples.empty() ? 0 : samples.back())
+           << "}";
+}
+
+void writeResults(ostream& stream, const Options& options,
+                  const vector<Result>& results) {
+    stream << "{" << endl
+           << "  \"host\": " << jsonString(options.host) << "," << endl
+           << "  \"port\": " << options.port << "," << endl
+           << "  \"events\": " << options.numEvents << "," << endl
+           << "  \"roundtrips\": " << options.numRoundTrips << "," << endl
+           << "  \"transport_options\": {";
+    for (map<string, string>::const_iterator it
+             = options.transportOptions.begin();
+         it != options.transportOptions.end(); ++it) {
+        stream << (it == options.transportOptions.begin() ? "" : ", ")
+               << jsonString(it->first) << ": " << jsonString(it->second);
+    }
+    stream << "}," << endl
+           << "  \"results\": [";
+    for (vector<Result>::const_iterator it = results.begin();
+         it != results.end(); ++it) {
+        const ThroughputResult& throughput = it->throughput;
+        stream << (it == results.begin() ? "" : ",") << endl
+               << "    {\"subscribers\": " << it->numSubscribers
+               << ", \"scope_depth\": " << it->scopeDepth
+               << ", \"qos\": " << jsonString(it->quality)
+               << ", \"payload_bytes\": " << it->payloadSize << "," << endl
+               << "     \"throughput\": {\"publish_seconds\": "
+               << throughput.publishSeconds
+               << ", \"publish_events_per_second\": "
+               << options.numEvents / throughput.publishSeconds
+               << ", \"publish_megabytes_per_second\": "
+               << (double(options.numEvents) * it->payloadSize
+                   / throughput.publishSeconds / 1e6)
+               << ", \"received_min\": " << throughput.minReceived
+               << ", \"received_max\": " << throughput.maxReceived
+               << ", \"receive_events_per_second_min\": "
+               << throughput.minReceiveRate << "}," << endl
+               << "     \"latency\": ";
+        writeLatency(stream, it->latency);
+        stream << "}";
+    }
+    stream << endl << "  ]" << endl
+           << "}" << endl;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    try {
+        if (!parseOptions(argc, argv, options)) {
+            return EXIT_SUCCESS;
+        }
+    } catch (const exception& e) {
+        cerr << "Invalid commandline: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    converter::registerDefaultConverters();
+
+    rsc::subprocess::SubprocessPtr daemon;
+    if (options.startDaemon) {
+        daemon = startSpread();
+    }
+
+    vector<Result> results;
+    try {
+        results = runBenchmark(options);
+    } catch (const exception& e) {
+        cerr << "Benchmark failed: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    if (options.output == "-") {
+        writeResults(cout, options, results);
+    } else {
+        ofstream stream(options.output.c_str());
+        writeResults(stream, options, results);
+    }
+
+    return EXIT_SUCCESS;
+}
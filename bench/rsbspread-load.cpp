@@ -0,0 +1,687 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/format.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+#include <boost/program_options.hpp>
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#include <rsc/misc/langutils.h>
+#include <rsc/misc/UUID.h>
+
+#include <rsc/runtime/Properties.h>
+#include <rsc/runtime/TypeStringTools.h>
+
+#include <rsb/Event.h>
+#include <rsb/Handler.h>
+#include <rsb/QualityOfServiceSpec.h>
+#include <rsb/Scope.h>
+
+#include <rsb/converter/Repository.h>
+#include <rsb/converter/converters.h>
+
+#include <rsb/transport/spread/Factory.h>
+#include <rsb/transport/spread/Metrics.h>
+
+using namespace std;
+
+using namespace rsb;
+using namespace rsb::transport;
+
+namespace po = boost::program_options;
+namespace pt = boost::property_tree;
+
+// rsbspread-load
+//
+// Generates load on a Spread daemon as described by a topology file
+// and reports sustained throughput, lost events, receive failures
+// and latency percentiles periodically and at the end of the run.
+//
+// The topology file is a JSON document such as:
+//
+// {
+//     "duration": 600,
+//     "report-interval": 10,
+//     "buses": {
+//         "a": { "host": "localhost", "port": "4803" },
+//         "b": { "host": "localhost", "port": "4803", "connections": "4" }
+//     },
+//     "informers": [
+//         { "bus": "a", "scope": "/load/sensors", "count": 8, "rate": 200,
+//           "sizes": [64, 1024, 150000], "qos": "unreliable",
+//           "new-scope-interval": 30 }
+//     ],
+//     "listeners": [
+//         { "bus": "b", "scope": "/load", "count": 4, "churn-interval": 20 }
+//     ]
+// }
+//
+// Durations are in seconds. Each bus entry contains Spread transport
+// options and results in a separate bus with its own daemon
+// connections. Informers publish with "rate" events per second,
+// cycling through the payload "sizes". With a "count" larger than
+// one, instance i uses the sub-scope /i of "scope". With a
+// "new-scope-interval", informers periodically switch to a new
+// sub-scope to exercise scope creation. Listeners with a
+// "churn-interval" periodically leave and rejoin their scope.
+
+typedef rsb::converter::ConverterSelectionStrategy<string>::Ptr ConverterSelectionStrategyPtr;
+
+const string RECEIVE_FAILURES_METRIC = "rsb_spread_receive_failures_total";
+
+struct Options {
+    string       topologyFile;
+    unsigned int durationSeconds;
+    string       output;
+};
+
+/**
+ * Parses the commandline into @a options.
+ *
+ * @return @c false if the program should exit without generating
+ *         load.
+ */
+bool parseOptions(int argc, char* argv[], Options& options) {
+    po::options_description description("Allowed options");
+    description.add_options()
+        ("help,h", "Print this help and exit.")
+        ("topology", po::value<string>(&options.topologyFile),
+         "The topology file describing buses, informers and listeners.")
+        ("duration", po::value<unsigned int>(&options.durationSeconds)
+         ->default_value(0),
+         "Duration of the run in seconds. Overrides the duration in "
+         "the topology file if not zero.")
+        ("output", po::value<string>(&options.output)->default_value("-"),
+         "File to which the summary should be written as JSON. - for "
+         "standard output.");
+
+    po::positional_options_description positional;
+    positional.add("topology", 1);
+
+    po::variables_map map;
+    po::store(po::command_line_parser(argc, argv)
+              .options(description).positional(positional).run(), map);
+    po::notify(map);
+
+    if (map.count("help") || !map.count("topology")) {
+        cout << "Usage: " << argv[0] << " [OPTIONS] TOPOLOGY" << endl << endl
+             << description << endl;
+        return false;
+    }
+    return true;
+}
+
+QualityOfServiceSpec parseQualityOfService(const string& name) {
+    if (name == "unreliable") {
+        return QualityOfServiceSpec(QualityOfServiceSpec::UNORDERED,
+                                    QualityOfServiceSpec::UNRELIABLE);
+    } else if (name == "reliable") {
+        return QualityOfServiceSpec(QualityOfServiceSpec::UNORDERED,
+                                    QualityOfServiceSpec::RELIABLE);
+    } else if (name == "ordered-unreliable") {
+        return QualityOfServiceSpec(QualityOfServiceSpec::ORDERED,
+                                    QualityOfServiceSpec::UNRELIABLE);
+    } else if (name == "ordered") {
+        return QualityOfServiceSpec(QualityOfServiceSpec::ORDERED,
+                                    QualityOfServiceSpec::RELIABLE);
+    } else {
+        throw invalid_argument(boost::str(boost::format("Invalid quality of "
+                                                        "service '%1%'")
+                                          % name));
+    }
+}
+
+/**
+ * Counters shared by all informers and listeners.
+ */
+class Statistics {
+public:
+    struct Snapshot {
+        Snapshot() :
+            time(0), sent(0), sentBytes(0), sendErrors(0), received(0),
+            lost(0), latencyBuckets(spread::Histogram::NUM_BUCKETS, 0) {
+        }
+
+        boost::uint64_t         time;
+        boost::uint64_t         sent;
+        boost::uint64_t         sentBytes;
+        boost::uint64_t         sendErrors;
+        boost::uint64_t         received;
+        boost::uint64_t         lost;
+        vector<boost::uint64_t> latencyBuckets;
+    };
+
+    Statistics() :
+        sent(0), sentBytes(0), sendErrors(0), received(0), lost(0) {
+    }
+
+    void recordSent(size_t size) {
+        boost::mutex::scoped_lock lock(this->mutex);
+        ++this->sent;
+        this->sentBytes += size;
+    }
+
+    void recordSendError() {
+        boost::mutex::scoped_lock lock(this->mutex);
+        ++this->sendErrors;
+    }
+
+    void recordReceived(boost::uint64_t latency, boost::uint64_t lost) {
+        this->latency.record(latency);
+        boost::mutex::scoped_lock lock(this->mutex);
+        ++this->received;
+        this->lost += lost;
+    }
+
+    Snapshot snapshot() const {
+        Snapshot result;
+        result.time = rsc::misc::currentTimeMicros();
+        for (unsigned int i = 0; i < spread::Histogram::NUM_BUCKETS; ++i) {
+            result.latencyBuckets[i] = this->latency.getBucketCount(i);
+        }
+        boost::mutex::scoped_lock lock(this->mutex);
+        result.sent       = this->sent;
+        result.sentBytes  = this->sentBytes;
+        result.sendErrors = this->sendErrors;
+        result.received   = this->received;
+        result.lost       = this->lost;
+        return result;
+    }
+private:
+    mutable boost::mutex mutex;
+    boost::uint64_t      sent;
+    boost::uint64_t      sentBytes;
+    boost::uint64_t      sendErrors;
+    boost::uint64_t      received;
+    boost::uint64_t      lost;
+    spread::Histogram    latency;
+};
+
+/**
+ * A bus of the topology. Each bus has its own factory such that its
+ * connectors do not share daemon connections with other buses.
+ */
+class Endpoint {
+public:
+    Endpoint(const rsc::runtime::Properties& options) :
+        options(options) {
+    }
+
+    rsc::runtime::Properties makeOptions(ConverterSelectionStrategyPtr converters) const {
+        rsc::runtime::Properties result = this->options;
+        result["converters"] = converters;
+        return result;
+    }
+
+    spread::Factory& getFactory() {
+        return this->factory;
+    }
+
+    boost::uint64_t getReceiveFailures() const {
+        const spread::Counter* counter
+            = this->factory.getMetrics()->findCounter(RECEIVE_FAILURES_METRIC);
+        return counter ? counter->get() : 0;
+    }
+private:
+    rsc::runtime::Properties options;
+    spread::Factory          factory;
+};
+
+typedef boost::shared_ptr<Endpoint> EndpointPtr;
+
+/**
+ * Publishes events at a fixed rate, cycling through payload sizes.
+ * The first eight bytes of each payload contain the send time for
+ * measuring latency.
+ */
+class LoadInformer {
+public:
+    LoadInformer(EndpointPtr                    endpoint,
+                 const Scope&                   scope,
+                 double                         rate,
+                 const vector<unsigned int>&    sizes,
+                 const QualityOfServiceSpec&    qos,
+                 unsigned int                   newScopeIntervalMs,
+                 Statistics&                    statistics) :
+        scope(scope), rate(rate), sizes(sizes),
+        newScopeIntervalMs(newScopeIntervalMs), statistics(statistics) {
+        this->out.reset(endpoint->getFactory().createOutConnector
+                        (endpoint->makeOptions
+                         (converter::converterRepository<string>()
+                          ->getConvertersForSerialization())));
+        this->out->setQualityOfServiceSpecs(qos);
+        this->out->activate();
+    }
+
+    ~LoadInformer() {
+        this->out->deactivate();
+    }
+
+    void run(boost::uint64_t deadline) {
+        boost::uint64_t start = rsc::misc::currentTimeMicros();
+        boost::uint64_t scopeStart = start;
+        unsigned int    generation = 0;
+        Scope           scope = this->scope;
+        rsc::misc::UUID id;
+        boost::uint32_t sequenceNumber = 0;
+
+        for (boost::uint64_t i = 0; ; ++i) {
+            boost::uint64_t now = rsc::misc::currentTimeMicros();
+            if (now >= deadline) {
+                break;
+            }
+
+            // Events are sent on a new scope with a new sender id,
+            // such that listeners of the previous scope do not miss
+            // sequence numbers.
+            if ((this->newScopeIntervalMs > 0)
+                && (now - scopeStart >= this->newScopeIntervalMs * 1000ull)) {
+                scope = this->scope.concat(Scope(boost::str(boost::format("/g%1%")
+                                                            % ++generation)));
+                id = rsc::misc::UUID();
+                sequenceNumber = 0;
+                scopeStart = now;
+            }
+
+            if (this->rate > 0) {
+                boost::uint64_t due = start + boost::uint64_t(i * 1e6 / this->rate);
+                if (due > now) {
+                    boost::this_thread::sleep
+                        (boost::posix_time::microseconds(due - now));
+                }
+            }
+
+            unsigned int size = this->sizes[i % this->sizes.size()];
+            boost::shared_ptr<string> data(new string(max(size, 8u), 'x'));
+            boost::uint64_t sendTime = rsc::misc::currentTimeMicros();
+            memcpy(&(*data)[0], &sendTime, sizeof(sendTime));
+
+            EventPtr event(new Event(scope, data, rsc::runtime::typeName<string>()));
+            event->setId(id, ++sequenceNumber);
+            try {
+                this->out->handle(event);
+                this->statistics.recordSent(data->size());
+            } catch (const exception&) {
+                this->statistics.recordSendError();
+            }
+        }
+    }
+private:
+    Scope                scope;
+    double               rate;
+    vector<unsigned int> sizes;
+    unsigned int         newScopeIntervalMs;
+    Statistics&          statistics;
+    OutConnectorPtr      out;
+};
+
+typedef boost::shared_ptr<LoadInformer> LoadInformerPtr;
+
+/**
+ * Receives events on a scope and detects lost events by gaps in
+ * the sequence numbers of each sender. With a churn interval, the
+ * listener periodically leaves and rejoins its scope.
+ */
+class LoadListener {
+public:
+    LoadListener(EndpointPtr  endpoint,
+                 const Scope& scope,
+                 unsigned int churnIntervalMs,
+                 Statistics&  statistics) :
+        endpoint(endpoint), scope(scope), churnIntervalMs(churnIntervalMs),
+        statistics(statistics) {
+        join();
+    }
+
+    ~LoadListener() {
+        leave();
+    }
+
+    void run(boost::uint64_t deadline) {
+        if (this->churnIntervalMs == 0) {
+            return;
+        }
+        while (true) {
+            boost::uint64_t now = rsc::misc::currentTimeMicros();
+            boost::uint64_t next = now + this->churnIntervalMs * 1000ull;
+            if (next >= deadline) {
+                break;
+            }
+            boost::this_thread::sleep(boost::posix_time::microseconds(next - now));
+            leave();
+            join();
+        }
+    }
+
+    void handle(EventPtr event) {
+        boost::uint64_t now = rsc::misc::currentTimeMicros();
+        boost::shared_ptr<string> data
+            = boost::static_pointer_cast<string>(event->getData());
+        boost::uint64_t sendTime = 0;
+        if (data->size() >= sizeof(sendTime)) {
+            memcpy(&sendTime, data->data(), sizeof(sendTime));
+        }
+
+        // Only gaps are counted. Reordered and duplicated events are
+        // not lost.
+        boost::uint64_t lost = 0;
+        {
+            boost::mutex::scoped_lock lock(this->mutex);
+            boost::uint32_t& last = this->lastSequenceNumbers[event->getId().getParticipantId()];
+            boost::uint32_t current = event->getId().getSequenceNumber();
+            if ((last != 0) && (current > last + 1)) {
+                lost = current - last - 1;
+            }
+            if (current > last) {
+                last = current;
+            }
+        }
+        this->statistics.recordReceived((now > sendTime) ? now - sendTime : 0,
+                                        lost);
+    }
+private:
+    void join() {
+        // Events sent while the listener was not a member are not
+        // lost.
+        {
+            boost::mutex::scoped_lock lock(this->mutex);
+            this->lastSequenceNumbers.clear();
+        }
+        this->in.reset(this->endpoint->getFactory().createInConnector
+                       (this->endpoint->makeOptions
+                        (converter::converterRepository<string>()
+                         ->getConvertersForDeserialization())));
+        this->in->setScope(this->scope);
+        this->in->addHandler(HandlerPtr
+                             (new EventFunctionHandler
+                              (boost::bind(&LoadListener::handle, this, _1))));
+        this->in->activate();
+    }
+
+    void leave() {
+        this->in->deactivate();
+        this->in.reset();
+    }
+
+    EndpointPtr                              endpoint;
+    Scope                                    scope;
+    unsigned int                             churnIntervalMs;
+    Statistics&                              statistics;
+    InConnectorPtr                           in;
+
+    boost::mutex                             mutex;
+    map<rsc::misc::UUID, boost::uint32_t>    lastSequenceNumbers;
+};
+
+typedef boost::shared_ptr<LoadListener> LoadListenerPtr;
+
+struct Topology {
+    unsigned int                durationSeconds;
+    unsigned int                reportIntervalSeconds;
+    map<string, EndpointPtr>    endpoints;
+    vector<LoadListenerPtr>     listeners;
+    vector<LoadInformerPtr>     informers;
+};
+
+EndpointPtr findEndpoint(Topology& topology, const pt::ptree& spec) {
+    string name = spec.get<string>("bus", "default");
+    map<string, EndpointPtr>::const_iterator it = topology.endpoints.find(name);
+    if (it == topology.endpoints.end()) {
+        throw invalid_argument(boost::str(boost::format("Unknown bus '%1%'")
+                                          % name));
+    }
+    return it->second;
+}
+
+Scope instanceScope(const Scope& scope, unsigned int count, unsigned int index) {
+    if (count == 1) {
+        return scope;
+    }
+    return scope.concat(Scope(boost::str(boost::format("/%1%") % index)));
+}
+
+/**
+ * Reads the topology file @a fileName and creates its buses,
+ * listeners and informers in @a topology.
+ */
+void loadTopology(const string& fileName, Statistics& statistics,
+                  Topology& topology) {
+    pt::ptree tree;
+    pt::read_json(fileName, tree);
+
+    topology.durationSeconds       = tree.get<unsigned int>("duration", 60);
+    topology.reportIntervalSeconds = tree.get<unsigned int>("report-interval", 10);
+
+    topology.endpoints["default"].reset(new Endpoint(rsc::runtime::Properties()));
+    if (boost::optional<pt::ptree&> buses = tree.get_child_optional("buses")) {
+        for (pt::ptree::const_iterator it = buses->begin();
+             it != buses->end(); ++it) {
+            rsc::runtime::Properties options;
+            for (pt::ptree::const_iterator option = it->second.begin();
+                 option != it->second.end(); ++option) {
+                options[option->first] = option->second.data();
+            }
+            topology.endpoints[it->first].reset(new Endpoint(options));
+        }
+    }
+
+    // Listeners are created first such that they receive the first
+    // events.
+    if (boost::optional<pt::ptree&> listeners = tree.get_child_optional("listeners")) {
+        for (pt::ptree::const_iterator it = listeners->begin();
+             it != listeners->end(); ++it) {
+            const pt::ptree& spec = it->second;
+            EndpointPtr endpoint = findEndpoint(topology, spec);
+            Scope scope(spec.get<string>("scope"));
+            unsigned int count = spec.get<unsigned int>("count", 1);
+            unsigned int churnMs
+                = unsigned(spec.get<double>("churn-interval", 0) * 1000);
+            for (unsigned int i = 0; i < count; ++i) {
+                topology.listeners.push_back
+                    (LoadListenerPtr(new LoadListener(endpoint, scope, churnMs,
+                                                      statistics)));
+            }
+        }
+    }
+
+    if (boost::optional<pt::ptree&> informers = tree.get_child_optional("informers")) {
+        for (pt::ptree::const_iterator it = informers->begin();
+             it != informers->end(); ++it) {
+            const pt::ptree& spec = it->second;
+            EndpointPtr endpoint = findEndpoint(topology, spec);
+            Scope scope(spec.get<string>("scope"));
+            unsigned int count = spec.get<unsigned int>("count", 1);
+            double rate = spec.get<double>("rate", 100);
+            vector<unsigned int> sizes;
+            if (boost::optional<const pt::ptree&> sizeSpecs
+                = spec.get_child_optional("sizes")) {
+                for (pt::ptree::const_iterator size = sizeSpecs->begin();
+                     size != sizeSpecs->end(); ++size) {
+                    sizes.push_back(size->second.get_value<unsigned int>());
+                }
+            }
+            if (sizes.empty()) {
+                sizes.push_back(1024);
+            }
+            QualityOfServiceSpec qos
+                = parseQualityOfService(spec.get<string>("qos", "reliable"));
+            unsigned int newScopeMs
+                = unsigned(spec.get<double>("new-scope-interval", 0) * 1000);
+            for (unsigned int i = 0; i < count; ++i) {
+                topology.informers.push_back
+                    (LoadInformerPtr(new LoadInformer
+                                     (endpoint, instanceScope(scope, count, i),
+                                      rate, sizes, qos, newScopeMs,
+                                      statistics)));
+            }
+        }
+    }
+}
+
+boost::uint64_t receiveFailures(const Topology& topology) {
+    boost::uint64_t result = 0;
+    for (map<string, EndpointPtr>::const_iterator it
+             = topology.endpoints.begin(); it != topology.endpoints.end(); ++it) {
+        result += it->second->getReceiveFailures();
+    }
+    return result;
+}
+
+/**
+ * Returns an upper bound of the @a quantile quantile of the latency
+ * samples recorded between @a from and @a to.
+ */
+boost::uint64_t latencyQuantile(const Statistics::Snapshot& from,
+                                const Statistics::Snapshot& to,
+                                double                      quantile) {
+    boost::uint64_t total = to.received - from.received;
+    if (total == 0) {
+        return 0;
+    }
+    boost::uint64_t rank = max<boost::uint64_t>(1, boost::uint64_t(quantile * total + 0.5));
+    boost::uint64_t seen = 0;
+    for (unsigned int i = 0; i < spread::Histogram::NUM_BUCKETS; ++i) {
+        seen += to.latencyBuckets[i] - from.latencyBuckets[i];
+        if (seen >= rank) {
+            return spread::Histogram::getBucketUpperBound(i);
+        }
+    }
+    return spread::Histogram::getBucketUpperBound(spread::Histogram::NUM_BUCKETS - 1);
+}
+
+/**
+ * Writes the rates and latencies between @a from and @a to as a JSON
+ * object.
+ */
+void writeInterval(ostream&                    stream,
+                   const Statistics::Snapshot& from,
+                   const Statistics::Snapshot& to,
+                   boost::uint64_t             receiveFailures) {
+    double seconds = (to.time - from.time) / 1e6;
+    stream << "{\"seconds\": " << seconds
+           << ", \"sent\": " << to.sent - from.sent
+           << ", \"sent_per_second\": " << (to.sent - from.sent) / seconds
+           << ", \"sent_megabytes_per_second\": "
+           << (to.sentBytes - from.sentBytes) / seconds / 1e6
+           << ", \"send_errors\": " << to.sendErrors - from.sendErrors
+           << ", \"received\": " << to.received - from.received
+           << ", \"received_per_second\": " << (to.received - from.received) / seconds
+           << ", \"lost\": " << to.lost - from.lost
+           << ", \"receive_failures\": " << receiveFailures
+           << ", \"latency_p50_us\": " << latencyQuantile(from, to, 0.5)
+           << ", \"latency_p90_us\": " << latencyQuantile(from, to, 0.9)
+           << ", \"latency_p99_us\": " << latencyQuantile(from, to, 0.99)
+           << ", \"latency_p999_us\": " << latencyQuantile(from, to, 0.999)
+           << "}";
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    try {
+        if (!parseOptions(argc, argv, options)) {
+            return EXIT_SUCCESS;
+        }
+    } catch (const exception& e) {
+        cerr << "Invalid commandline: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    converter::registerDefaultConverters();
+
+    Statistics statistics;
+    Topology topology;
+    try {
+        loadTopology(options.topologyFile, statistics, topology);
+    } catch (const exception& e) {
+        cerr << "Could not set up topology: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+    if (options.durationSeconds != 0) {
+        topology.durationSeconds = options.durationSeconds;
+    }
+
+    Statistics::Snapshot start = statistics.snapshot();
+    boost::uint64_t deadline = start.time + topology.durationSeconds * 1000000ull;
+
+    boost::thread_group threads;
+    for (vector<LoadListenerPtr>::const_iterator it = topology.listeners.begin();
+         it != topology.listeners.end(); ++it) {
+        threads.create_thread(boost::bind(&LoadListener::run, *it, deadline));
+    }
+    for (vector<LoadInformerPtr>::const_iterator it = topology.informers.begin();
+         it != topology.informers.end(); ++it) {
+        threads.create_thread(boost::bind(&LoadInformer::run, *it, deadline));
+    }
+
+    // Report each interval on standard error while the load is
+    // generated.
+    Statistics::Snapshot previous = start;
+    boost::uint64_t previousFailures = 0;
+    while (true) {
+        boost::uint64_t now = rsc::misc::currentTimeMicros();
+        boost::uint64_t next = min(deadline,
+                                   now + topology.reportIntervalSeconds * 1000000ull);
+        if (next > now) {
+            boost::this_thread::sleep(boost::posix_time::microseconds(next - now));
+        }
+        Statistics::Snapshot current = statistics.snapshot();
+        boost::uint64_t failures = receiveFailures(topology);
+        writeInterval(cerr, previous, current, failures - previousFailures);
+        cerr << endl;
+        previous = current;
+        previousFailures = failures;
+        if (next >= deadline) {
+            break;
+        }
+    }
+    threads.join_all();
+
+    Statistics::Snapshot end = statistics.snapshot();
+    if (options.output == "-") {
+        writeInterval(cout, start, end, receiveFailures(topology));
+        cout << endl;
+    } else {
+        ofstream stream(options.output.c_str());
+        writeInterval(stream, start, end, receiveFailures(topology));
+        stream << endl;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,184 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include <boost/bind.hpp>
+#include <boost/format.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+#include <boost/program_options.hpp>
+
+#include <rsc/misc/langutils.h>
+
+#include <rsb/Event.h>
+#include <rsb/Handler.h>
+#include <rsb/Scope.h>
+
+#include <rsb/converter/Repository.h>
+#include <rsb/converter/converters.h>
+
+#include <rsb/transport/spread/BusImpl.h>
+#include <rsb/transport/spread/InConnector.h>
+#include <rsb/transport/spread/ReplayConnection.h>
+
+using namespace std;
+
+using namespace rsb;
+using namespace rsb::transport::spread;
+
+namespace po = boost::program_options;
+
+// rsbspread-replay
+//
+// Feeds the received messages of a capture file, written by a
+// participant with the capturefile transport option, through a bus
+// without a Spread daemon. All messages pass through fragment
+// reassembly, deserialization and dispatch to a connector which
+// receives events on all scopes. This allows profiling these stages
+// and comparing changes on identical input.
+
+struct Options {
+    string       fileName;
+    bool         maxSpeed;
+    bool         lazyDeserialization;
+    unsigned int repetitions;
+};
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    po::options_description description("Allowed options");
+    description.add_options()
+        ("help,h", "Print this help and exit.")
+        ("file", po::value<string>(&options.fileName),
+         "The capture file to replay.")
+        ("max-speed", po::bool_switch(&options.maxSpeed),
+         "Replay messages as fast as possible instead of with the "
+         "delays between them at capture time.")
+        ("lazy-deserialization", po::bool_switch(&options.lazyDeserialization),
+         "Do not deserialize payloads of received events.")
+        ("repeat", po::value<unsigned int>(&options.repetitions)->default_value(1),
+         "Number of times the capture file should be replayed.");
+
+    po::positional_options_description positional;
+    positional.add("file", 1);
+
+    po::variables_map map;
+    po::store(po::command_line_parser(argc, argv)
+              .options(description).positional(positional).run(), map);
+    po::notify(map);
+
+    if (map.count("help") || !map.count("file")) {
+        cout << "Usage: " << argv[0] << " [OPTIONS] FILE" << endl << endl
+             << description << endl;
+        return false;
+    }
+    return true;
+}
+
+class EventCounter {
+public:
+    EventCounter() :
+        numEvents(0) {
+    }
+
+    void handle(EventPtr /*event*/) {
+        boost::mutex::scoped_lock lock(this->mutex);
+        ++this->numEvents;
+    }
+
+    boost::uint64_t getNumEvents() const {
+        boost::mutex::scoped_lock lock(this->mutex);
+        return this->numEvents;
+    }
+private:
+    mutable boost::mutex mutex;
+    boost::uint64_t      numEvents;
+};
+
+void replay(const Options& options, CaptureReaderPtr reader, unsigned int run) {
+    reader->rewind();
+    ReplayConnectionPtr connection(new ReplayConnection(reader, !options.maxSpeed));
+    BusPtr bus(BusImpl::create(connection));
+    bus->activate();
+
+    EventCounter counter;
+    boost::shared_ptr<InConnector> in
+        (new InConnector(converter::converterRepository<string>()
+                         ->getConvertersForDeserialization(),
+                         bus));
+    in->setScope(Scope("/"));
+    in->setLazyDeserialization(options.lazyDeserialization);
+    in->addHandler(HandlerPtr(new EventFunctionHandler
+                              (boost::bind(&EventCounter::handle, &counter, _1))));
+
+    in->activate();
+
+    boost::uint64_t start = rsc::misc::currentTimeMicros();
+    connection->start();
+    connection->waitFinished();
+    boost::uint64_t end = rsc::misc::currentTimeMicros();
+
+    in->deactivate();
+    bus->deactivate();
+
+    double seconds = (end - start) / 1e6;
+    cout << boost::format("run %1%: %2% messages, %3% events in %4$.3f s"
+                          " (%5$.0f messages/s, %6$.0f events/s)")
+        % run % connection->getNumReplayed() % counter.getNumEvents() % seconds
+        % (connection->getNumReplayed() / seconds)
+        % (counter.getNumEvents() / seconds)
+         << endl;
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    try {
+        if (!parseOptions(argc, argv, options)) {
+            return EXIT_SUCCESS;
+        }
+    } catch (const exception& e) {
+        cerr << "Invalid commandline: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    converter::registerDefaultConverters();
+
+    try {
+        CaptureReaderPtr reader(new CaptureReader(options.fileName));
+        for (unsigned int i = 0; i < options.repetitions; ++i) {
+            replay(options, reader, i + 1);
+        }
+    } catch (const exception& e) {
+        cerr << "Replay failed: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -32,6 +32,9 @@
 
 #include <rsb/protocol/ProtocolException.h>
 
+#include "Parity.h"
+#include "Tracepoints.h"
+
 using namespace boost;
 using namespace boost::posix_time;
 
@@ -41,14 +44,35 @@ namespace rsb {
 namespace transport {
 namespace spread {
 
+namespace {
+
+// Number of completed assemblies remembered by an AssemblyPool.
+const std::size_t MAX_COMPLETED_KEYS = 1024;
+
+}
+
 Assembly::Assembly(rsb::protocol::FragmentedNotificationPtr notification) :
     logger(rsc::logging::Logger::getLogger(boost::str(boost::format("rsb.transport.spread.Assembly[%1%]")
                                                       % notification->notification().event_id().sequence_number()))),
-    receivedParts(0), birthTime(microsec_clock::local_time()) {
+    receivedParts(0), dataSize(0), numRecovered(0),
+    eventId(notification->notification().event_id()),
+    birthTime(microsec_clock::local_time()), numNacks(0) {
     this->store.resize(notification->num_data_parts());
+    this->recovered.resize(notification->num_data_parts());
     add(notification);
 }
 
+Assembly::Assembly(ParityFragmentPtr parity) :
+    logger(rsc::logging::Logger::getLogger(boost::str(boost::format("rsb.transport.spread.Assembly[%1%]")
+                                                      % parity->eventId.sequence_number()))),
+    receivedParts(0), dataSize(0), numRecovered(0),
+    eventId(parity->eventId),
+    birthTime(microsec_clock::local_time()), numNacks(0) {
+    this->store.resize(parity->numDataParts);
+    this->recovered.resize(parity->numDataParts);
+    addParity(parity);
+}
+
 Assembly::~Assembly() {
 }
 
@@ -61,8 +85,13 @@ rsb::protocol::NotificationPtr Assembly::getCompleteNotification() const {
          rsc::misc::ParentSharedPtrDeleter
          < rsb::protocol::FragmentedNotification > (store[0]));
 
-    // Concatenate data parts
+    // Concatenate data parts into a buffer of the final size.
     std::string* resultData = notification->mutable_data();
+    std::string::size_type size = 0;
+    for (unsigned int i = 0; i < this->store.size(); ++i) {
+        size += store[i]->notification().data().size();
+    }
+    resultData->reserve(size);
     for (unsigned int i = 1; i < this->store.size(); ++i) {
         resultData->append(store[i]->notification().data());
     }
@@ -77,6 +106,13 @@ bool Assembly::add(rsb::protocol::FragmentedNotificationPtr fragment) {
     assert(fragment->num_data_parts() == this->store.size());
     //assert(!store[fragment->data_part()]);
 
+    // The fragment may have been rebuilt from a parity fragment
+    // before arriving late.
+    if (this->recovered[fragment->data_part()]) {
+        RSCTRACE(this->logger, "Discarding late fragment " << fragment->data_part());
+        return isComplete();
+    }
+
     if (this->store[fragment->data_part()]) {
         throw rsb::protocol::ProtocolException
             (boost::str(boost::format("Received fragment (%d/%d) of notification "
@@ -88,41 +124,168 @@ bool Assembly::add(rsb::protocol::FragmentedNotificationPtr fragment) {
     }
     this->store[fragment->data_part()] = fragment;
     ++this->receivedParts;
+    this->dataSize += fragment->notification().data().size();
+
+    if (!this->parity.empty()) {
+        maybeRecover(fragment->data_part() % this->parity.size());
+    }
     return isComplete();
 }
 
+bool Assembly::addParity(ParityFragmentPtr parity) {
+    RSCTRACE(this->logger,
+             "Adding parity fragment " << parity->parityIndex
+             << "/" << parity->numParityParts << " to assembly");
+
+    if ((parity->numDataParts != this->store.size())
+        || (!this->parity.empty()
+            && (parity->numParityParts != this->parity.size()))) {
+        throw rsb::protocol::ProtocolException
+            (boost::str(boost::format("Parity fragment for %d data and %d parity "
+                                      "fragments does not match assembly of %d "
+                                      "data fragments")
+                        % parity->numDataParts % parity->numParityParts
+                        % this->store.size()));
+    }
+
+    if (this->parity.empty()) {
+        this->parity.resize(parity->numParityParts);
+    }
+    // Parity fragments are discarded once used. Duplicates are
+    // harmless either way.
+    this->parity[parity->parityIndex] = parity;
+    maybeRecover(parity->parityIndex);
+    return isComplete();
+}
+
+void Assembly::maybeRecover(unsigned int group) {
+    ParityFragmentPtr parity = this->parity[group];
+    if (!parity) {
+        return;
+    }
+
+    unsigned int numMissing = 0;
+    unsigned int missing    = 0;
+    for (unsigned int i = group; i < this->store.size(); i += this->parity.size()) {
+        if (!this->store[i]) {
+            ++numMissing;
+            missing = i;
+        }
+    }
+    if (numMissing > 1) {
+        return;
+    }
+
+    this->parity[group].reset();
+    if (numMissing == 0) {
+        return;
+    }
+
+    RSCDEBUG(this->logger, "Rebuilding fragment " << missing
+             << " from parity fragment " << group);
+    rsb::protocol::FragmentedNotificationPtr fragment
+        = recoverFragment(*parity, this->store, missing);
+    RSBSPREAD_TRACE4(assembly_recovered, parity->eventId.sender_id().data(),
+                     parity->eventId.sequence_number(), missing,
+                     this->store.size());
+    this->store[missing]     = fragment;
+    this->recovered[missing] = true;
+    ++this->receivedParts;
+    ++this->numRecovered;
+    this->dataSize += fragment->notification().data().size();
+}
+
 bool Assembly::isComplete() const {
     return this->receivedParts == this->store.size();
 }
 
+const rsb::protocol::EventId& Assembly::getEventId() const {
+    return this->eventId;
+}
+
+void Assembly::setSenderGroup(const std::string& group) {
+    this->senderGroup = group;
+}
+
+const std::string& Assembly::getSenderGroup() const {
+    return this->senderGroup;
+}
+
+std::vector<boost::uint32_t> Assembly::getMissingParts() const {
+    std::vector<boost::uint32_t> result;
+    for (unsigned int i = 0; i < this->store.size(); ++i) {
+        if (!this->store[i]) {
+            result.push_back(i);
+        }
+    }
+    return result;
+}
+
+bool Assembly::nextNack(unsigned int delayMs, unsigned int maxNacks) {
+    if (this->numNacks >= maxNacks) {
+        return false;
+    }
+
+    ptime now = microsec_clock::local_time();
+    ptime since = (this->numNacks == 0) ? this->birthTime : this->lastNackTime;
+    if ((now - since).total_milliseconds() < delayMs) {
+        return false;
+    }
+
+    ++this->numNacks;
+    this->lastNackTime = now;
+    return true;
+}
+
+unsigned int Assembly::getNumParts() const {
+    return this->store.size();
+}
+
+unsigned int Assembly::getNumRecovered() const {
+    return this->numRecovered;
+}
+
 unsigned int Assembly::age() const {
     return (microsec_clock::local_time() - this->birthTime).total_seconds();
 }
 
+std::size_t Assembly::getDataSize() const {
+    return this->dataSize;
+}
+
 AssemblyPool::PruningTask::PruningTask(Pool&                   pool,
                                        boost::recursive_mutex& poolMutex,
+                                       PoolMetrics&            metrics,
                                        const unsigned&         ageS,
                                        const unsigned int&     pruningIntervalMs) :
     PeriodicTask(pruningIntervalMs),
     logger(rsc::logging::Logger::getLogger("rsb.transport.spread.AssemblyPool.PruningTask")),
-    pool(pool), poolMutex(poolMutex), maxAge(ageS) {
+    pool(pool), poolMutex(poolMutex), metrics(metrics), maxAge(ageS) {
 }
 
 void AssemblyPool::PruningTask::execute() {
     boost::recursive_mutex::scoped_lock lock(this->poolMutex);
 
     RSCDEBUG(this->logger, "Scanning for old assemblies");
+    unsigned int numExpired = 0;
     Pool::iterator it = this->pool.begin();
     while (it != this->pool.end()) {
         if (it->second->age() > maxAge) {
             RSCDEBUG(logger, "Pruning old assembly " << it->second);
+            // Keys start with the sender id.
+            RSBSPREAD_TRACE3(assembly_expired, it->first.data(),
+                             it->second->age(), it->second->getDataSize());
+            ++numExpired;
+            this->metrics.size->add(-1);
+            this->metrics.bytes->add(-boost::int64_t(it->second->getDataSize()));
+            this->metrics.expirations->increment();
             Pool::iterator temp = it++;
             this->pool.erase(temp); // FIXME returns next iterator in C++11
         } else {
             ++it;
         }
     }
-
+    RSBSPREAD_TRACE2(prune_done, numExpired, this->pool.size());
 }
 
 AssemblyPool::AssemblyPool(const unsigned int& ageS,
@@ -135,6 +298,7 @@ AssemblyPool::AssemblyPool(const unsigned int& ageS,
     if (pruningIntervalMs == 0) {
         throw std::domain_error("Pruning interval must not be 0");
     }
+    setMetrics(MetricsRegistryPtr(new MetricsRegistry()));
 }
 
 AssemblyPool::~AssemblyPool() {
@@ -152,7 +316,7 @@ void AssemblyPool::setPruning(bool prune) {
     if (!isPruning() && prune) {
         RSCDEBUG(this->logger, "Starting Assembly pruning");
         this->pruningTask.reset
-            (new PruningTask(this->pool, this->poolMutex,
+            (new PruningTask(this->pool, this->poolMutex, this->metrics,
                              this->pruningAgeS, this->pruningIntervalMs));
         this->executor.schedule(this->pruningTask);
     } else if (isPruning() && !prune) {
@@ -165,39 +329,141 @@ void AssemblyPool::setPruning(bool prune) {
 }
 
 rsb::protocol::NotificationPtr
-AssemblyPool::add(rsb::protocol::FragmentedNotificationPtr notification) {
+AssemblyPool::add(rsb::protocol::FragmentedNotificationPtr notification,
+                  const std::string&                       senderGroup) {
     boost::recursive_mutex::scoped_lock lock(this->poolMutex);
 
-    std::string key = notification->notification().event_id().sender_id();
-    boost::uint64_t sequenceNumber
-      = notification->notification().event_id().sequence_number();
-    key.push_back((sequenceNumber & 0x000000ff) >> 0);
-    key.push_back((sequenceNumber & 0x0000ff00) >> 8);
-    key.push_back((sequenceNumber & 0x00ff0000) >> 16);
-    key.push_back((sequenceNumber & 0xff000000) >> 24);
+    const rsb::protocol::EventId& eventId = notification->notification().event_id();
+    std::string key = notificationKey(eventId);
+    boost::uint64_t sequenceNumber = eventId.sequence_number();
+    if (this->completedKeys.count(key)) {
+        RSCTRACE(this->logger,
+                 "Discarding fragment of completed notification " << sequenceNumber);
+        RSBSPREAD_TRACE4(assembly_duplicate, eventId.sender_id().data(),
+                         sequenceNumber, notification->data_part(),
+                         notification->num_data_parts());
+        this->metrics.duplicates->increment();
+        return rsb::protocol::NotificationPtr();
+    }
+
     Pool::iterator it = this->pool.find(key);
-    rsb::protocol::NotificationPtr result;
-    AssemblyPtr assembly;
     if (it != this->pool.end()) {
         // Push message to existing Assembly
-        assembly = it->second;
+        AssemblyPtr assembly = it->second;
         RSCTRACE(this->logger,
-                "Adding notification "
-                 << notification->notification().event_id().sequence_number()
+                "Adding notification " << sequenceNumber
                  << " to existing assembly " << assembly);
-        assembly->add(notification);
+        std::size_t  previousDataSize     = assembly->getDataSize();
+        unsigned int previousNumRecovered = assembly->getNumRecovered();
+        try {
+            assembly->add(notification);
+        } catch (const rsb::protocol::ProtocolException&) {
+            RSBSPREAD_TRACE4(assembly_duplicate, eventId.sender_id().data(),
+                             sequenceNumber, notification->data_part(),
+                             notification->num_data_parts());
+            this->metrics.duplicates->increment();
+            throw;
+        }
+        return finishAdd(key, it, previousDataSize, previousNumRecovered);
     } else {
         // Create new Assembly
         RSCTRACE(this->logger,
-                "Creating new assembly for notification "
-                 << notification->notification().event_id().sequence_number());
-        assembly.reset(new Assembly(notification));
-        it = this->pool.insert(std::make_pair(key, assembly)).first;
+                "Creating new assembly for notification " << sequenceNumber);
+        RSBSPREAD_TRACE4(assembly_new, eventId.sender_id().data(),
+                         sequenceNumber, notification->data_part(),
+                         notification->num_data_parts());
+        it = this->pool.insert(std::make_pair
+                               (key, AssemblyPtr(new Assembly(notification)))).first;
+        it->second->setSenderGroup(senderGroup);
+        this->metrics.size->add(1);
+        return finishAdd(key, it, 0, 0);
+    }
+}
+
+rsb::protocol::NotificationPtr
+AssemblyPool::addParity(ParityFragmentPtr  parity,
+                        const std::string& senderGroup) {
+    boost::recursive_mutex::scoped_lock lock(this->poolMutex);
+
+    std::string key = notificationKey(parity->eventId);
+    if (this->completedKeys.count(key)) {
+        RSCTRACE(this->logger,
+                 "Discarding parity fragment of completed notification "
+                 << parity->eventId.sequence_number());
+        return rsb::protocol::NotificationPtr();
     }
 
+    Pool::iterator it = this->pool.find(key);
+    if (it != this->pool.end()) {
+        AssemblyPtr assembly = it->second;
+        std::size_t  previousDataSize     = assembly->getDataSize();
+        unsigned int previousNumRecovered = assembly->getNumRecovered();
+        assembly->addParity(parity);
+        return finishAdd(key, it, previousDataSize, previousNumRecovered);
+    } else {
+        RSCTRACE(this->logger,
+                 "Creating new assembly for parity fragment of notification "
+                 << parity->eventId.sequence_number());
+        it = this->pool.insert(std::make_pair
+                               (key, AssemblyPtr(new Assembly(parity)))).first;
+        it->second->setSenderGroup(senderGroup);
+        this->metrics.size->add(1);
+        return finishAdd(key, it, 0, 0);
+    }
+}
+
+void AssemblyPool::collectNacks(unsigned int              delayMs,
+                                unsigned int              maxNacks,
+                                std::vector<NackRequest>& requests) {
+    boost::recursive_mutex::scoped_lock lock(this->poolMutex);
+
+    for (Pool::iterator it = this->pool.begin(); it != this->pool.end(); ++it) {
+        Assembly& assembly = *it->second;
+        if (assembly.getSenderGroup().empty()
+            || !assembly.nextNack(delayMs, maxNacks)) {
+            continue;
+        }
+
+        NackRequest request;
+        request.senderGroup  = assembly.getSenderGroup();
+        request.eventId      = assembly.getEventId();
+        request.missingParts = assembly.getMissingParts();
+        requests.push_back(request);
+    }
+}
+
+rsb::protocol::NotificationPtr
+AssemblyPool::finishAdd(const std::string& key,
+                        Pool::iterator     it,
+                        std::size_t        previousDataSize,
+                        unsigned int       previousNumRecovered) {
+    AssemblyPtr assembly = it->second;
+    this->metrics.bytes->add(boost::int64_t(assembly->getDataSize())
+                             - boost::int64_t(previousDataSize));
+    this->metrics.recovered->increment(assembly->getNumRecovered()
+                                       - previousNumRecovered);
+
+    rsb::protocol::NotificationPtr result;
     if (assembly->isComplete()) {
         result = assembly->getCompleteNotification();
+        RSBSPREAD_TRACE4(assembly_complete,
+                         result->event_id().sender_id().data(),
+                         result->event_id().sequence_number(),
+                         assembly->getNumParts(), assembly->getDataSize());
         this->pool.erase(it);
+        this->metrics.size->add(-1);
+        this->metrics.bytes->add(-boost::int64_t(assembly->getDataSize()));
+
+        // Notifications consisting of a single fragment cannot
+        // receive further fragments.
+        if (assembly->getNumParts() > 1) {
+            this->completedKeys.insert(key);
+            this->completedOrder.push_back(key);
+            if (this->completedOrder.size() > MAX_COMPLETED_KEYS) {
+                this->completedKeys.erase(this->completedOrder.front());
+                this->completedOrder.pop_front();
+            }
+        }
     }
 
     RSCTRACE(this->logger, "dataPool size: " << this->pool.size());
@@ -205,6 +471,27 @@ AssemblyPool::add(rsb::protocol::FragmentedNotificationPtr notification) {
     return result;
 }
 
+void AssemblyPool::setMetrics(MetricsRegistryPtr metrics) {
+    boost::recursive_mutex::scoped_lock lock(this->poolMutex);
+
+    this->metricsRegistry = metrics;
+    this->metrics.size = &metrics->getGauge
+        ("rsb_spread_assembly_pool_size",
+         "Number of partially received fragmented notifications.");
+    this->metrics.bytes = &metrics->getGauge
+        ("rsb_spread_assembly_pool_bytes",
+         "Payload bytes of partially received fragmented notifications.");
+    this->metrics.expirations = &metrics->getCounter
+        ("rsb_spread_assembly_expirations_total",
+         "Incomplete fragmented notifications discarded due to their age.");
+    this->metrics.duplicates = &metrics->getCounter
+        ("rsb_spread_assembly_duplicate_fragments_total",
+         "Fragments which have been received more than once.");
+    this->metrics.recovered = &metrics->getCounter
+        ("rsb_spread_assembly_recovered_fragments_total",
+         "Lost fragments which have been rebuilt from parity fragments.");
+}
+
 }
 }
 }
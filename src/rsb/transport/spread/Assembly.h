@@ -29,6 +29,8 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <set>
+#include <deque>
 
 #include <boost/shared_ptr.hpp>
 #include <boost/thread/recursive_mutex.hpp>
@@ -41,6 +43,10 @@
 #include <rsb/protocol/Notification.h>
 #include <rsb/protocol/FragmentedNotification.h>
 
+#include "Metrics.h"
+#include "WireFormat.h"
+#include "Notifications.h"
+
 #include "rsb/transport/spread/rsbspreadexports.h"
 
 namespace rsb {
@@ -57,6 +63,13 @@ class RSBSPREAD_EXPORT Assembly {
 public:
 
     Assembly(rsb::protocol::FragmentedNotificationPtr n);
+
+    /**
+     * Creates an assembly for the notification to which the parity
+     * fragment @a parity belongs.
+     */
+    explicit Assembly(ParityFragmentPtr parity);
+
     ~Assembly();
 
     /**
@@ -77,8 +90,69 @@ public:
      */
     bool add(rsb::protocol::FragmentedNotificationPtr fragment);
 
+    /**
+     * Adds a parity fragment to this Assembly which is used to
+     * rebuild a missing fragment of its group once all other
+     * fragments of the group have been received. Duplicate parity
+     * fragments are ignored.
+     *
+     * @param parity parity fragment to add
+     * @return @c true if the assembly is now completed, else @c false
+     * @throw protocol::ProtocolException if the parity fragment does
+     *                                    not match the assembly
+     */
+    bool addParity(ParityFragmentPtr parity);
+
     bool isComplete() const;
 
+    /**
+     * Returns the number of fragments which have been rebuilt from
+     * parity fragments.
+     *
+     * @return number of rebuilt fragments
+     */
+    unsigned int getNumRecovered() const;
+
+    /**
+     * Returns the id of the event of the notification.
+     */
+    const rsb::protocol::EventId& getEventId() const;
+
+    /**
+     * Sets the private group of the Spread connection which sent
+     * the fragments.
+     */
+    void setSenderGroup(const std::string& group);
+
+    const std::string& getSenderGroup() const;
+
+    /**
+     * Returns the indices of the fragments which have not been
+     * received yet.
+     *
+     * @return indices of missing fragments in ascending order
+     */
+    std::vector<boost::uint32_t> getMissingParts() const;
+
+    /**
+     * Tells whether the missing fragments should be requested from
+     * the sender now and, if so, records the request.
+     *
+     * @param delayMs Minimum age of the assembly before the first
+     *                request and time between requests in
+     *                milliseconds.
+     * @param maxNacks Maximum number of requests.
+     * @return @c true if a request should be sent now.
+     */
+    bool nextNack(unsigned int delayMs, unsigned int maxNacks);
+
+    /**
+     * Returns the number of data fragments of the notification.
+     *
+     * @return number of data fragments
+     */
+    unsigned int getNumParts() const;
+
     /**
      * Age of the assembly as seconds. The age is the elapsed time since this
      * instance was created.
@@ -87,13 +161,36 @@ public:
      */
     unsigned int age() const;
 
+    /**
+     * Returns the number of payload bytes in the fragments received
+     * so far.
+     *
+     * @return size in bytes
+     */
+    std::size_t getDataSize() const;
+
 private:
     rsc::logging::LoggerPtr                               logger;
 
     unsigned int                                          receivedParts;
+    std::size_t                                           dataSize;
     std::vector<rsb::protocol::FragmentedNotificationPtr> store;
 
+    // Parity fragments which have not been used yet, indexed by
+    // parity group, and flags for rebuilt fragments.
+    std::vector<ParityFragmentPtr>                        parity;
+    std::vector<bool>                                     recovered;
+    unsigned int                                          numRecovered;
+
+    rsb::protocol::EventId                                eventId;
+    std::string                                           senderGroup;
+
     boost::posix_time::ptime                              birthTime;
+
+    unsigned int                                          numNacks;
+    boost::posix_time::ptime                              lastNackTime;
+
+    void maybeRecover(unsigned int group);
 };
 
 typedef boost::shared_ptr<Assembly> AssemblyPtr;
@@ -153,16 +250,73 @@ public:
      *                                    times
      */
     rsb::protocol::NotificationPtr add(
-            rsb::protocol::FragmentedNotificationPtr notification);
+            rsb::protocol::FragmentedNotificationPtr notification,
+            const std::string& senderGroup = "");
+
+    /**
+     * Adds a parity fragment to the pool which may complete the
+     * assembly of its notification. Parity fragments for recently
+     * completed notifications are discarded.
+     *
+     * @param parity parity fragment to add to the pool
+     * @return if a joined message is ready, the notification is
+     *         returned, else a 0 pointer
+     * @throw protocol::ProtocolException if the parity fragment does
+     *                                    not match the assembly
+     */
+    rsb::protocol::NotificationPtr addParity(ParityFragmentPtr parity,
+                                             const std::string& senderGroup = "");
+
+    /**
+     * A request for retransmitting missing fragments.
+     */
+    struct NackRequest {
+        std::string                  senderGroup;
+        rsb::protocol::EventId       eventId;
+        std::vector<boost::uint32_t> missingParts;
+    };
+
+    /**
+     * Collects requests for the missing fragments of assemblies
+     * which are due according to @ref Assembly::nextNack. Assemblies
+     * without sender group are skipped.
+     *
+     * @param delayMs See @ref Assembly::nextNack.
+     * @param maxNacks See @ref Assembly::nextNack.
+     * @param requests Receives the requests.
+     */
+    void collectNacks(unsigned int              delayMs,
+                      unsigned int              maxNacks,
+                      std::vector<NackRequest>& requests);
+
+    /**
+     * Makes the pool report its size, the number of buffered bytes,
+     * pruned assemblies, duplicate fragments and fragments rebuilt
+     * from parity fragments in @a metrics. Must
+     * be called before fragments are added.
+     *
+     * @param metrics The registry in which metrics should be
+     *                recorded.
+     */
+    void setMetrics(MetricsRegistryPtr metrics);
 
 private:
     typedef std::map<std::string, boost::shared_ptr<Assembly> > Pool;
 
+    struct PoolMetrics {
+        Gauge*   size;
+        Gauge*   bytes;
+        Counter* expirations;
+        Counter* duplicates;
+        Counter* recovered;
+    };
+
     class PruningTask: public rsc::threading::PeriodicTask {
     public:
 
         PruningTask(Pool&                   pool,
                     boost::recursive_mutex& poolMutex,
+                    PoolMetrics&            metrics,
                     const unsigned int&     ageS,
                     const unsigned int&     pruningIntervalMs);
 
@@ -173,6 +327,7 @@ private:
 
         Pool&                   pool;
         boost::recursive_mutex& poolMutex;
+        PoolMetrics&            metrics;
         unsigned int            maxAge;
     };
 
@@ -181,12 +336,32 @@ private:
     Pool                   pool;
     boost::recursive_mutex poolMutex;
 
+    // Keys of the most recently completed assemblies. Fragments for
+    // these, such as unneeded parity fragments, are discarded instead
+    // of starting a new assembly which would never complete.
+    std::set<std::string>   completedKeys;
+    std::deque<std::string> completedOrder;
+
+    MetricsRegistryPtr     metricsRegistry;
+    PoolMetrics            metrics;
+
     const unsigned int pruningAgeS;
     const unsigned int pruningIntervalMs;
 
     rsc::threading::ThreadedTaskExecutor executor;
     mutable boost::recursive_mutex       pruningMutex;
     rsc::threading::TaskPtr              pruningTask;
+
+    /**
+     * Updates metrics after adding a fragment to the assembly at
+     * @a it and removes the assembly if it is complete.
+     *
+     * @return The complete notification or a 0 pointer.
+     */
+    rsb::protocol::NotificationPtr finishAdd(const std::string& key,
+                                             Pool::iterator     it,
+                                             std::size_t        previousDataSize,
+                                             unsigned int       previousNumRecovered);
 };
 
 typedef boost::shared_ptr<AssemblyPool> AssemblyPoolPtr;
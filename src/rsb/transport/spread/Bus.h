@@ -29,6 +29,7 @@
 #include <boost/shared_ptr.hpp>
 
 #include "ReceiverTask.h"
+#include "Metrics.h"
 
 #include "rsb/transport/spread/rsbspreadexports.h"
 
@@ -72,6 +73,20 @@ public:
     virtual void removeSink(const Scope& scope, const Sink* sink) = 0;
 
     virtual void handleOutgoingNotification(OutgoingNotificationPtr notification) = 0;
+
+    /**
+     * Returns the registry in which the bus and its connectors
+     * record metrics.
+     *
+     * @return The registry. May be shared with other buses.
+     */
+    virtual MetricsRegistryPtr getMetrics() const = 0;
+
+    /**
+     * Tells whether metrics recorded for notifications of the bus
+     * and its connectors are labeled with scopes.
+     */
+    virtual bool getScopeMetrics() const = 0;
 };
 
 }
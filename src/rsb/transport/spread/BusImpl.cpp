@@ -27,13 +27,30 @@
 
 #include "BusImpl.h"
 
+#include <algorithm>
+#include <map>
+
 #include <boost/format.hpp>
+#include <boost/functional/hash.hpp>
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/thread.hpp>
 
 #include <rsc/misc/IllegalStateException.h>
+#include <rsc/misc/langutils.h>
+
+#include <rsc/threading/PeriodicTask.h>
+#include <rsc/threading/RepetitiveTask.h>
+
+#include <rsb/CommException.h>
 
 #include <rsb/protocol/ProtocolException.h>
 
 #include "GroupNameCache.h"
+#include "WireFormat.h"
+#include "Parity.h"
+#include "Tracepoints.h"
 
 namespace rsb {
 namespace transport {
@@ -64,6 +81,13 @@ public:
         }
     }
 
+    void handleControlMessage(const SpreadMessage& message) {
+        BusPtr bus = this->bus.lock();
+        if (bus) {
+            bus->handleControlMessage(message);
+        }
+    }
+
     void handleError(const std::exception& error) {
         BusPtr bus = this->bus.lock();
         if (bus) {
@@ -74,19 +98,260 @@ public:
 
 typedef boost::shared_ptr<WeakHandlerAdapter> WeakHandlerAdapterPtr;
 
+// BusTask
+//
+// Base of the tasks which act on a bus without keeping it alive.
+// While executing, such a task holds a reference to the bus. If that
+// reference is the last one, the bus is destroyed in the thread of
+// the task and must not wait for the task to finish.
+
+class BusTask {
+public:
+    virtual ~BusTask() {
+    }
+
+    bool isExecutingThread() const {
+        boost::mutex::scoped_lock lock(this->threadMutex);
+        return this->thread == boost::this_thread::get_id();
+    }
+protected:
+    BusTask(boost::shared_ptr<BusImpl> bus) :
+        bus(bus) {
+    }
+
+    // Records the executing thread and returns the bus, if it still
+    // exists.
+    boost::shared_ptr<BusImpl> lockBus() {
+        {
+            boost::mutex::scoped_lock lock(this->threadMutex);
+            this->thread = boost::this_thread::get_id();
+        }
+        return this->bus.lock();
+    }
+private:
+    boost::weak_ptr<BusImpl> bus;
+
+    mutable boost::mutex     threadMutex;
+    boost::thread::id        thread;
+};
+
+// Cancels @a task and waits until it is done unless called from the
+// thread of @a task, which is the case if the task has released the
+// last reference to the bus.
+void stopTask(rsc::threading::TaskPtr task) {
+    task->cancel();
+    boost::shared_ptr<BusTask> busTask
+        = boost::dynamic_pointer_cast<BusTask>(task);
+    if (!busTask || !busTask->isExecutingThread()) {
+        task->waitDone();
+    }
+}
+
+// ClockSyncTask
+//
+// Periodically sends clock synchronization requests without keeping
+// the bus alive.
+
+class ClockSyncTask : public rsc::threading::PeriodicTask, public BusTask {
+public:
+    ClockSyncTask(boost::shared_ptr<BusImpl> bus, unsigned int intervalMs) :
+        rsc::threading::PeriodicTask(intervalMs), BusTask(bus) {
+    }
+
+    void execute() {
+        boost::shared_ptr<BusImpl> bus = lockBus();
+        if (bus) {
+            bus->sendClockPings();
+        }
+    }
+};
+
+// NackTask
+//
+// Periodically requests missing fragments without keeping the bus
+// alive.
+
+class NackTask : public rsc::threading::PeriodicTask, public BusTask {
+public:
+    NackTask(boost::shared_ptr<BusImpl> bus, unsigned int intervalMs) :
+        rsc::threading::PeriodicTask(intervalMs), BusTask(bus) {
+    }
+
+    void execute() {
+        boost::shared_ptr<BusImpl> bus = lockBus();
+        if (bus) {
+            bus->sendNacks();
+        }
+    }
+};
+
+/**
+ * The delay after the first failed attempt at reconnecting in
+ * milliseconds.
+ */
+const unsigned int INITIAL_RECONNECT_DELAY = 100;
+
+// ReconnectTask
+//
+// Attempts to reestablish the connections of the bus until
+// successful, doubling the delay between attempts up to a
+// maximum. Does not keep the bus alive while waiting.
+
+class ReconnectTask : public rsc::threading::RepetitiveTask, public BusTask {
+public:
+    ReconnectTask(boost::shared_ptr<BusImpl> bus, unsigned int maxDelayMs) :
+        BusTask(bus),
+        delayMs(std::min(INITIAL_RECONNECT_DELAY, maxDelayMs)),
+        maxDelayMs(maxDelayMs), cancelled(false) {
+    }
+
+    void execute() {
+        {
+            boost::shared_ptr<BusImpl> bus = lockBus();
+            if (!bus || bus->reconnect()) {
+                cancel();
+                return;
+            }
+        }
+
+        {
+            boost::mutex::scoped_lock lock(this->mutex);
+            if (!this->cancelled) {
+                this->condition.timed_wait
+                    (lock, boost::posix_time::milliseconds(this->delayMs));
+            }
+        }
+        this->delayMs = std::min(2 * this->delayMs, this->maxDelayMs);
+    }
+
+    void cancel() {
+        {
+            boost::mutex::scoped_lock lock(this->mutex);
+            this->cancelled = true;
+        }
+        this->condition.notify_all();
+        rsc::threading::RepetitiveTask::cancel();
+    }
+private:
+    unsigned int              delayMs;
+    unsigned int              maxDelayMs;
+
+    boost::mutex              mutex;
+    boost::condition_variable condition;
+    bool                      cancelled;
+};
+
+/**
+ * The maximum number of requests for the missing fragments of a
+ * single notification.
+ */
+const unsigned int MAX_NACKS_PER_NOTIFICATION = 3;
+
+/**
+ * Stores fragment @a index of @a notification in its wire format in
+ * @a output.
+ */
+void encodeFragment(OutgoingNotification& notification,
+                    std::size_t           index,
+                    std::string&          output) {
+    rsb::protocol::FragmentedNotification& fragment
+        = notification.fragments[index];
+    if (notification.compactFragments && (index > 0)) {
+        encodeContinuationFragment
+            (notification.fragments[0].notification().event_id(),
+             fragment.data_part(), fragment.num_data_parts(),
+             fragment.notification().data(), output);
+    } else if (!fragment.SerializeToString(&output)) {
+        throw rsb::protocol::ProtocolException("Failed to write notification to stream");
+    }
+}
+
+/**
+ * Merges requests in @a requests which concern the same notification
+ * of the same sender and removes duplicate part indices, such that
+ * each missing fragment is requested, and retransmitted, only once.
+ */
+void mergeNackRequests(std::vector<AssemblyPool::NackRequest>& requests) {
+    std::vector<AssemblyPool::NackRequest> merged;
+    std::map<std::string, std::size_t> indices;
+    for (std::vector<AssemblyPool::NackRequest>::const_iterator it
+             = requests.begin(); it != requests.end(); ++it) {
+        std::string key = it->senderGroup + '\0' + notificationKey(it->eventId);
+        std::map<std::string, std::size_t>::const_iterator indexIt
+            = indices.find(key);
+        if (indexIt == indices.end()) {
+            indices[key] = merged.size();
+            merged.push_back(*it);
+        } else {
+            std::vector<boost::uint32_t>& parts
+                = merged[indexIt->second].missingParts;
+            parts.insert(parts.end(),
+                         it->missingParts.begin(), it->missingParts.end());
+        }
+    }
+
+    for (std::vector<AssemblyPool::NackRequest>::iterator it = merged.begin();
+         it != merged.end(); ++it) {
+        std::sort(it->missingParts.begin(), it->missingParts.end());
+        it->missingParts.erase(std::unique(it->missingParts.begin(),
+                                           it->missingParts.end()),
+                               it->missingParts.end());
+    }
+    requests.swap(merged);
+}
+
 }
 
 /// BusImpl
 
-BusPtr BusImpl::create(SpreadConnectionPtr connection) {
-    return BusPtr(new BusImpl(connection));
+BusPtr BusImpl::create(ConnectionPtr connection) {
+    return BusPtr(new BusImpl(connection, std::vector<ConnectionPtr>(),
+                              MetricsRegistryPtr(new MetricsRegistry())));
+}
+
+BusPtr BusImpl::create(ConnectionPtr                     connection,
+                       const std::vector<ConnectionPtr>& sendConnections) {
+    return BusPtr(new BusImpl(connection, sendConnections,
+                              MetricsRegistryPtr(new MetricsRegistry())));
+}
+
+BusPtr BusImpl::create(ConnectionPtr                     connection,
+                       const std::vector<ConnectionPtr>& sendConnections,
+                       MetricsRegistryPtr                metrics) {
+    return BusPtr(new BusImpl(connection, sendConnections, metrics));
 }
 
-BusImpl::BusImpl(SpreadConnectionPtr connection) :
+BusImpl::BusImpl(ConnectionPtr                     connection,
+                 const std::vector<ConnectionPtr>& sendConnections,
+                 MetricsRegistryPtr                metrics) :
     logger(rsc::logging::Logger::getLogger("rsb.transport.spread.Bus")),
     active(false),
-    connection(connection), memberships(connection),
-    executor(new rsc::threading::ThreadedTaskExecutor()) {
+    connection(connection), sendConnections(sendConnections),
+    memberships(connection),
+    executor(new rsc::threading::ThreadedTaskExecutor()),
+    metrics(metrics),
+    multicastDuration(metrics->getHistogram
+                      ("rsb_spread_multicast_duration_microseconds",
+                       "Duration of calls sending a Spread message.")),
+    nacksSent(metrics->getCounter
+              ("rsb_spread_nacks_sent_total",
+               "Requests for missing fragments sent to senders.")),
+    scopeMetrics(false),
+    clockSyncInterval(0),
+    clockPeers(metrics->getGauge
+               ("rsb_spread_clock_peers",
+                "Number of peers with a clock offset estimate.")),
+    maxClockOffset(metrics->getGauge
+                   ("rsb_spread_clock_offset_max_microseconds",
+                    "Largest absolute clock offset estimated for a peer.")),
+    maxClockRoundTrip(metrics->getGauge
+                      ("rsb_spread_clock_round_trip_max_microseconds",
+                       "Largest round-trip time of the exchanges the clock"
+                       " offsets are based on.")),
+    nackDelay(0),
+    maxReconnectDelay(0), maxBufferedNotifications(0),
+    reconnectAllowed(false) {
+    lookUpNotificationMetrics(MetricLabels(), this->notificationMetrics);
 }
 
 BusImpl::~BusImpl() {
@@ -99,7 +364,8 @@ BusImpl::~BusImpl() {
 void BusImpl::printContents(std::ostream& stream) const {
     stream << "connection = ";
     this->connection->printContents(stream);
-    stream << ", state = " << (this->active ? "" : "not ") << "active"
+    stream << ", send connections = " << this->sendConnections.size()
+           << ", state = " << (this->active ? "" : "not ") << "active"
            << ", sinks = " << this->scopeDispatcher.size();
 }
 
@@ -113,10 +379,31 @@ void BusImpl::activate() {
     }
 
     this->connection->activate();
+    for (std::vector<ConnectionPtr>::const_iterator it
+             = this->sendConnections.begin();
+         it != this->sendConnections.end(); ++it) {
+        (*it)->activate();
+    }
 
-    WeakHandlerAdapterPtr handler(new WeakHandlerAdapter(shared_from_this()));
-    this->receiver.reset(new ReceiverTask(this->connection, handler));
-    this->executor->schedule(this->receiver);
+    startReceivers();
+
+    if (this->clockSyncInterval > 0) {
+        this->clockSyncTask.reset
+            (new ClockSyncTask(shared_from_this(), this->clockSyncInterval));
+        this->executor->schedule(this->clockSyncTask);
+    }
+
+    if (this->nackDelay > 0) {
+        this->nackTask.reset
+            (new NackTask(shared_from_this(),
+                          std::max(this->nackDelay / 2, 1u)));
+        this->executor->schedule(this->nackTask);
+    }
+
+    {
+        boost::mutex::scoped_lock lock(this->reconnectMutex);
+        this->reconnectAllowed = true;
+    }
 
     this->active = true;
 }
@@ -126,11 +413,47 @@ void BusImpl::deactivate() {
         throw rsc::misc::IllegalStateException("Bus is not active");
     }
 
-    this->receiver->cancel();
-    this->connection->interruptReceive();
-    this->receiver->waitDone();
+    // Stop reconnecting first since a reconnect attempt restarts the
+    // receivers.
+    rsc::threading::TaskPtr reconnectTask;
+    {
+        boost::mutex::scoped_lock lock(this->reconnectMutex);
+        this->reconnectAllowed = false;
+        reconnectTask.swap(this->reconnectTask);
+        this->bufferedNotifications.clear();
+    }
+    if (reconnectTask) {
+        stopTask(reconnectTask);
+    }
 
-    this->connection->deactivate();
+    if (this->clockSyncTask) {
+        stopTask(this->clockSyncTask);
+        this->clockSyncTask.reset();
+    }
+
+    if (this->nackTask) {
+        stopTask(this->nackTask);
+        this->nackTask.reset();
+    }
+
+    stopReceivers();
+
+    {
+        boost::unique_lock<boost::shared_mutex> lock(this->connectionMutex);
+
+        // A connection may be inactive after a failed reconnect
+        // attempt.
+        if (this->connection->isActive()) {
+            this->connection->deactivate();
+        }
+        for (std::vector<ConnectionPtr>::const_iterator it
+                 = this->sendConnections.begin();
+             it != this->sendConnections.end(); ++it) {
+            if ((*it)->isActive()) {
+                (*it)->deactivate();
+            }
+        }
+    }
 
     this->active = false;
 }
@@ -147,6 +470,8 @@ void BusImpl::addSink(const Scope& scope, SinkPtr sink) {
 
         this->scopeDispatcher.addSink(scope, sink);
     }
+
+    updateSequenceTracking();
 }
 
 void BusImpl::removeSink(const Scope& scope, const Sink* sink) {
@@ -161,6 +486,21 @@ void BusImpl::removeSink(const Scope& scope, const Sink* sink) {
 
         this->memberships.leave(GroupNameCache::scopeToGroup(scope));
     }
+
+    updateSequenceTracking();
+}
+
+bool BusImpl::receivesAllNotifications() const {
+    return this->memberships.isMember(GroupNameCache::scopeToGroup(Scope("/")));
+}
+
+void BusImpl::updateSequenceTracking() {
+    // Lock in the same order as reconnect.
+    boost::shared_lock<boost::shared_mutex> lock(this->connectionMutex);
+    boost::mutex::scoped_lock sinkLock(this->sinkMutex);
+    if (this->receiver) {
+        this->receiver->setTrackSequenceNumbers(receivesAllNotifications());
+    }
 }
 
 namespace {
@@ -183,14 +523,48 @@ void BusImpl::handleOutgoingNotification(OutgoingNotificationPtr notification) {
                                           "notification %2%, scope = %3%")
                             % *this % notification % notification->scope));
 
-    sendNotification(notification);
+    {
+        // Reconnecting holds connectionMutex exclusively while
+        // connecting to the daemon, which can take a long time. In
+        // the meantime, notifications are buffered instead.
+        boost::shared_lock<boost::shared_mutex> lock(this->connectionMutex,
+                                                     boost::try_to_lock);
+        if (!lock.owns_lock() && !bufferWhileReconnecting(notification)) {
+            lock.lock();
+        }
 
+        if (lock.owns_lock()) {
+            std::size_t nextFragment = 0;
+            try {
+                sendNotification(notification, nextFragment);
+            } catch (const CommException& e) {
+                if (!bufferNotification(notification, nextFragment)) {
+                    throw;
+                }
+            } catch (const rsc::misc::IllegalStateException& e) {
+                // The connection is inactive between reconnect
+                // attempts.
+                if (!bufferNotification(notification, nextFragment)) {
+                    throw;
+                }
+            }
+        }
+    }
+
+    RSBSPREAD_TRACE4(dispatch_start, notification->notification->scope().c_str(),
+                     notification->notification->event_id().sender_id().data(),
+                     notification->notification->event_id().sequence_number(),
+                     1);
     {
         boost::mutex::scoped_lock lock(this->sinkMutex);
 
         this->scopeDispatcher.mapSinks(notification->scope,
                                        PoorPersonsLambda1(notification));
     }
+    RSBSPREAD_TRACE4(dispatch_done, notification->notification->scope().c_str(),
+                     notification->notification->event_id().sender_id().data(),
+                     notification->notification->event_id().sequence_number(),
+                     1);
 }
 
 namespace {
@@ -213,12 +587,33 @@ void BusImpl::handleIncomingNotification(IncomingNotificationPtr notification) {
                                           "notification %2%, scope = %3%")
                             % *this % notification % notification->scope));
 
+    const NotificationMetrics& metrics = metricsForScope(notification->scope);
+    metrics.notificationsReceived->increment();
+    metrics.payloadBytesReceived->increment
+        (notification->serializedPayload.size());
+
+    if ((this->clockSyncInterval > 0) && !notification->sender.empty()) {
+        this->clockSync.observeSender(notification->sender);
+        ClockSync::PeerClock clock;
+        if (this->clockSync.getPeerClock(notification->sender, clock)) {
+            notification->clockOffset = clock.offset;
+        }
+    }
+
+    RSBSPREAD_TRACE4(dispatch_start, notification->notification->scope().c_str(),
+                     notification->notification->event_id().sender_id().data(),
+                     notification->notification->event_id().sequence_number(),
+                     0);
     {
         boost::mutex::scoped_lock lock(this->sinkMutex);
 
         this->scopeDispatcher.mapSinks(notification->scope,
                                        PoorPersonsLambda2(notification));
     }
+    RSBSPREAD_TRACE4(dispatch_done, notification->notification->scope().c_str(),
+                     notification->notification->event_id().sender_id().data(),
+                     notification->notification->event_id().sequence_number(),
+                     0);
 }
 
 namespace {
@@ -237,19 +632,420 @@ struct PoorPersonsLambda3 {
 }
 
 void BusImpl::handleError(const std::exception& error) {
+    {
+        boost::mutex::scoped_lock lock(this->reconnectMutex);
+
+        if (this->maxReconnectDelay > 0) {
+            if (this->reconnectAllowed) {
+                RSCWARN(this->logger, "Lost connection to the Spread daemon: "
+                        << error.what() << "; reconnecting");
+                scheduleReconnect();
+            }
+            return;
+        }
+    }
+
     boost::mutex::scoped_lock lock(this->sinkMutex);
 
     this->scopeDispatcher.mapAllSinks(PoorPersonsLambda3(error));
 }
 
+void BusImpl::handleControlMessage(const SpreadMessage& message) {
+    const std::string& data = message.getData();
+    boost::uint64_t receiveTime = rsc::misc::currentTimeMicros();
+    boost::uint64_t requestSendTime, requestReceiveTime, replySendTime;
+
+    if (decodeClockPing(data, requestSendTime)) {
+        std::string reply;
+        encodeClockPong(requestSendTime, receiveTime,
+                        rsc::misc::currentTimeMicros(), reply);
+        sendControlMessage(message.getSender(), reply);
+    } else if (decodeClockPong(data, requestSendTime, requestReceiveTime,
+                               replySendTime)) {
+        if (!this->clockSync.addSample(message.getSender(),
+                                       requestSendTime, requestReceiveTime,
+                                       replySendTime, receiveTime)) {
+            RSCDEBUG(this->logger, "Ignoring clock answer from unknown peer "
+                     << message.getSender());
+        }
+    } else if (compactMessageKind(data) == COMPACT_NACK) {
+        retransmitFragments(message);
+    } else {
+        RSCDEBUG(this->logger, "Ignoring unsupported control message from "
+                 << message.getSender());
+    }
+}
+
+MetricsRegistryPtr BusImpl::getMetrics() const {
+    return this->metrics;
+}
+
+void BusImpl::setScopeMetrics(bool scopeMetrics) {
+    this->scopeMetrics = scopeMetrics;
+}
+
+bool BusImpl::getScopeMetrics() const {
+    return this->scopeMetrics;
+}
+
+void BusImpl::lookUpNotificationMetrics(const MetricLabels&  labels,
+                                        NotificationMetrics& result) {
+    result.notificationsReceived = &this->metrics->getCounter
+        ("rsb_spread_notifications_received_total",
+         "Complete notifications received.", labels);
+    result.payloadBytesReceived = &this->metrics->getCounter
+        ("rsb_spread_payload_bytes_received_total",
+         "Payload bytes of received notifications.", labels);
+
+    const SpreadMessage::QOS levels[NUM_QOS_LEVELS] = {
+        SpreadMessage::UNRELIABLE, SpreadMessage::RELIABLE,
+        SpreadMessage::FIFO, SpreadMessage::CAUSAL,
+        SpreadMessage::AGREED, SpreadMessage::SAFE
+    };
+    for (unsigned int i = 0; i < NUM_QOS_LEVELS; ++i) {
+        MetricLabels qosLabels(labels);
+        qosLabels.add("qos", qosName(levels[i]));
+        result.messagesSent[qosIndex(levels[i])] = &this->metrics->getCounter
+            ("rsb_spread_messages_sent_total", "Spread messages sent.",
+             qosLabels);
+        result.bytesSent[qosIndex(levels[i])] = &this->metrics->getCounter
+            ("rsb_spread_bytes_sent_total", "Bytes of sent Spread messages.",
+             qosLabels);
+    }
+
+    result.fragmentsPerNotification = &this->metrics->getHistogram
+        ("rsb_spread_fragments_per_notification",
+         "Number of Spread messages required for sending a notification.",
+         labels);
+    result.fragmentsRetransmitted = &this->metrics->getCounter
+        ("rsb_spread_fragments_retransmitted_total",
+         "Fragments sent again upon request of a receiver.", labels);
+}
+
+const BusImpl::NotificationMetrics& BusImpl::metricsForScope(const Scope& scope) {
+    if (!this->scopeMetrics) {
+        return this->notificationMetrics;
+    }
+
+    const std::string& name = scope.toString();
+    boost::mutex::scoped_lock lock(this->scopeMetricsMutex);
+    ScopeMetricsMap::iterator it = this->scopeMetricsMap.find(name);
+    if (it == this->scopeMetricsMap.end()) {
+        NotificationMetrics metrics;
+        lookUpNotificationMetrics(MetricLabels().add("scope", name), metrics);
+        it = this->scopeMetricsMap.insert(std::make_pair(name, metrics)).first;
+    }
+    return it->second;
+}
+
+void BusImpl::setClockSyncInterval(unsigned int intervalMs) {
+    this->clockSyncInterval = intervalMs;
+}
+
+const ClockSync& BusImpl::getClockSync() const {
+    return this->clockSync;
+}
+
+void BusImpl::sendClockPings() {
+    std::vector<std::string> targets = this->clockSync.getPingTargets();
+    for (std::vector<std::string>::const_iterator it = targets.begin();
+         it != targets.end(); ++it) {
+        std::string request;
+        encodeClockPing(rsc::misc::currentTimeMicros(), request);
+        sendControlMessage(*it, request);
+    }
+
+    // Peers dropped by the clock synchronization no longer
+    // contribute to the gauges.
+    ClockSync::PeerClockMap clocks = this->clockSync.getPeerClocks();
+    boost::int64_t  maxOffset    = 0;
+    boost::uint64_t maxRoundTrip = 0;
+    for (ClockSync::PeerClockMap::const_iterator it = clocks.begin();
+         it != clocks.end(); ++it) {
+        maxOffset    = std::max(maxOffset, (it->second.offset < 0)
+                                ? -it->second.offset : it->second.offset);
+        maxRoundTrip = std::max(maxRoundTrip, it->second.roundTripTime);
+    }
+    this->clockPeers.set(clocks.size());
+    this->maxClockOffset.set(maxOffset);
+    this->maxClockRoundTrip.set(maxRoundTrip);
+}
+
+void BusImpl::setNackDelay(unsigned int delayMs) {
+    this->nackDelay = delayMs;
+}
+
+void BusImpl::sendNacks() {
+    boost::shared_ptr<ReceiverTask> receiver;
+    {
+        boost::shared_lock<boost::shared_mutex> lock(this->connectionMutex);
+        receiver = this->receiver;
+    }
+    if (!receiver) {
+        return;
+    }
+
+    std::vector<AssemblyPool::NackRequest> requests;
+    receiver->collectNacks(this->nackDelay, MAX_NACKS_PER_NOTIFICATION,
+                           requests);
+    mergeNackRequests(requests);
+    for (std::vector<AssemblyPool::NackRequest>::const_iterator it
+             = requests.begin(); it != requests.end(); ++it) {
+        RSCDEBUG(this->logger,
+                 (boost::format("Requesting %1% missing fragment(s) of "
+                                "sequence number %2% from %3%")
+                  % it->missingParts.size() % it->eventId.sequence_number()
+                  % it->senderGroup));
+        std::string request;
+        encodeNack(it->eventId, it->missingParts, request);
+        sendControlMessage(it->senderGroup, request);
+        this->nacksSent.increment();
+    }
+}
+
+void BusImpl::setReconnect(unsigned int maxDelayMs,
+                           unsigned int maxBufferedNotifications) {
+    this->maxReconnectDelay        = maxDelayMs;
+    this->maxBufferedNotifications = maxBufferedNotifications;
+}
+
+bool BusImpl::reconnect() {
+    // The receivers have to be stopped before blocking senders since
+    // handling control messages involves sending.
+    stopReceivers();
+
+    {
+        boost::unique_lock<boost::shared_mutex> lock(this->connectionMutex);
+
+        // Group changes are only recorded until the new connection
+        // is available.
+        {
+            boost::mutex::scoped_lock sinkLock(this->sinkMutex);
+            this->memberships.suspend();
+        }
+
+        std::vector<ConnectionPtr> connections(1, this->connection);
+        connections.insert(connections.end(),
+                           this->sendConnections.begin(),
+                           this->sendConnections.end());
+        for (std::vector<ConnectionPtr>::const_iterator it
+                 = connections.begin(); it != connections.end(); ++it) {
+            if (!(*it)->isActive()) {
+                continue;
+            }
+            try {
+                (*it)->deactivate();
+            } catch (const std::exception& e) {
+                RSCDEBUG(this->logger, "Ignoring error while closing "
+                         "failed connection: " << e.what());
+            }
+        }
+
+        try {
+            for (std::vector<ConnectionPtr>::const_iterator it
+                     = connections.begin(); it != connections.end(); ++it) {
+                (*it)->activate();
+            }
+
+            boost::mutex::scoped_lock sinkLock(this->sinkMutex);
+            this->memberships.rejoin();
+        } catch (const std::exception& e) {
+            RSCWARN(this->logger, "Could not reconnect to the Spread daemon: "
+                    << e.what());
+            return false;
+        }
+
+        startReceivers();
+
+        RSCINFO(this->logger, "Reconnected to the Spread daemon");
+        this->metrics->getCounter
+            ("rsb_spread_reconnects_total",
+             "Connections to the Spread daemon reestablished after a failure.")
+            .increment();
+
+        // Senders keep buffering until the reconnect task is reset,
+        // such that buffered notifications are sent before newer
+        // ones.
+        while (true) {
+            std::deque<BufferedNotification> buffered;
+            {
+                boost::mutex::scoped_lock reconnectLock(this->reconnectMutex);
+                buffered.swap(this->bufferedNotifications);
+                if (buffered.empty()) {
+                    this->reconnectTask.reset();
+                    break;
+                }
+            }
+
+            RSCDEBUG(this->logger, "Sending " << buffered.size()
+                     << " buffered notification(s)");
+            for (std::deque<BufferedNotification>::iterator it
+                     = buffered.begin(); it != buffered.end(); ++it) {
+                try {
+                    sendNotification(it->notification, it->nextFragment);
+                } catch (const CommException& e) {
+                    // The remaining notifications are sent after the
+                    // next attempt.
+                    RSCWARN(this->logger, "Lost connection to the Spread "
+                            "daemon while sending buffered notifications: "
+                            << e.what());
+                    boost::mutex::scoped_lock reconnectLock(this->reconnectMutex);
+                    if (this->reconnectAllowed) {
+                        this->bufferedNotifications.insert
+                            (this->bufferedNotifications.begin(),
+                             it, buffered.end());
+                    }
+                    return false;
+                } catch (const std::exception& e) {
+                    RSCWARN(this->logger, "Dropping buffered notification: "
+                            << e.what());
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
 ///
 
-void BusImpl::sendNotification(OutgoingNotificationPtr notification) {
+void BusImpl::startReceivers() {
+    // Messages sent via the additional connections reach the primary
+    // connection like messages from any other process. They have to
+    // be discarded since they have already been delivered locally.
+    std::set<std::string> ownSenders;
+    for (std::vector<ConnectionPtr>::const_iterator it
+             = this->sendConnections.begin();
+         it != this->sendConnections.end(); ++it) {
+        ownSenders.insert((*it)->getPrivateGroup());
+    }
+
+    WeakHandlerAdapterPtr handler(new WeakHandlerAdapter(shared_from_this()));
+    this->receiver.reset(new ReceiverTask(this->connection, handler, ownSenders,
+                                          this->metrics));
+    this->receiver->setScopeMetrics(this->scopeMetrics);
+    {
+        boost::mutex::scoped_lock sinkLock(this->sinkMutex);
+        this->receiver->setTrackSequenceNumbers(receivesAllNotifications());
+    }
+    this->executor->schedule(this->receiver);
+
+    // The send connections are not members of any group. Their
+    // receivers only handle control messages addressed to their
+    // private groups: clock synchronization requests and requests
+    // for retransmitting fragments which have been sent via them.
+    this->sendReceivers.clear();
+    for (std::vector<ConnectionPtr>::const_iterator it
+             = this->sendConnections.begin();
+         it != this->sendConnections.end(); ++it) {
+        boost::shared_ptr<ReceiverTask> receiver
+            (new ReceiverTask(*it, handler, std::set<std::string>(),
+                              this->metrics));
+        this->sendReceivers.push_back(receiver);
+        this->executor->schedule(receiver);
+    }
+}
+
+namespace {
+
+void stopReceiver(boost::shared_ptr<ReceiverTask> receiver,
+                  ConnectionPtr                   connection) {
+    receiver->cancel();
+    // A failed connection may already have been closed.
+    if (connection->isActive()) {
+        try {
+            connection->interruptReceive();
+        } catch (const std::exception&) {
+        }
+    }
+    receiver->waitDone();
+}
+
+}
+
+void BusImpl::stopReceivers() {
+    if (this->receiver) {
+        stopReceiver(this->receiver, this->connection);
+    }
+    for (std::size_t i = 0; i < this->sendReceivers.size(); ++i) {
+        stopReceiver(this->sendReceivers[i], this->sendConnections[i]);
+    }
+}
+
+void BusImpl::scheduleReconnect() {
+    if (this->reconnectTask || !this->reconnectAllowed) {
+        return;
+    }
+
+    this->reconnectTask.reset
+        (new ReconnectTask(shared_from_this(), this->maxReconnectDelay));
+    this->executor->schedule(this->reconnectTask);
+}
+
+bool BusImpl::bufferNotification(OutgoingNotificationPtr notification,
+                                 std::size_t             nextFragment) {
+    boost::mutex::scoped_lock lock(this->reconnectMutex);
+
+    if ((this->maxReconnectDelay == 0) || !this->reconnectAllowed
+        || (this->bufferedNotifications.size()
+            >= this->maxBufferedNotifications)) {
+        return false;
+    }
+
+    // The failed send may be the first indication of the lost
+    // connection.
+    scheduleReconnect();
+
+    RSCDEBUG(this->logger, "Buffering notification for scope "
+             << notification->scope << " from fragment " << nextFragment
+             << " until reconnected");
+    BufferedNotification buffered = { notification, nextFragment };
+    this->bufferedNotifications.push_back(buffered);
+    return true;
+}
+
+bool BusImpl::bufferWhileReconnecting(OutgoingNotificationPtr notification) {
+    boost::mutex::scoped_lock lock(this->reconnectMutex);
+
+    if (!this->reconnectTask
+        || (this->bufferedNotifications.size()
+            >= this->maxBufferedNotifications)) {
+        return false;
+    }
+
+    BufferedNotification buffered = { notification, 0 };
+    this->bufferedNotifications.push_back(buffered);
+    return true;
+}
+
+ConnectionPtr BusImpl::connectionForScope(const Scope& scope) const {
+    if (this->sendConnections.empty()) {
+        return this->connection;
+    }
+
+    std::size_t index = boost::hash<std::string>()(scope.toString())
+        % (this->sendConnections.size() + 1);
+    return (index == 0) ? this->connection : this->sendConnections[index - 1];
+}
+
+void BusImpl::sendNotification(OutgoingNotificationPtr notification,
+                               std::size_t&            nextFragment) {
+    // All fragments of the notification have to use the same
+    // connection to be received in order.
+    ConnectionPtr connection = connectionForScope(notification->scope);
+
     SpreadMessage message;
 
     // Quality of service.
     message.setQOS(notification->qos);
 
+    const NotificationMetrics& metrics = metricsForScope(notification->scope);
+    Counter& messagesSent = *metrics.messagesSent[qosIndex(notification->qos)];
+    Counter& bytesSent = *metrics.bytesSent[qosIndex(notification->qos)];
+    if (nextFragment == 0) {
+        metrics.fragmentsPerNotification->record(notification->fragments.size());
+    }
+
     // Add groups.
     for (std::vector<std::string>::const_iterator it
              = notification->groups.begin();
@@ -258,20 +1054,109 @@ void BusImpl::sendNotification(OutgoingNotificationPtr notification) {
     }
 
     // Send fragments
-    for (std::vector<rsb::protocol::FragmentedNotification>::iterator it
-             = notification->fragments.begin();
-         it != notification->fragments.end(); ++it) {
-        it->set_num_data_parts(notification->fragments.size());
+    const std::size_t numFragments = notification->fragments.size();
+    for (; nextFragment < numFragments; ++nextFragment) {
+        notification->fragments[nextFragment].set_num_data_parts(numFragments);
 
-        if (!it->SerializeToString(&message.mutableData())) {
-            throw rsb::protocol::ProtocolException("Failed to write notification to stream");
-        }
+        encodeFragment(*notification, nextFragment, message.mutableData());
 
-        this->connection->send(message);
+        boost::uint64_t start = rsc::misc::currentTimeMicros();
+        connection->send(message);
+        this->multicastDuration.record(rsc::misc::currentTimeMicros() - start);
+        messagesSent.increment();
+        bytesSent.increment(message.getSize());
         // TODO implement queuing or throw messages away?
         // TODO maybe return exception with msg that was not sent
         // TODO especially important to fulfill QoS specs
     }
+
+    // Send parity fragments after the data fragments such that
+    // receivers only use them if data fragments have been lost.
+    if ((notification->parityFragments > 0) && (numFragments > 1)) {
+        std::vector<ParityFragment> parity;
+        makeParityFragments(notification->fragments,
+                            notification->parityFragments, parity);
+        for (; nextFragment - numFragments < parity.size(); ++nextFragment) {
+            encodeParityFragment(parity[nextFragment - numFragments],
+                                 message.mutableData());
+            connection->send(message);
+            messagesSent.increment();
+            bytesSent.increment(message.getSize());
+        }
+    }
+
+    // Keep the notification for retransmitting fragments which
+    // receivers report as missing.
+    if ((this->nackDelay > 0)
+        && (notification->qos == SpreadMessage::UNRELIABLE)
+        && (numFragments > 1)) {
+        this->retransmitBuffer.add(notification);
+    }
+}
+
+void BusImpl::retransmitFragments(const SpreadMessage& request) {
+    rsb::protocol::EventId eventId;
+    std::vector<boost::uint32_t> parts;
+    if (!decodeNack(request.getData(), eventId, parts)) {
+        RSCDEBUG(this->logger, "Ignoring malformed fragment request from "
+                 << request.getSender());
+        return;
+    }
+    // Send each requested fragment only once.
+    std::sort(parts.begin(), parts.end());
+    parts.erase(std::unique(parts.begin(), parts.end()), parts.end());
+
+    OutgoingNotificationPtr notification = this->retransmitBuffer.find(eventId);
+    if (!notification) {
+        RSCDEBUG(this->logger,
+                 (boost::format("Cannot retransmit fragments of sequence "
+                                "number %1% which is no longer buffered")
+                  % eventId.sequence_number()));
+        return;
+    }
+
+    // Only the requesting receiver needs the fragments.
+    SpreadMessage message;
+    message.setQOS(SpreadMessage::UNRELIABLE);
+    message.addGroup(request.getSender());
+    ConnectionPtr connection = connectionForScope(notification->scope);
+    Counter& retransmitted
+        = *metricsForScope(notification->scope).fragmentsRetransmitted;
+    boost::shared_lock<boost::shared_mutex> lock(this->connectionMutex);
+    for (std::vector<boost::uint32_t>::const_iterator it = parts.begin();
+         it != parts.end(); ++it) {
+        if (*it >= notification->fragments.size()) {
+            continue;
+        }
+        encodeFragment(*notification, *it, message.mutableData());
+        try {
+            connection->send(message);
+        } catch (const CommException& e) {
+            RSCWARN(this->logger, "Could not retransmit fragment to "
+                    << request.getSender() << ": " << e.what());
+            return;
+        }
+        retransmitted.increment();
+    }
+}
+
+void BusImpl::sendControlMessage(const std::string& group,
+                                 const std::string& data) {
+    SpreadMessage message;
+    message.setQOS(SpreadMessage::UNRELIABLE);
+    message.addGroup(group);
+    message.mutableData() = data;
+
+    boost::shared_lock<boost::shared_mutex> lock(this->connectionMutex);
+    try {
+        this->connection->send(message);
+    } catch (const CommException& e) {
+        RSCWARN(this->logger, "Could not send control message to "
+                << group << ": " << e.what());
+    } catch (const rsc::misc::IllegalStateException& e) {
+        RSCDEBUG(this->logger, "Not sending control message to "
+                 << group << " while reconnecting");
+    }
 }
 
 }
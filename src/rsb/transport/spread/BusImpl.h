@@ -26,10 +26,16 @@
 
 #pragma once
 
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
 #include <boost/shared_ptr.hpp>
 #include <boost/enable_shared_from_this.hpp>
 
 #include <boost/thread/mutex.hpp>
+#include <boost/thread/shared_mutex.hpp>
 
 #include <rsc/runtime/Printable.h>
 
@@ -39,9 +45,12 @@
 
 #include "Bus.h"
 #include "Notifications.h"
-#include "SpreadConnection.h"
+#include "Connection.h"
 #include "MembershipManager.h"
 #include "ReceiverTask.h"
+#include "Metrics.h"
+#include "ClockSync.h"
+#include "RetransmitBuffer.h"
 
 #include "rsb/transport/spread/rsbspreadexports.h"
 
@@ -58,6 +67,29 @@ namespace spread {
  * rsb::eventprocessing::ScopeDispatcher to route events to local
  * sinks.
  *
+ * In addition to the primary connection, which is used for
+ * receiving, group membership and sending, the bus can use a pool of
+ * additional connections for sending. Each outgoing notification is
+ * sent via the connection selected by a hash of its scope, such that
+ * concurrent senders on different scopes use different Spread
+ * mailboxes while notifications on any given scope retain their FIFO
+ * order.
+ *
+ * The bus answers clock synchronization requests of peers and, if
+ * enabled via @ref setClockSyncInterval, periodically sends such
+ * requests to the peers from which it receives notifications. The
+ * resulting clock offset estimates are attached to incoming
+ * notifications.
+ *
+ * If enabled via @ref setNackDelay, the bus requests fragments of
+ * incomplete notifications from their senders and keeps recently
+ * sent unreliable notifications to answer such requests.
+ *
+ * If enabled via @ref setReconnect, the bus reestablishes its
+ * connections after one of them fails, for example because the
+ * daemon has been restarted, restores its Spread group memberships
+ * and resumes receiving.
+ *
  * @author jmoringe
  */
 class RSBSPREAD_EXPORT BusImpl : public Bus,
@@ -67,7 +99,28 @@ public:
 
     // Since this class uses shared_from_this, there better be no way
     // of obtaining an instance that is not owned by a shared_ptr.
-    static BusPtr create(SpreadConnectionPtr connection);
+    static BusPtr create(ConnectionPtr connection);
+
+    /**
+     * Creates a bus which receives via @a connection and sends via
+     * @a connection and @a sendConnections.
+     *
+     * @param connection The primary connection of the bus.
+     * @param sendConnections Additional connections which are only
+     *                        used for sending.
+     */
+    static BusPtr create(ConnectionPtr                     connection,
+                         const std::vector<ConnectionPtr>& sendConnections);
+
+    /**
+     * Like the above but records metrics in @a metrics.
+     *
+     * @param metrics The registry in which metrics should be
+     *                recorded. May be shared with other buses.
+     */
+    static BusPtr create(ConnectionPtr                     connection,
+                         const std::vector<ConnectionPtr>& sendConnections,
+                         MetricsRegistryPtr                metrics);
     virtual ~BusImpl();
 
     void printContents(std::ostream& stream) const ;
@@ -82,7 +135,97 @@ public:
 
     void handleOutgoingNotification(OutgoingNotificationPtr notification);
     void handleIncomingNotification(IncomingNotificationPtr notification);
+    void handleControlMessage(const SpreadMessage& message);
     void handleError(const std::exception& error);
+
+    MetricsRegistryPtr getMetrics() const;
+    bool getScopeMetrics() const;
+
+    /**
+     * Sets the interval in which clock synchronization requests are
+     * sent to peers. Has to be called before @ref activate.
+     *
+     * Peers of versions which do not understand these requests stop
+     * receiving when they get one. Requests should therefore only be
+     * enabled when all participants on the Spread segment support
+     * them.
+     *
+     * @param intervalMs The interval in milliseconds. 0 disables
+     *                   sending requests.
+     */
+    void setClockSyncInterval(unsigned int intervalMs);
+
+    /**
+     * Returns the clock offset estimates for the peers of the bus.
+     */
+    const ClockSync& getClockSync() const;
+
+    /**
+     * Sends a clock synchronization request to each known peer and
+     * updates the clock metrics from the current estimates.
+     */
+    void sendClockPings();
+
+    /**
+     * Sets the time after which missing fragments of incomplete
+     * notifications are requested from the sender. Also makes the
+     * bus buffer sent unreliable notifications consisting of
+     * multiple fragments to answer such requests. Has to be called
+     * before @ref activate.
+     *
+     * Like clock synchronization requests, fragment requests make
+     * senders of versions which do not understand them stop
+     * receiving.
+     *
+     * @param delayMs The delay in milliseconds. 0 disables
+     *                requesting and buffering.
+     */
+    void setNackDelay(unsigned int delayMs);
+
+    /**
+     * Requests missing fragments of incomplete notifications which
+     * are due from their senders.
+     */
+    void sendNacks();
+
+    /**
+     * Enables labeling metrics about sent and received notifications
+     * with their scopes. Each scope creates new metrics which are
+     * kept for the lifetime of the registry, so this should only be
+     * enabled if the number of scopes is bounded. Has to be called
+     * before @ref activate.
+     *
+     * @param scopeMetrics @c true to label metrics with scopes.
+     */
+    void setScopeMetrics(bool scopeMetrics);
+
+    /**
+     * Enables reconnecting after a connection of the bus fails.
+     * Connections are reestablished with exponentially growing
+     * delays between attempts. Has to be called before @ref
+     * activate.
+     *
+     * @param maxDelayMs The maximum delay between attempts in
+     *                   milliseconds. 0 disables reconnecting, such
+     *                   that a failed connection is reported to the
+     *                   sinks and the bus stops receiving.
+     * @param maxBufferedNotifications The maximum number of outgoing
+     *                                 notifications which are
+     *                                 buffered while reconnecting
+     *                                 and sent afterwards. Sending
+     *                                 further notifications fails.
+     */
+    void setReconnect(unsigned int maxDelayMs,
+                      unsigned int maxBufferedNotifications);
+
+    /**
+     * Makes one attempt at reestablishing all connections. If
+     * successful, restores the group memberships, resumes receiving
+     * and sends buffered notifications.
+     *
+     * @return @c true if the connections have been reestablished.
+     */
+    bool reconnect();
 private:
     typedef eventprocessing::WeakScopeDispatcher<Sink> ScopeDispatcher;
 
@@ -91,21 +234,151 @@ private:
     bool                            active;
 
     // Connection and Spread group membership
-    SpreadConnectionPtr             connection;
+    ConnectionPtr                   connection;
+    std::vector<ConnectionPtr>      sendConnections;
 
     MembershipManager               memberships;
 
     // Receiving and dispatching
     rsc::threading::TaskExecutorPtr executor;
     boost::shared_ptr<ReceiverTask> receiver;
+    // Receivers for the send connections which only handle control
+    // messages sent to the respective private groups.
+    std::vector< boost::shared_ptr<ReceiverTask> > sendReceivers;
 
     ScopeDispatcher                 scopeDispatcher;
 
     boost::mutex                    sinkMutex;
 
-    BusImpl(SpreadConnectionPtr connection);
+    // Metrics. Metrics recorded for each notification are looked up
+    // once, or once per scope if scope labels are enabled, since the
+    // registry is locked for each lookup.
+    struct NotificationMetrics {
+        Counter*   notificationsReceived;
+        Counter*   payloadBytesReceived;
+        Counter*   messagesSent[NUM_QOS_LEVELS];
+        Counter*   bytesSent[NUM_QOS_LEVELS];
+        Histogram* fragmentsPerNotification;
+        Counter*   fragmentsRetransmitted;
+    };
+    typedef std::map<std::string, NotificationMetrics> ScopeMetricsMap;
+
+    MetricsRegistryPtr              metrics;
+    Histogram&                      multicastDuration;
+    Counter&                        nacksSent;
+    NotificationMetrics             notificationMetrics;
+    bool                            scopeMetrics;
+    boost::mutex                    scopeMetricsMutex;
+    ScopeMetricsMap                 scopeMetricsMap;
+
+    // Clock synchronization
+    ClockSync                       clockSync;
+    unsigned int                    clockSyncInterval;
+    rsc::threading::TaskPtr         clockSyncTask;
+    // Aggregated over the peers since the set of peers is unbounded.
+    Gauge&                          clockPeers;
+    Gauge&                          maxClockOffset;
+    Gauge&                          maxClockRoundTrip;
+
+    // Retransmission of lost fragments
+    unsigned int                    nackDelay;
+    rsc::threading::TaskPtr         nackTask;
+    RetransmitBuffer                retransmitBuffer;
+
+    // Reconnecting after a connection failure. connectionMutex is
+    // held exclusively while connections are reestablished and
+    // shared while sending or accessing the receivers.
+    //
+    // A buffered notification may have been sent partially before
+    // the connection failed. Sending it resumes with the fragment
+    // nextFragment.
+    struct BufferedNotification {
+        OutgoingNotificationPtr notification;
+        std::size_t             nextFragment;
+    };
+
+    unsigned int                     maxReconnectDelay;
+    unsigned int                     maxBufferedNotifications;
+    boost::shared_mutex              connectionMutex;
+    boost::mutex                     reconnectMutex;
+    bool                             reconnectAllowed;
+    rsc::threading::TaskPtr          reconnectTask;
+    std::deque<BufferedNotification> bufferedNotifications;
+
+    BusImpl(ConnectionPtr                     connection,
+            const std::vector<ConnectionPtr>& sendConnections,
+            MetricsRegistryPtr                metrics);
+
+    ConnectionPtr connectionForScope(const Scope& scope) const;
+
+    void lookUpNotificationMetrics(const MetricLabels&  labels,
+                                   NotificationMetrics& result);
+
+    const NotificationMetrics& metricsForScope(const Scope& scope);
+
+    void startReceivers();
+    void stopReceivers();
+
+    /**
+     * Tells whether the bus receives all notifications of each
+     * sender, which is the case if it is a member of the group of
+     * the root scope since every notification is sent to that
+     * group. Must be called with @ref sinkMutex held.
+     */
+    bool receivesAllNotifications() const;
+
+    /**
+     * Enables tracking sequence numbers in the receiver if the bus
+     * receives all notifications, see @ref
+     * receivesAllNotifications. Otherwise, notifications of a sender
+     * on scopes the bus does not receive would be reported as
+     * missing.
+     */
+    void updateSequenceTracking();
+
+    /**
+     * Starts reconnecting unless already in progress. Must be called
+     * with @ref reconnectMutex held.
+     */
+    void scheduleReconnect();
+
+    /**
+     * Buffers @a notification, which could not be sent, for sending
+     * after reconnecting.
+     *
+     * @param nextFragment The index of the first fragment of
+     *                     @a notification which has not been sent.
+     * @return @c false if reconnecting is disabled or the buffer is
+     *         full.
+     */
+    bool bufferNotification(OutgoingNotificationPtr notification,
+                            std::size_t             nextFragment);
+
+    /**
+     * Buffers @a notification for sending after reconnecting if a
+     * reconnect is in progress.
+     *
+     * @return @c false if no reconnect is in progress or the buffer
+     *         is full.
+     */
+    bool bufferWhileReconnecting(OutgoingNotificationPtr notification);
+
+    /**
+     * Sends the fragments of @a notification, starting with fragment
+     * @a nextFragment. The data fragments are followed by the parity
+     * fragments.
+     *
+     * @param nextFragment The index of the first fragment to send.
+     *                     Is advanced for each sent fragment, such
+     *                     that it indicates the fragments which have
+     *                     not been sent if sending fails.
+     */
+    void sendNotification(OutgoingNotificationPtr notification,
+                          std::size_t&            nextFragment);
+
+    void retransmitFragments(const SpreadMessage& request);
 
-    void sendNotification(OutgoingNotificationPtr notification);
+    void sendControlMessage(const std::string& group, const std::string& data);
 };
 
 }
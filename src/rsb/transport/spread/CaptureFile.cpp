@@ -0,0 +1,321 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#include "CaptureFile.h"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include <boost/format.hpp>
+
+#include <rsc/misc/langutils.h>
+
+namespace rsb {
+namespace transport {
+namespace spread {
+
+namespace {
+
+const char            MAGIC[]        = "RSBSPCAP";
+const std::size_t     MAGIC_SIZE     = 8;
+const boost::uint32_t FORMAT_VERSION = 1;
+const std::size_t     SIZE_OFFSET    = 16;
+const std::size_t     HEADER_SIZE    = 24;
+
+void appendUInt32(boost::uint32_t value, std::string& output) {
+    output.push_back(static_cast<char>(value & 0xff));
+    output.push_back(static_cast<char>((value >> 8) & 0xff));
+    output.push_back(static_cast<char>((value >> 16) & 0xff));
+    output.push_back(static_cast<char>((value >> 24) & 0xff));
+}
+
+void appendUInt64(boost::uint64_t value, std::string& output) {
+    appendUInt32(static_cast<boost::uint32_t>(value & 0xffffffff), output);
+    appendUInt32(static_cast<boost::uint32_t>(value >> 32), output);
+}
+
+void appendString(const std::string& value, std::string& output) {
+    appendUInt32(value.size(), output);
+    output.append(value);
+}
+
+boost::uint64_t decodeUInt64(const char* input) {
+    boost::uint64_t value = 0;
+    for (unsigned int i = 0; i < 8; ++i) {
+        value |= (static_cast<boost::uint64_t>
+                  (static_cast<boost::uint8_t>(input[i])) << (8 * i));
+    }
+    return value;
+}
+
+/**
+ * Reads from a record while checking bounds.
+ */
+class Reader {
+public:
+    Reader(const char* input, std::size_t size) :
+        input(input), size(size), offset(0) {
+    }
+
+    bool readByte(boost::uint8_t& value) {
+        if (this->size - this->offset < 1) {
+            return false;
+        }
+        value = static_cast<boost::uint8_t>(this->input[this->offset++]);
+        return true;
+    }
+
+    bool readUInt32(boost::uint32_t& value) {
+        if (this->size - this->offset < 4) {
+            return false;
+        }
+        value = 0;
+        for (unsigned int i = 0; i < 4; ++i) {
+            value |= (static_cast<boost::uint32_t>
+                      (static_cast<boost::uint8_t>(this->input[this->offset + i]))
+                      << (8 * i));
+        }
+        this->offset += 4;
+        return true;
+    }
+
+    bool readUInt64(boost::uint64_t& value) {
+        if (this->size - this->offset < 8) {
+            return false;
+        }
+        value = decodeUInt64(this->input + this->offset);
+        this->offset += 8;
+        return true;
+    }
+
+    bool readString(std::string& value) {
+        boost::uint32_t length;
+        if (!readUInt32(length) || (this->size - this->offset < length)) {
+            return false;
+        }
+        value.assign(this->input + this->offset, length);
+        this->offset += length;
+        return true;
+    }
+private:
+    const char* input;
+    std::size_t size;
+    std::size_t offset;
+};
+
+}
+
+CaptureWriter::CaptureWriter(const std::string& fileName,
+                             std::size_t        chunkSize) :
+    fileName(fileName), chunkSize(chunkSize), capacity(0), size(HEADER_SIZE) {
+    {
+        std::filebuf file;
+        if (!file.open(fileName.c_str(),
+                       std::ios::out | std::ios::trunc | std::ios::binary)) {
+            throw std::runtime_error(boost::str(boost::format("Could not create"
+                                                              " capture file"
+                                                              " '%1%'.")
+                                                % fileName));
+        }
+    }
+    grow(HEADER_SIZE);
+
+    std::string header(MAGIC, MAGIC_SIZE);
+    appendUInt32(FORMAT_VERSION, header);
+    appendUInt32(0, header);
+    appendUInt64(this->size, header);
+    std::memcpy(this->region->get_address(), header.data(), header.size());
+}
+
+CaptureWriter::~CaptureWriter() {
+    this->region->flush();
+}
+
+void CaptureWriter::append(CaptureDirection     direction,
+                           const std::string&   sender,
+                           const SpreadMessage& message) {
+    std::string record;
+    record.reserve(64 + message.getData().size());
+    appendUInt32(0, record); // length, filled in below
+    appendUInt64(rsc::misc::currentTimeMicros(), record);
+    record.push_back(static_cast<char>(direction));
+    appendUInt32(message.getType(), record);
+    appendUInt32(message.getQOS(), record);
+    appendString(sender, record);
+    const std::set<std::string>& groups = message.getGroups();
+    appendUInt32(groups.size(), record);
+    for (std::set<std::string>::const_iterator it = groups.begin();
+         it != groups.end(); ++it) {
+        appendString(*it, record);
+    }
+    appendString(message.getData(), record);
+
+    std::string length;
+    appendUInt32(record.size() - 4, length);
+    record.replace(0, 4, length);
+
+    boost::mutex::scoped_lock lock(this->mutex);
+
+    if (this->size + record.size() > this->capacity) {
+        grow(this->size + record.size());
+    }
+    char* base = static_cast<char*>(this->region->get_address());
+    std::memcpy(base + this->size, record.data(), record.size());
+    this->size += record.size();
+
+    // Publish the record only after it has been written completely.
+    std::string size;
+    appendUInt64(this->size, size);
+    std::memcpy(base + SIZE_OFFSET, size.data(), size.size());
+}
+
+boost::uint64_t CaptureWriter::getSize() const {
+    boost::mutex::scoped_lock lock(this->mutex);
+    return this->size;
+}
+
+void CaptureWriter::grow(std::size_t required) {
+    std::size_t capacity = this->capacity + this->chunkSize;
+    if (capacity < required) {
+        capacity = required;
+    }
+
+    this->region.reset();
+    this->mapping.reset();
+
+    // Extend the file by writing its last byte. Existing contents are
+    // preserved.
+    {
+        std::filebuf file;
+        if (!file.open(this->fileName.c_str(),
+                       std::ios::in | std::ios::out | std::ios::binary)
+            || (file.pubseekoff(capacity - 1, std::ios::beg) < 0)
+            || (file.sputc(0) == std::filebuf::traits_type::eof())) {
+            throw std::runtime_error(boost::str(boost::format("Could not grow"
+                                                              " capture file"
+                                                              " '%1%' to %2%"
+                                                              " bytes.")
+                                                % this->fileName % capacity));
+        }
+    }
+
+    this->mapping.reset(new boost::interprocess::file_mapping
+                        (this->fileName.c_str(), boost::interprocess::read_write));
+    this->region.reset(new boost::interprocess::mapped_region
+                       (*this->mapping, boost::interprocess::read_write,
+                        0, capacity));
+    this->capacity = capacity;
+}
+
+CaptureReader::CaptureReader(const std::string& fileName) :
+    fileName(fileName),
+    mapping(fileName.c_str(), boost::interprocess::read_only),
+    region(mapping, boost::interprocess::read_only),
+    data(static_cast<const char*>(region.get_address())),
+    size(0), offset(HEADER_SIZE) {
+    if ((this->region.get_size() < HEADER_SIZE)
+        || (std::memcmp(this->data, MAGIC, MAGIC_SIZE) != 0)) {
+        throw std::runtime_error(boost::str(boost::format("'%1%' is not a"
+                                                          " capture file.")
+                                            % fileName));
+    }
+    Reader header(this->data + MAGIC_SIZE, HEADER_SIZE - MAGIC_SIZE);
+    boost::uint32_t version;
+    boost::uint64_t size;
+    header.readUInt32(version);
+    if (version != FORMAT_VERSION) {
+        throw std::runtime_error(boost::str(boost::format("Capture file '%1%'"
+                                                          " has unsupported"
+                                                          " version %2%.")
+                                            % fileName % version));
+    }
+    size = decodeUInt64(this->data + SIZE_OFFSET);
+    if ((size < HEADER_SIZE) || (size > this->region.get_size())) {
+        throw std::runtime_error(boost::str(boost::format("Capture file '%1%'"
+                                                          " has invalid size"
+                                                          " %2%.")
+                                            % fileName % size));
+    }
+    this->size = size;
+}
+
+bool CaptureReader::next(CaptureRecord& record) {
+    if (this->offset == this->size) {
+        return false;
+    }
+
+    Reader lengthReader(this->data + this->offset, this->size - this->offset);
+    boost::uint32_t length;
+    bool valid = lengthReader.readUInt32(length)
+        && (this->size - this->offset - 4 >= length);
+
+    boost::uint8_t  direction;
+    boost::uint32_t type;
+    boost::uint32_t qos;
+    std::string     sender;
+    boost::uint32_t numGroups;
+    SpreadMessage   message;
+    if (valid) {
+        Reader reader(this->data + this->offset + 4, length);
+        valid = reader.readUInt64(record.timestamp)
+            && reader.readByte(direction)
+            && reader.readUInt32(type)
+            && reader.readUInt32(qos)
+            && reader.readString(sender)
+            && reader.readUInt32(numGroups);
+        for (boost::uint32_t i = 0; valid && (i < numGroups); ++i) {
+            std::string group;
+            valid = reader.readString(group);
+            message.addGroup(group);
+        }
+        valid = valid && reader.readString(message.mutableData());
+    }
+    if (!valid) {
+        throw std::runtime_error(boost::str(boost::format("Corrupt record at"
+                                                          " offset %1% in"
+                                                          " capture file"
+                                                          " '%2%'.")
+                                            % this->offset % this->fileName));
+    }
+
+    message.setType(SpreadMessage::Type(type));
+    message.setQOS(SpreadMessage::QOS(qos));
+    message.setSender(sender);
+    record.direction = CaptureDirection(direction);
+    record.message   = message;
+
+    this->offset += 4 + length;
+    return true;
+}
+
+void CaptureReader::rewind() {
+    this->offset = HEADER_SIZE;
+}
+
+}
+}
+}
@@ -0,0 +1,187 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#pragma once
+
+#include <string>
+
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <boost/thread/mutex.hpp>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include "SpreadMessage.h"
+
+#include "rsb/transport/spread/rsbspreadexports.h"
+
+namespace rsb {
+namespace transport {
+namespace spread {
+
+/**
+ * @name Capture files
+ *
+ * A capture file records Spread messages sent or received by a
+ * process such that they can be replayed later. The file starts with
+ * a header consisting of the magic string "RSBSPCAP", a format version
+ * (four bytes), four reserved bytes and the length of the valid part
+ * of the file (eight bytes). The header is followed by records, each
+ * consisting of the record length excluding the length field itself
+ * (four bytes), a timestamp in microseconds since the epoch (eight
+ * bytes), the @ref CaptureDirection (one byte), message type and QoS
+ * (four bytes each), the sender, the number of groups (four bytes),
+ * the groups and the message data. Strings are encoded as their
+ * length (four bytes) followed by their bytes.
+ *
+ * Integers are encoded in little-endian byte order. Bytes after the
+ * valid part of the file are unused.
+ */
+//@{
+
+/**
+ * Direction of a captured message from the point of view of the
+ * capturing process.
+ */
+enum CaptureDirection {
+    CAPTURE_RECEIVED = 0x00,
+    CAPTURE_SENT     = 0x01
+};
+
+/**
+ * A message read from a capture file.
+ */
+struct RSBSPREAD_EXPORT CaptureRecord {
+    boost::uint64_t  timestamp;
+    CaptureDirection direction;
+    SpreadMessage    message;
+};
+
+/**
+ * Appends records to a memory-mapped capture file.
+ *
+ * The file is grown in chunks of configurable size and the valid
+ * length in the header is updated after each complete record, such
+ * that a reader never sees partially written records.
+ *
+ * @note This class is thread-safe.
+ *
+ * @author jmoringe
+ */
+class RSBSPREAD_EXPORT CaptureWriter {
+public:
+    /**
+     * Creates @a fileName, replacing any existing file.
+     *
+     * @param fileName Name of the capture file.
+     * @param chunkSize Number of bytes by which the file is grown
+     *                  when it is full.
+     * @throw std::runtime_error if the file cannot be created.
+     */
+    explicit CaptureWriter(const std::string& fileName,
+                           std::size_t        chunkSize = 16 * 1024 * 1024);
+    ~CaptureWriter();
+
+    /**
+     * Appends a record for @a message, stamped with the current
+     * time.
+     *
+     * @param direction Whether the message has been sent or received.
+     * @param sender Private group of the sender of @a message.
+     * @param message The message. Its sender is ignored.
+     */
+    void append(CaptureDirection     direction,
+                const std::string&   sender,
+                const SpreadMessage& message);
+
+    /**
+     * Returns the number of valid bytes in the file.
+     */
+    boost::uint64_t getSize() const;
+private:
+    void grow(std::size_t required);
+
+    std::string                                          fileName;
+    std::size_t                                          chunkSize;
+
+    mutable boost::mutex                                 mutex;
+    boost::scoped_ptr<boost::interprocess::file_mapping>  mapping;
+    boost::scoped_ptr<boost::interprocess::mapped_region> region;
+    std::size_t                                          capacity;
+    std::size_t                                          size;
+};
+
+typedef boost::shared_ptr<CaptureWriter> CaptureWriterPtr;
+
+/**
+ * Reads the records of a capture file in the order in which they
+ * have been written.
+ *
+ * @author jmoringe
+ */
+class RSBSPREAD_EXPORT CaptureReader {
+public:
+    /**
+     * Maps @a fileName and checks its header.
+     *
+     * @param fileName Name of the capture file.
+     * @throw std::runtime_error if the file cannot be opened or is
+     *                           not a valid capture file.
+     */
+    explicit CaptureReader(const std::string& fileName);
+
+    /**
+     * Reads the next record into @a record.
+     *
+     * @return @c true if a record has been read, @c false at the end
+     *         of the file.
+     * @throw std::runtime_error if the record is corrupt.
+     */
+    bool next(CaptureRecord& record);
+
+    /**
+     * Continues reading at the first record.
+     */
+    void rewind();
+private:
+    std::string                          fileName;
+    boost::interprocess::file_mapping    mapping;
+    boost::interprocess::mapped_region   region;
+    const char*                          data;
+    std::size_t                          size;
+    std::size_t                          offset;
+};
+
+typedef boost::shared_ptr<CaptureReader> CaptureReaderPtr;
+
+//@}
+
+}
+}
+}
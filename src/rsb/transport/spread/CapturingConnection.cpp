@@ -0,0 +1,92 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#include "CapturingConnection.h"
+
+namespace rsb {
+namespace transport {
+namespace spread {
+
+CapturingConnection::CapturingConnection(ConnectionPtr    connection,
+                                         CaptureWriterPtr writer) :
+    connection(connection), writer(writer) {
+}
+
+void CapturingConnection::printContents(std::ostream& stream) const {
+    stream << "connection = " << *this->connection;
+}
+
+const std::string CapturingConnection::getTransportURL() const {
+    return this->connection->getTransportURL();
+}
+
+const std::string& CapturingConnection::getPrivateGroup() const {
+    return this->connection->getPrivateGroup();
+}
+
+bool CapturingConnection::isActive() const {
+    return this->connection->isActive();
+}
+
+void CapturingConnection::activate() {
+    this->connection->activate();
+}
+
+void CapturingConnection::deactivate() {
+    this->connection->deactivate();
+}
+
+void CapturingConnection::join(const std::string& group) {
+    this->connection->join(group);
+}
+
+void CapturingConnection::leave(const std::string& group) {
+    this->connection->leave(group);
+}
+
+void CapturingConnection::receive(SpreadMessage& message) {
+    this->connection->receive(message);
+    if (message.getType() == SpreadMessage::REGULAR) {
+        this->writer->append(CAPTURE_RECEIVED, message.getSender(), message);
+    }
+}
+
+void CapturingConnection::send(const SpreadMessage& message) {
+    this->connection->send(message);
+    this->writer->append(CAPTURE_SENT, getPrivateGroup(), message);
+}
+
+int CapturingConnection::getPendingBytes() const {
+    return this->connection->getPendingBytes();
+}
+
+void CapturingConnection::interruptReceive() {
+    this->connection->interruptReceive();
+}
+
+}
+}
+}
@@ -0,0 +1,87 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#pragma once
+
+#include <string>
+
+#include <boost/shared_ptr.hpp>
+
+#include "Connection.h"
+#include "CaptureFile.h"
+
+#include "rsb/transport/spread/rsbspreadexports.h"
+
+namespace rsb {
+namespace transport {
+namespace spread {
+
+/**
+ * A @ref Connection which forwards to another connection and appends
+ * all regular messages sent or received via that connection to a
+ * capture file.
+ *
+ * @author jmoringe
+ */
+class RSBSPREAD_EXPORT CapturingConnection : public Connection {
+public:
+    /**
+     * @param connection The connection to which all operations are
+     *                   forwarded.
+     * @param writer The writer of the capture file. It may be shared
+     *               with other connections.
+     */
+    CapturingConnection(ConnectionPtr connection, CaptureWriterPtr writer);
+
+    void printContents(std::ostream& stream) const;
+
+    const std::string getTransportURL() const;
+
+    const std::string& getPrivateGroup() const;
+
+    bool isActive() const;
+
+    void activate();
+    void deactivate();
+
+    void join(const std::string& group);
+    void leave(const std::string& group);
+
+    void receive(SpreadMessage& message);
+
+    void send(const SpreadMessage& message);
+
+    int getPendingBytes() const;
+
+    void interruptReceive();
+private:
+    ConnectionPtr    connection;
+    CaptureWriterPtr writer;
+};
+
+}
+}
+}
@@ -0,0 +1,155 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#include "ClockSync.h"
+
+namespace rsb {
+namespace transport {
+namespace spread {
+
+ClockSync::ClockSync(unsigned int maxPeers,
+                     unsigned int windowSize) :
+    maxPeers(maxPeers), windowSize(windowSize), numObservations(0) {
+}
+
+void ClockSync::observeSender(const std::string& privateGroup) {
+    boost::mutex::scoped_lock lock(this->mutex);
+
+    PeerMap::iterator it = this->peers.find(privateGroup);
+    if (it == this->peers.end()) {
+        if (this->maxPeers == 0) {
+            return;
+        }
+        // Connections come and go. Make room by dropping the peer
+        // which has been silent for the longest time.
+        if (this->peers.size() >= this->maxPeers) {
+            PeerMap::iterator oldest = this->peers.begin();
+            for (PeerMap::iterator peerIt = this->peers.begin();
+                 peerIt != this->peers.end(); ++peerIt) {
+                if (peerIt->second.lastObserved < oldest->second.lastObserved) {
+                    oldest = peerIt;
+                }
+            }
+            this->peers.erase(oldest);
+        }
+        Peer peer;
+        peer.nextSample          = 0;
+        peer.clock.offset        = 0;
+        peer.clock.roundTripTime = 0;
+        peer.clock.numSamples    = 0;
+        it = this->peers.insert(std::make_pair(privateGroup, peer)).first;
+    }
+    it->second.lastObserved = ++this->numObservations;
+}
+
+std::vector<std::string> ClockSync::getPingTargets() const {
+    boost::mutex::scoped_lock lock(this->mutex);
+
+    std::vector<std::string> result;
+    for (PeerMap::const_iterator it = this->peers.begin();
+         it != this->peers.end(); ++it) {
+        result.push_back(it->first);
+    }
+    return result;
+}
+
+bool ClockSync::addSample(const std::string& privateGroup,
+                          boost::uint64_t    requestSendTime,
+                          boost::uint64_t    requestReceiveTime,
+                          boost::uint64_t    replySendTime,
+                          boost::uint64_t    replyReceiveTime) {
+    // Reject exchanges with inconsistent local or remote times.
+    if ((replyReceiveTime < requestSendTime)
+        || (replySendTime < requestReceiveTime)) {
+        return false;
+    }
+
+    Sample sample;
+    sample.offset
+        = ((boost::int64_t(requestReceiveTime) - boost::int64_t(requestSendTime))
+           + (boost::int64_t(replySendTime) - boost::int64_t(replyReceiveTime))) / 2;
+    boost::uint64_t total  = replyReceiveTime - requestSendTime;
+    boost::uint64_t remote = replySendTime - requestReceiveTime;
+    sample.roundTripTime = (total > remote) ? total - remote : 0;
+
+    boost::mutex::scoped_lock lock(this->mutex);
+
+    PeerMap::iterator it = this->peers.find(privateGroup);
+    if (it == this->peers.end()) {
+        return false;
+    }
+    Peer& peer = it->second;
+
+    if (peer.samples.size() < this->windowSize) {
+        peer.samples.push_back(sample);
+    } else {
+        peer.samples[peer.nextSample] = sample;
+    }
+    peer.nextSample = (peer.nextSample + 1) % this->windowSize;
+
+    // Use the sample with the smallest round-trip time since its
+    // offset has the smallest error bound.
+    const Sample* best = &peer.samples[0];
+    for (std::vector<Sample>::const_iterator sampleIt = peer.samples.begin();
+         sampleIt != peer.samples.end(); ++sampleIt) {
+        if (sampleIt->roundTripTime < best->roundTripTime) {
+            best = &*sampleIt;
+        }
+    }
+    peer.clock.offset        = best->offset;
+    peer.clock.roundTripTime = best->roundTripTime;
+    ++peer.clock.numSamples;
+    return true;
+}
+
+bool ClockSync::getPeerClock(const std::string& privateGroup,
+                             PeerClock&         clock) const {
+    boost::mutex::scoped_lock lock(this->mutex);
+
+    PeerMap::const_iterator it = this->peers.find(privateGroup);
+    if ((it == this->peers.end()) || (it->second.clock.numSamples == 0)) {
+        return false;
+    }
+    clock = it->second.clock;
+    return true;
+}
+
+ClockSync::PeerClockMap ClockSync::getPeerClocks() const {
+    boost::mutex::scoped_lock lock(this->mutex);
+
+    PeerClockMap result;
+    for (PeerMap::const_iterator it = this->peers.begin();
+         it != this->peers.end(); ++it) {
+        if (it->second.clock.numSamples != 0) {
+            result[it->first] = it->second.clock;
+        }
+    }
+    return result;
+}
+
+}
+}
+}
@@ -0,0 +1,162 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <boost/thread/mutex.hpp>
+
+#include "rsb/transport/spread/rsbspreadexports.h"
+
+namespace rsb {
+namespace transport {
+namespace spread {
+
+/**
+ * Estimates the offsets between the local clock and the clocks of
+ * peers from ping/pong exchanges.
+ *
+ * Peers are identified by the private groups of their
+ * connections. Connections to one daemon may come from different
+ * hosts with different clocks, so they cannot share an estimate.
+ *
+ * For each exchange, the request send time t1 and the answer receive
+ * time t4 are taken from the local clock while the request receive
+ * time t2 and the answer send time t3 are taken from the peer
+ * clock. As in NTP, the offset is estimated as ((t2 - t1) + (t3 -
+ * t4)) / 2 with an error bounded by half the round-trip time (t4 -
+ * t1) - (t3 - t2). Of the most recent exchanges with a peer, the one
+ * with the smallest round-trip time is used.
+ *
+ * @author jmoringe
+ */
+class RSBSPREAD_EXPORT ClockSync {
+public:
+    /**
+     * The clock of a peer.
+     */
+    struct PeerClock {
+        /**
+         * Peer clock minus local clock in microseconds.
+         */
+        boost::int64_t  offset;
+
+        /**
+         * Round-trip time of the exchange the offset has been
+         * computed from in microseconds.
+         */
+        boost::uint64_t roundTripTime;
+
+        /**
+         * Number of completed exchanges.
+         */
+        unsigned int    numSamples;
+    };
+
+    typedef std::map<std::string, PeerClock> PeerClockMap;
+
+    /**
+     * @param maxPeers The maximum number of peers which are
+     *                 tracked. When a new peer is observed, the peer
+     *                 which has not sent for the longest time is
+     *                 dropped.
+     * @param windowSize The number of recent exchanges per peer
+     *                   from which the best one is used.
+     */
+    ClockSync(unsigned int maxPeers   = 256,
+              unsigned int windowSize = 8);
+
+    /**
+     * Records that a message has been received from the connection
+     * with private group @a privateGroup, making it a peer which
+     * will be pinged.
+     */
+    void observeSender(const std::string& privateGroup);
+
+    /**
+     * Returns the private groups of all known peers.
+     */
+    std::vector<std::string> getPingTargets() const;
+
+    /**
+     * Updates the estimate for the peer @a privateGroup with the
+     * times of a completed exchange.
+     *
+     * @return @c true if the peer is known and has been updated.
+     */
+    bool addSample(const std::string& privateGroup,
+                   boost::uint64_t    requestSendTime,
+                   boost::uint64_t    requestReceiveTime,
+                   boost::uint64_t    replySendTime,
+                   boost::uint64_t    replyReceiveTime);
+
+    /**
+     * Retrieves the current estimate for the peer @a privateGroup.
+     *
+     * @return @c true if an estimate is available.
+     */
+    bool getPeerClock(const std::string& privateGroup,
+                      PeerClock&         clock) const;
+
+    /**
+     * Returns the current estimates for all peers, indexed by private
+     * group.
+     */
+    PeerClockMap getPeerClocks() const;
+private:
+    struct Sample {
+        boost::int64_t  offset;
+        boost::uint64_t roundTripTime;
+    };
+
+    struct Peer {
+        boost::uint64_t     lastObserved;
+        std::vector<Sample> samples;
+        unsigned int        nextSample;
+        PeerClock           clock;
+    };
+
+    typedef std::map<std::string, Peer> PeerMap;
+
+    unsigned int         maxPeers;
+    unsigned int         windowSize;
+
+    mutable boost::mutex mutex;
+    PeerMap              peers;
+    boost::uint64_t      numObservations;
+};
+
+typedef boost::shared_ptr<ClockSync> ClockSyncPtr;
+
+}
+}
+}
@@ -0,0 +1,247 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#include "Compression.h"
+
+#include <stdexcept>
+
+#include <boost/cstdint.hpp>
+#include <boost/format.hpp>
+
+#if defined RSBSPREAD_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#if defined RSBSPREAD_HAVE_LZ4
+#include <lz4.h>
+#endif
+
+namespace rsb {
+namespace transport {
+namespace spread {
+
+namespace {
+
+// Compressed payloads are announced by prefixing the original wire
+// schema with this string and the name of the codec. Receivers which
+// do not know about compression cannot find a converter for such a
+// wire schema and report an error instead of delivering garbage.
+const std::string COMPRESSED_PREFIX = "compressed:";
+
+// Compressed payloads start with the size of the uncompressed
+// payload (four bytes, little endian) since neither zlib nor LZ4
+// record it.
+const std::size_t SIZE_FIELD_LENGTH = 4;
+
+#if defined RSBSPREAD_HAVE_ZLIB
+class ZlibCodec : public PayloadCodec {
+public:
+    std::string getName() const {
+        return "zlib";
+    }
+
+    void compress(const std::string& input, std::string& output) const {
+        std::size_t offset = output.size();
+        uLongf size = compressBound(input.size());
+        output.resize(offset + size);
+        int result = compress2(reinterpret_cast<Bytef*>(&output[offset]), &size,
+                               reinterpret_cast<const Bytef*>(input.data()),
+                               input.size(), Z_BEST_SPEED);
+        if (result != Z_OK) {
+            throw std::runtime_error(boost::str(boost::format("zlib compression failed: %1%")
+                                                % result));
+        }
+        output.resize(offset + size);
+    }
+
+    bool decompress(const char* input, std::size_t size, std::string& output) const {
+        uLongf outputSize = output.size();
+        int result = uncompress(reinterpret_cast<Bytef*>(&output[0]), &outputSize,
+                                reinterpret_cast<const Bytef*>(input), size);
+        return (result == Z_OK) && (outputSize == output.size());
+    }
+
+    std::size_t getMaxExpansion() const {
+        // The theoretical limit of deflate.
+        return 1032;
+    }
+};
+#endif
+
+#if defined RSBSPREAD_HAVE_LZ4
+class LZ4Codec : public PayloadCodec {
+public:
+    std::string getName() const {
+        return "lz4";
+    }
+
+    void compress(const std::string& input, std::string& output) const {
+        std::size_t offset = output.size();
+        int bound = LZ4_compressBound(input.size());
+        if (bound == 0) {
+            throw std::runtime_error("Payload is too large for LZ4 compression");
+        }
+        output.resize(offset + bound);
+        int size = LZ4_compress_default(input.data(), &output[offset],
+                                        input.size(), bound);
+        if (size <= 0) {
+            throw std::runtime_error("LZ4 compression failed");
+        }
+        output.resize(offset + size);
+    }
+
+    bool decompress(const char* input, std::size_t size, std::string& output) const {
+        int outputSize = LZ4_decompress_safe(input, &output[0],
+                                             size, output.size());
+        return (outputSize >= 0)
+            && (static_cast<std::size_t>(outputSize) == output.size());
+    }
+
+    std::size_t getMaxExpansion() const {
+        return 255;
+    }
+};
+#endif
+
+}
+
+PayloadCodec::~PayloadCodec() {
+}
+
+std::set<std::string> availablePayloadCodecs() {
+    std::set<std::string> result;
+#if defined RSBSPREAD_HAVE_ZLIB
+    result.insert("zlib");
+#endif
+#if defined RSBSPREAD_HAVE_LZ4
+    result.insert("lz4");
+#endif
+    return result;
+}
+
+PayloadCodecPtr findPayloadCodec(const std::string& name) {
+    if (name == "none") {
+        return PayloadCodecPtr();
+    }
+#if defined RSBSPREAD_HAVE_ZLIB
+    if (name == "zlib") {
+        return PayloadCodecPtr(new ZlibCodec());
+    }
+#endif
+#if defined RSBSPREAD_HAVE_LZ4
+    if (name == "lz4") {
+        return PayloadCodecPtr(new LZ4Codec());
+    }
+#endif
+    throw std::invalid_argument(boost::str(boost::format("Compression codec '%1%' "
+                                                         "is not supported by "
+                                                         "this build.")
+                                           % name));
+}
+
+bool maybeCompressPayload(const PayloadCodec& codec,
+                          std::size_t         threshold,
+                          const std::string&  payload,
+                          std::string&        wireSchema,
+                          std::string&        compressed) {
+    if ((payload.size() < threshold)
+        || (payload.size() > 0xffffffffu)) {
+        return false;
+    }
+
+    compressed.clear();
+    compressed.reserve(SIZE_FIELD_LENGTH + payload.size());
+    boost::uint32_t size = payload.size();
+    for (std::size_t i = 0; i < SIZE_FIELD_LENGTH; ++i) {
+        compressed.push_back(static_cast<char>((size >> (8 * i)) & 0xff));
+    }
+    codec.compress(payload, compressed);
+    if (compressed.size() >= payload.size()) {
+        compressed.clear();
+        return false;
+    }
+
+    wireSchema = COMPRESSED_PREFIX + codec.getName() + ":" + wireSchema;
+    return true;
+}
+
+bool isCompressedWireSchema(const std::string& wireSchema) {
+    return wireSchema.compare(0, COMPRESSED_PREFIX.size(), COMPRESSED_PREFIX) == 0;
+}
+
+bool maybeDecompressPayload(std::string& wireSchema,
+                            std::string& payload) {
+    if (!isCompressedWireSchema(wireSchema)) {
+        return true;
+    }
+
+    std::string::size_type separator
+        = wireSchema.find(':', COMPRESSED_PREFIX.size());
+    if ((separator == std::string::npos)
+        || (payload.size() < SIZE_FIELD_LENGTH)) {
+        return false;
+    }
+
+    PayloadCodecPtr codec;
+    try {
+        codec = findPayloadCodec
+            (wireSchema.substr(COMPRESSED_PREFIX.size(),
+                               separator - COMPRESSED_PREFIX.size()));
+    } catch (const std::invalid_argument&) {
+        return false;
+    }
+    if (!codec) {
+        return false;
+    }
+
+    boost::uint32_t size = 0;
+    for (std::size_t i = 0; i < SIZE_FIELD_LENGTH; ++i) {
+        size |= static_cast<boost::uint32_t>
+            (static_cast<unsigned char>(payload[i])) << (8 * i);
+    }
+    // The size field is not trustworthy. Reject sizes the codec
+    // cannot produce before allocating.
+    if (static_cast<boost::uint64_t>(size)
+        > static_cast<boost::uint64_t>(payload.size() - SIZE_FIELD_LENGTH)
+          * codec->getMaxExpansion()) {
+        return false;
+    }
+    std::string decompressed(size, '\0');
+    if ((size > 0)
+        && !codec->decompress(payload.data() + SIZE_FIELD_LENGTH,
+                              payload.size() - SIZE_FIELD_LENGTH,
+                              decompressed)) {
+        return false;
+    }
+
+    payload.swap(decompressed);
+    wireSchema.erase(0, separator + 1);
+    return true;
+}
+
+}
+}
+}
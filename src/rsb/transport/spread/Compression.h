@@ -0,0 +1,162 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#pragma once
+
+#include <string>
+#include <set>
+
+#include <boost/shared_ptr.hpp>
+
+#include "rsb/transport/spread/rsbspreadexports.h"
+
+namespace rsb {
+namespace transport {
+namespace spread {
+
+/**
+ * A compression algorithm which can be applied to serialized
+ * payloads.
+ *
+ * @author jmoringe
+ */
+class RSBSPREAD_EXPORT PayloadCodec {
+public:
+    virtual ~PayloadCodec();
+
+    /**
+     * Returns the name under which the codec is announced in the
+     * wire schema of compressed notifications.
+     *
+     * @return The name of the codec.
+     */
+    virtual std::string getName() const = 0;
+
+    /**
+     * Appends the compressed form of @a input to @a output.
+     *
+     * @param input The data which should be compressed.
+     * @param output The string to which the compressed data should be
+     *               appended.
+     */
+    virtual void compress(const std::string& input,
+                          std::string&       output) const = 0;
+
+    /**
+     * Decompresses @a size bytes at @a input into @a output which
+     * has already been resized to the size of the uncompressed
+     * data.
+     *
+     * @return @c true if the data could be decompressed and had
+     *         exactly the expected size, @c false otherwise.
+     */
+    virtual bool decompress(const char*  input,
+                            std::size_t  size,
+                            std::string& output) const = 0;
+
+    /**
+     * Returns the largest ratio of uncompressed to compressed size
+     * which the codec can produce. Received payloads which claim a
+     * larger uncompressed size are rejected without allocating
+     * memory for them.
+     */
+    virtual std::size_t getMaxExpansion() const = 0;
+};
+
+typedef boost::shared_ptr<PayloadCodec> PayloadCodecPtr;
+
+/**
+ * Returns the names of all codecs supported by this build.
+ *
+ * @return A set of codec names.
+ */
+RSBSPREAD_EXPORT std::set<std::string> availablePayloadCodecs();
+
+/**
+ * Returns the codec named @a name.
+ *
+ * @param name The name of the codec. "none" designates the absence
+ *             of compression.
+ * @return The requested codec or an empty pointer if @a name is
+ *         "none".
+ * @throw std::invalid_argument If the codec is not supported by this
+ *                              build.
+ */
+RSBSPREAD_EXPORT PayloadCodecPtr findPayloadCodec(const std::string& name);
+
+/**
+ * Compresses @a payload using @a codec unless it is smaller than
+ * @a threshold or does not shrink. When compressing, @a wireSchema
+ * is changed to indicate the codec such that @ref
+ * maybeDecompressPayload can restore the original data and wire
+ * schema.
+ *
+ * @param codec The codec which should be used.
+ * @param threshold Payloads smaller than this number of bytes are
+ *                  not compressed.
+ * @param payload The serialized payload.
+ * @param wireSchema The wire schema of the payload. Replaced by the
+ *                   wire schema of the compressed payload when
+ *                   compressing.
+ * @param compressed Receives the compressed payload when
+ *                   compressing.
+ * @return @c true if the payload has been compressed, @c false
+ *         otherwise.
+ */
+RSBSPREAD_EXPORT bool maybeCompressPayload(const PayloadCodec& codec,
+                                           std::size_t         threshold,
+                                           const std::string&  payload,
+                                           std::string&        wireSchema,
+                                           std::string&        compressed);
+
+/**
+ * Tells whether @a wireSchema designates a compressed payload.
+ */
+RSBSPREAD_EXPORT bool isCompressedWireSchema(const std::string& wireSchema);
+
+/**
+ * Restores the payload and wire schema of a notification which has
+ * been compressed by @ref maybeCompressPayload. Does nothing if the
+ * payload is not compressed.
+ *
+ * @param wireSchema The wire schema of the received
+ *                   notification. Replaced by the original wire
+ *                   schema.
+ * @param payload The received payload. Replaced by the decompressed
+ *                payload.
+ * @return @c false if the payload is compressed but could not be
+ *         decompressed, e.g. because the codec is not supported by
+ *         this build or the announced uncompressed size exceeds
+ *         what the codec can produce from the compressed data.
+ *         @a wireSchema and @a payload are not modified in that
+ *         case.
+ */
+RSBSPREAD_EXPORT bool maybeDecompressPayload(std::string& wireSchema,
+                                             std::string& payload);
+
+}
+}
+}
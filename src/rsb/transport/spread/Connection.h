@@ -0,0 +1,162 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#pragma once
+
+#include <string>
+
+#include <boost/shared_ptr.hpp>
+
+#include <rsc/runtime/Printable.h>
+
+#include "SpreadMessage.h"
+
+#include "rsb/transport/spread/rsbspreadexports.h"
+
+namespace rsb {
+namespace transport {
+namespace spread {
+
+/**
+ * Interface of connections to a Spread daemon or to something which
+ * behaves like one.
+ *
+ * Messages are sent to Spread groups. Each active connection has a
+ * unique private group to which messages addressed to only this
+ * connection are sent. A message sent to multiple groups is received
+ * at most once by each member of any of the groups. Messages are not
+ * delivered to the connection which sent them.
+ *
+ * @note Implementations are generally not thread-safe. The only
+ *       exception to this rule is #interruptReceive. It can be used
+ *       to terminate the receiver thread of the connection.
+ *
+ * @author jmoringe
+ */
+class RSBSPREAD_EXPORT Connection : public rsc::runtime::Printable {
+public:
+    virtual ~Connection();
+
+    virtual const std::string getTransportURL() const = 0;
+
+    /**
+     * Returns the name of the private group of this connection.
+     *
+     * @return The name of the private group or the empty string if
+     *         the connection is not active.
+     */
+    virtual const std::string& getPrivateGroup() const = 0;
+
+    /**
+     * Tells if this connection is active.
+     *
+     * @return @c true if active
+     */
+    virtual bool isActive() const = 0;
+
+    /**
+     * Activates the connection.
+     *
+     * @throw CommException error connecting to the daemon
+     * @throw rsc::misc::IllegalStateException already activated
+     */
+    virtual void activate() = 0;
+
+    /**
+     * Deactivates the connection.
+     *
+     * @pre there must be no more reader blocking in #receive
+     * @throw rsc::misc::IllegalStateException already deactivated
+     */
+    virtual void deactivate() = 0;
+
+    /**
+     * Joins the Spread group @a group.
+     *
+     * @param group Name of the group
+     * @throw rsc::misc::IllegalStateException connection was not active
+     * @throw CommException error joining
+     */
+    virtual void join(const std::string& group) = 0;
+
+    /**
+     * Leaves the Spread group @a group.
+     *
+     * @param group Name of the Spread group.
+     * @throw rsc::misc::IllegalStateException connection was not active
+     * @throw CommException error leaving
+     */
+    virtual void leave(const std::string& group) = 0;
+
+    /**
+     * Receives the next message from this connection into @a message.
+     *
+     * Blocks until a message is available.
+     *
+     * @param message out parameter with the message to fill with the read contents
+     * @throw rsc::misc::IllegalStateException connection was not active
+     * @throw CommException communication error receiving a message
+     * @throw boost::thread_interrupted if receiving was interrupted using
+     *                                  #interruptReceive
+     */
+    virtual void receive(SpreadMessage& message) = 0;
+
+    /**
+     * Sends @a message to the groups of @a message.
+     *
+     * @param message message to send
+     * @throw rsc::misc::IllegalStateException connection was not active
+     * @throw CommException communication error sending the message
+     */
+    virtual void send(const SpreadMessage& message) = 0;
+
+    /**
+     * Returns the number of bytes of received messages which are
+     * waiting to be read by #receive.
+     *
+     * @return The number of waiting bytes.
+     * @throw rsc::misc::IllegalStateException connection was not active
+     */
+    virtual int getPendingBytes() const = 0;
+
+    /**
+     * Interrupts a potential receiver blocking in #receive some time
+     * after this call. The receiver may receive all queued messages
+     * before being interrupted.
+     *
+     * @note this method may be called from a different thread than
+     *       the one blocking in #receive. Nevertheless only one other
+     *       thread at a time is allowed call this method.
+     * @throw rsc::misc::IllegalStateException connection was not active
+     */
+    virtual void interruptReceive() = 0;
+};
+
+typedef boost::shared_ptr<Connection> ConnectionPtr;
+
+}
+}
+}
@@ -28,7 +28,10 @@
 
 #include <boost/format.hpp>
 
-#include <rsb/CommException.h>
+#include <rsb/protocol/ProtocolException.h>
+
+#include "Compression.h"
+#include "WireFormat.h"
 
 using namespace rsc::logging;
 
@@ -38,7 +41,11 @@ namespace spread {
 
 DeserializingHandler::DeserializingHandler() :
     logger(rsc::logging::Logger::getLogger("rsb.transport.spread.DeserializingHandler")),
-    assemblyPool(new AssemblyPool()) {
+    assemblyPool(new AssemblyPool()),
+    fragmentPool(new FragmentPool()),
+    trackSequenceNumbers(true),
+    metrics(new MetricsRegistry()),
+    scopeMetrics(false) {
 }
 
 DeserializingHandler::~DeserializingHandler() {
@@ -48,6 +55,25 @@ void DeserializingHandler::setPruning(const bool& pruning) {
     this->assemblyPool->setPruning(pruning);
 }
 
+void DeserializingHandler::setMetrics(MetricsRegistryPtr metrics) {
+    this->assemblyPool->setMetrics(metrics);
+    this->metrics = metrics;
+}
+
+void DeserializingHandler::setScopeMetrics(bool scopeMetrics) {
+    this->scopeMetrics = scopeMetrics;
+}
+
+void DeserializingHandler::setTrackSequenceNumbers(bool track) {
+    this->trackSequenceNumbers = track;
+}
+
+void DeserializingHandler::collectNacks(unsigned int delayMs,
+                                        unsigned int maxNacks,
+                                        std::vector<AssemblyPool::NackRequest>& requests) {
+    this->assemblyPool->collectNacks(delayMs, maxNacks, requests);
+}
+
 IncomingNotificationPtr
 DeserializingHandler::handleMessage(const SpreadMessage& message) {
     // Ignore all non-regular messages.
@@ -55,11 +81,118 @@ DeserializingHandler::handleMessage(const SpreadMessage& message) {
         return IncomingNotificationPtr();
     }
 
-    // Deserialize notification fragment from Spread message.
+    rsb::protocol::NotificationPtr notification;
+    if (isCompactMessage(message.getData())
+        && (compactMessageKind(message.getData()) == COMPACT_PARITY_FRAGMENT)) {
+        // Parity fragments can only complete a pending assembly.
+        ParityFragmentPtr parity(new ParityFragment());
+        if (!decodeParityFragment(message.getData(), *parity)) {
+            throw rsb::protocol::ProtocolException("Failed to parse parity fragment");
+        }
+        notification = this->assemblyPool->addParity(parity, message.getSender());
+    } else {
+        notification = handleFragment(message);
+    }
+    if (!notification) {
+        return IncomingNotificationPtr();
+    }
+
+    IncomingNotificationPtr result(new IncomingNotification());
+    result->scope                 = Scope(notification->scope());
+    // Move wire schema and payload out of the protobuf message
+    // instead of copying them. Apart from the header fields used
+    // for filling events, the message is only kept alive to own
+    // them.
+    result->wireSchema.swap(*notification->mutable_wire_schema());
+    result->serializedPayload.swap(*notification->mutable_data());
+    result->notification          = notification.get();
+    result->notificationOwnership = notification;
+    result->sender                = message.getSender();
+
+    if (this->trackSequenceNumbers) {
+        trackSequenceNumber(*result);
+    }
+
+    // Restore compressed payloads. If that is not possible, the
+    // notification is passed on unmodified and the compressed wire
+    // schema causes the receiving connectors to report an error.
+    if (!maybeDecompressPayload(result->wireSchema, result->serializedPayload)) {
+        RSCWARN(this->logger,
+                (boost::format("Could not decompress payload with wire "
+                               "schema '%1%'")
+                 % result->wireSchema));
+    }
+
+    return result;
+}
+
+void DeserializingHandler::trackSequenceNumber(IncomingNotification& notification) {
+    const rsb::protocol::EventId& eventId = notification.notification->event_id();
+    SequenceTracker::Observation observation
+        = this->sequenceTracker.observe(eventId.sender_id(),
+                                        eventId.sequence_number());
+    if (observation.kind == SequenceTracker::Observation::IN_ORDER) {
+        return;
+    }
+
+    MetricLabels labels;
+    if (this->scopeMetrics) {
+        labels.add("scope", notification.scope.toString());
+    }
+    switch (observation.kind) {
+    case SequenceTracker::Observation::GAP:
+        RSCDEBUG(this->logger,
+                 (boost::format("%1% notification(s) missing before sequence "
+                                "number %2% on scope %3%")
+                  % observation.numMissing % eventId.sequence_number()
+                  % notification.scope));
+        notification.numMissing = observation.numMissing;
+        this->metrics->getCounter
+            ("rsb_spread_notifications_missing_total",
+             "Notifications detected as missing from sequence number gaps.",
+             labels)
+            .increment(observation.numMissing);
+        break;
+    case SequenceTracker::Observation::REORDERED:
+        this->metrics->getCounter
+            ("rsb_spread_notifications_reordered_total",
+             "Notifications received after a later one of the same sender.",
+             labels)
+            .increment();
+        break;
+    case SequenceTracker::Observation::DUPLICATE:
+        this->metrics->getCounter
+            ("rsb_spread_notifications_duplicate_total",
+             "Notifications received more than once.",
+             labels)
+            .increment();
+        break;
+    default:
+        break;
+    }
+}
+
+rsb::protocol::NotificationPtr
+DeserializingHandler::handleFragment(const SpreadMessage& message) {
+    // Deserialize notification fragment from Spread message. Parsing
+    // into a recycled fragment object avoids most allocations.
     rsb::protocol::FragmentedNotificationPtr
-        fragment(new rsb::protocol::FragmentedNotification());
-    if (!fragment->ParseFromString(message.getData())) {
-        throw CommException("Failed to parse notification in pbuf format");
+        fragment = this->fragmentPool->acquire();
+    if (isCompactMessage(message.getData())) {
+        if (compactMessageKind(message.getData())
+            != COMPACT_CONTINUATION_FRAGMENT) {
+            RSCDEBUG(this->logger,
+                     (boost::format("Ignoring compact message of unknown kind %1%")
+                      % unsigned(compactMessageKind(message.getData()))));
+            return rsb::protocol::NotificationPtr();
+        }
+        if (!decodeContinuationFragment(message.getData(), *fragment)) {
+            throw rsb::protocol::ProtocolException
+                ("Failed to parse compact notification fragment");
+        }
+    } else if (!fragment->ParseFromString(message.getData())) {
+        throw rsb::protocol::ProtocolException
+            ("Failed to parse notification in pbuf format");
     }
 
     RSCTRACE(this->logger,
@@ -70,26 +203,15 @@ DeserializingHandler::handleMessage(const SpreadMessage& message) {
               % fragment->data_part() % fragment->num_data_parts()));
 
     // Assemble complete notification from parts, if necessary.
-    rsb::protocol::NotificationPtr notification
-        = maybeJoinFragments(fragment);
-    if (!notification) {
-        return IncomingNotificationPtr();
-    }
-
-    IncomingNotificationPtr result(new IncomingNotification());
-    result->scope                 = Scope(notification->scope());
-    result->wireSchema            = notification->wire_schema();
-    result->serializedPayload     = notification->data();
-    result->notification          = notification.get();
-    result->notificationOwnership = notification;
-    return result;
+    return maybeJoinFragments(fragment, message.getSender());
 }
 
 rsb::protocol::NotificationPtr
-DeserializingHandler::maybeJoinFragments(rsb::protocol::FragmentedNotificationPtr fragment) {
+DeserializingHandler::maybeJoinFragments(rsb::protocol::FragmentedNotificationPtr fragment,
+                                         const std::string&                       senderGroup) {
     // Build data from parts.
     if (fragment->num_data_parts() > 1) {
-        return this->assemblyPool->add(fragment);
+        return this->assemblyPool->add(fragment, senderGroup);
     } else {
         return rsb::protocol::NotificationPtr
             (fragment->mutable_notification(),
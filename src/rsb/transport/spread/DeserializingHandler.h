@@ -26,13 +26,18 @@
 
 #pragma once
 
+#include <boost/atomic.hpp>
+
 #include <rsc/logging/Logger.h>
 
 #include <rsb/protocol/FragmentedNotification.h>
 
 #include "SpreadMessage.h"
 #include "Assembly.h"
+#include "FragmentPool.h"
 #include "Notifications.h"
+#include "Metrics.h"
+#include "SequenceTracker.h"
 
 #include "rsb/transport/spread/rsbspreadexports.h"
 
@@ -59,6 +64,46 @@ public:
      */
     void setPruning(const bool& pruning);
 
+    /**
+     * Makes the handler record metrics about fragment assembly and
+     * about lost, reordered and duplicated notifications in
+     * @a metrics.
+     *
+     * @param metrics The registry in which metrics should be
+     *                recorded.
+     */
+    void setMetrics(MetricsRegistryPtr metrics);
+
+    /**
+     * Enables labeling metrics about lost, reordered and duplicated
+     * notifications with their scopes.
+     *
+     * @param scopeMetrics @c true to label metrics with scopes.
+     */
+    void setScopeMetrics(bool scopeMetrics);
+
+    /**
+     * Enables or disables tracking the sequence numbers of received
+     * notifications. Enabled by default. Thread-safe method.
+     *
+     * Sequence numbers are consecutive per sender across all scopes
+     * it sends on. Tracking only yields meaningful results if every
+     * notification of a sender is received, otherwise notifications
+     * on scopes which are not received are reported as missing.
+     *
+     * @param track @c true to classify sequence numbers and record
+     *              missing notifications.
+     */
+    void setTrackSequenceNumbers(bool track);
+
+    /**
+     * Collects requests for missing fragments of incomplete
+     * notifications. See @ref AssemblyPool::collectNacks.
+     */
+    void collectNacks(unsigned int                            delayMs,
+                      unsigned int                            maxNacks,
+                      std::vector<AssemblyPool::NackRequest>& requests);
+
     /**
      * Handles received Spread messages.
      *
@@ -67,6 +112,9 @@ public:
      *
      * @param message Spread message to handle
      * @return pointer to the joined notification
+     * @throw rsb::protocol::ProtocolException if @a message is not a
+     *        well-formed notification fragment or does not fit the
+     *        fragments received before
      */
     IncomingNotificationPtr handleMessage(const SpreadMessage& message);
 private:
@@ -74,8 +122,32 @@ private:
 
     AssemblyPoolPtr assemblyPool;
 
+    FragmentPoolPtr fragmentPool;
+
+    SequenceTracker     sequenceTracker;
+    boost::atomic<bool> trackSequenceNumbers;
+
+    MetricsRegistryPtr metrics;
+    bool               scopeMetrics;
+
+    /**
+     * Parses the data fragment in @a message and adds it to its
+     * assembly, if necessary.
+     *
+     * @return The complete notification or a 0 pointer.
+     */
+    rsb::protocol::NotificationPtr handleFragment(const SpreadMessage& message);
+
     rsb::protocol::NotificationPtr
-    maybeJoinFragments(rsb::protocol::FragmentedNotificationPtr fragment);
+    maybeJoinFragments(rsb::protocol::FragmentedNotificationPtr fragment,
+                       const std::string&                       senderGroup);
+
+    /**
+     * Classifies the sequence number of @a notification, records
+     * metrics for unexpected ones and stores the number of missing
+     * predecessors in @a notification.
+     */
+    void trackSequenceNumber(IncomingNotification& notification);
 };
 
 }
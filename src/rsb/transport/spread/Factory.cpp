@@ -26,11 +26,23 @@
 
 #include "Factory.h"
 
+#include <algorithm>
+#include <stdexcept>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <rsb/CommException.h>
+
 #include <rsb/converter/ConverterSelectionStrategy.h>
 
 #include "InConnector.h"
 #include "OutConnector.h"
 #include "BusImpl.h"
+#include "SpreadConnection.h"
+#include "CapturingConnection.h"
+#include "FailoverConnection.h"
+#include "Compression.h"
 
 using namespace std;
 
@@ -40,21 +52,170 @@ namespace spread {
 
 typedef rsb::converter::ConverterSelectionStrategy<std::string>::Ptr ConverterSelectionStrategyPtr;
 
+namespace {
+
+std::string daemonListString(const std::vector< std::pair<std::string, unsigned int> >& daemons) {
+    std::string result;
+    for (std::vector< std::pair<std::string, unsigned int> >::const_iterator it
+             = daemons.begin(); it != daemons.end(); ++it) {
+        if (!result.empty()) {
+            result += ", ";
+        }
+        result += boost::str(boost::format("%1%:%2%") % it->first % it->second);
+    }
+    return result;
+}
+
+ConnectionPtr createSpreadConnection(const std::string& host, unsigned int port) {
+    return SpreadConnectionPtr(new SpreadConnection(host, port));
+}
+
+/**
+ * Installs the notification filters requested by the options
+ * "filtermethod", "filterorigin" and "filteruserinfo" of @a args.
+ *
+ * "filterorigin" accepts a participant id which can be prefixed with
+ * "!" to exclude instead of select that origin. "filteruserinfo"
+ * accepts either "KEY" or "KEY=VALUE".
+ */
+void addNotificationFilters(InConnector& connector,
+                            const rsc::runtime::Properties& args) {
+    if (args.has("filtermethod")) {
+        connector.addNotificationFilter(NotificationFilterPtr(
+                new MethodNotificationFilter(args.get<string>("filtermethod"))));
+    }
+    if (args.has("filterorigin")) {
+        string origin = args.get<string>("filterorigin");
+        bool invert = !origin.empty() && (origin[0] == '!');
+        if (invert) {
+            origin.erase(0, 1);
+        }
+        connector.addNotificationFilter(NotificationFilterPtr(
+                new OriginNotificationFilter(rsc::misc::UUID(origin), invert)));
+    }
+    if (args.has("filteruserinfo")) {
+        string spec = args.get<string>("filteruserinfo");
+        string::size_type separator = spec.find('=');
+        NotificationFilterPtr filter;
+        if (separator == string::npos) {
+            filter.reset(new UserInfoNotificationFilter(spec));
+        } else {
+            filter.reset(new UserInfoNotificationFilter(
+                    spec.substr(0, separator), spec.substr(separator + 1)));
+        }
+        connector.addNotificationFilter(filter);
+    }
+}
+
+/**
+ * Keeps the groups of scopes joined without handling notifications.
+ */
+class WarmUpSink : public Bus::Sink {
+public:
+    void handleNotification(NotificationPtr /*notification*/) {
+    }
+
+    void handleError(const std::exception& /*error*/) {
+    }
+};
+
+}
+
 Factory::Factory()
-    : logger(rsc::logging::Logger::getLogger("rsb.transport.spread.Factory")) {
+    : logger(rsc::logging::Logger::getLogger("rsb.transport.spread.Factory")),
+      connectionFactory(&createSpreadConnection),
+      metrics(new MetricsRegistry()) {
 }
 
-BusPtr Factory::obtainBus(const HostAndPort& options) {
-    RSCDEBUG(this->logger, (boost::format("Obtaining bus for host = %1%, port = %2%")
-                            % options.first % options.second));
+Factory::Factory(ConnectionFactory connectionFactory)
+    : logger(rsc::logging::Logger::getLogger("rsb.transport.spread.Factory")),
+      connectionFactory(connectionFactory),
+      metrics(new MetricsRegistry()) {
+}
+
+Factory::~Factory() {
+    boost::mutex::scoped_lock lock(this->metricsDumpLock);
 
+    if (this->metricsDumpTask) {
+        this->metricsDumpTask->cancel();
+        this->metricsDumpTask->waitDone();
+    }
+}
+
+MetricsRegistryPtr Factory::getMetrics() const {
+    return this->metrics;
+}
+
+void Factory::maybeStartMetricsDump(const rsc::runtime::Properties& args) {
+    if (!args.has("metricsfile")) {
+        return;
+    }
+
+    boost::mutex::scoped_lock lock(this->metricsDumpLock);
+
+    // The first participant requesting a dump determines the file
+    // and interval.
+    if (!this->metricsDumpTask) {
+        std::string fileName = args.get<string>("metricsfile");
+        unsigned int intervalMs = args.getAs<unsigned int>("metricsinterval", 10000);
+        RSCINFO(this->logger, (boost::format("Writing metrics to %1% every %2% ms")
+                               % fileName % intervalMs));
+        this->metricsDumpTask.reset(new MetricsDumpTask(this->metrics,
+                                                        fileName,
+                                                        intervalMs));
+        this->metricsExecutor.schedule(this->metricsDumpTask);
+    }
+}
+
+void Factory::warmUp(const rsc::runtime::Properties& args) {
+    BusPtr bus = obtainBus(args);
+
+    std::vector<string> scopes;
+    string spec = args.get<string>("warmupscopes", "");
+    boost::algorithm::split(scopes, spec, boost::algorithm::is_any_of(", "),
+                            boost::algorithm::token_compress_on);
+    Bus::SinkPtr sink(new WarmUpSink());
+    for (std::vector<string>::const_iterator it = scopes.begin();
+         it != scopes.end(); ++it) {
+        if (!it->empty()) {
+            bus->addSink(Scope(*it), sink);
+        }
+    }
+
+    RSCINFO(this->logger, (boost::format("Warmed up %1%") % bus));
+
+    boost::mutex::scoped_lock lock(this->warmUpLock);
+    this->warmBuses.push_back(bus);
+}
+
+void Factory::releaseWarmBuses() {
+    std::vector<BusPtr> buses;
+    {
+        boost::mutex::scoped_lock lock(this->warmUpLock);
+        buses.swap(this->warmBuses);
+    }
+}
+
+Factory::PendingBus::PendingBus() :
+    done(false) {
+}
+
+BusPtr Factory::obtainBus(const rsc::runtime::Properties& args) {
+    DaemonList daemons = parseDaemons(args);
+    RSCDEBUG(this->logger, (boost::format("Obtaining bus for daemons %1%")
+                            % daemonListString(daemons)));
+
+    // busesLock is only held for lookups, such that connecting to
+    // one list of daemons does not block obtaining buses for others.
+    PendingBusPtr pending;
+    CaptureWriterPtr captureWriter;
     {
         boost::mutex::scoped_lock lock(this->busesLock);
 
-        // Try to find an existing Bus instance for options. If there
-        // is an instance, try to lock the pointer to see whether it
-        // is still alive. If so, return it.
-        BusMap::iterator it = this->buses.find(options);
+        // Try to find an existing Bus instance for the daemons. If
+        // there is an instance, try to lock the pointer to see
+        // whether it is still alive. If so, return it.
+        BusMap::iterator it = this->buses.find(daemons);
         if (it != this->buses.end()) {
             BusPtr bus = it->second.lock();
             if (bus) {
@@ -65,16 +226,159 @@ BusPtr Factory::obtainBus(const HostAndPort& options) {
             }
         }
 
-        // If there was no suitable Bus instance or the existing
-        // instance was dead, create a new one and store a weak
-        // pointer in the map.
-        SpreadConnectionPtr connection(new SpreadConnection(options.first, options.second));
-        BusPtr bus = BusImpl::create(connection);
-        RSCDEBUG(this->logger, (boost::format("Created new %1%") % bus));
-        bus->activate();
-        this->buses[options] = bus;
-        return bus;
+        // If another participant is creating the bus, wait for the
+        // result.
+        PendingBusMap::iterator pendingIt = this->pendingBuses.find(daemons);
+        if (pendingIt != this->pendingBuses.end()) {
+            pending = pendingIt->second;
+            lock.unlock();
+
+            RSCDEBUG(this->logger,
+                     (boost::format("Waiting for creation of bus for daemons %1%")
+                      % daemonListString(daemons)));
+            return waitForBus(pending);
+        }
+
+        string captureFile = args.get<string>("capturefile", "");
+        if (!captureFile.empty()) {
+            captureWriter = obtainCaptureWriter(captureFile);
+        }
+
+        pending.reset(new PendingBus());
+        this->pendingBuses[daemons] = pending;
+    }
+
+    // Otherwise create a new bus and store a weak pointer in the
+    // map. Participants waiting for the bus receive the result or
+    // the error.
+    BusPtr bus;
+    try {
+        bus = createBus(daemons, args, captureWriter);
+    } catch (const std::exception& e) {
+        finishPendingBus(daemons, pending, BusPtr(), e.what());
+        throw;
+    } catch (...) {
+        // For example boost::thread_interrupted. Waiting participants
+        // must be woken up in any case.
+        finishPendingBus(daemons, pending, BusPtr(),
+                         "creation was aborted by an unknown exception");
+        throw;
+    }
+    finishPendingBus(daemons, pending, bus, "");
+    return bus;
+}
+
+void Factory::finishPendingBus(const DaemonList&  daemons,
+                               PendingBusPtr      pending,
+                               BusPtr             bus,
+                               const std::string& error) {
+    {
+        boost::mutex::scoped_lock lock(this->busesLock);
+        if (bus) {
+            this->buses[daemons] = bus;
+        }
+        this->pendingBuses.erase(daemons);
+    }
+
+    {
+        boost::mutex::scoped_lock lock(pending->mutex);
+        pending->done  = true;
+        pending->bus   = bus;
+        pending->error = error;
+    }
+    pending->condition.notify_all();
+}
+
+BusPtr Factory::createBus(const DaemonList&               daemons,
+                          const rsc::runtime::Properties& args,
+                          CaptureWriterPtr                captureWriter) {
+    // The number of connections, the daemon mode, the clock
+    // synchronization interval, the NACK delay, capturing and
+    // reconnecting are determined by the participant which causes
+    // the creation of the bus.
+    unsigned int numConnections = parseNumConnections(args);
+    bool distribute = parseDistribute(args);
+    if (distribute) {
+        numConnections = std::max<std::size_t>(numConnections,
+                                               daemons.size());
+    }
+
+    // Each connection fails over between all daemons. When
+    // distributing, connection i prefers daemon i modulo the number
+    // of daemons and notifications are assigned to connections by
+    // scope hash. Otherwise, all connections prefer the first
+    // daemon. In both modes, the primary connection, which receives
+    // and joins groups, moves to another daemon if its daemon fails.
+    std::vector<ConnectionPtr> connections;
+    for (unsigned int i = 0; i < numConnections; ++i) {
+        if (daemons.size() == 1) {
+            connections.push_back(this->connectionFactory(daemons[0].first,
+                                                          daemons[0].second));
+        } else {
+            std::size_t first = distribute ? (i % daemons.size()) : 0;
+            std::vector<ConnectionPtr> candidates;
+            for (std::size_t j = 0; j < daemons.size(); ++j) {
+                const HostAndPort& daemon
+                    = daemons[(first + j) % daemons.size()];
+                candidates.push_back(this->connectionFactory(daemon.first,
+                                                             daemon.second));
+            }
+            connections.push_back(FailoverConnectionPtr
+                                  (new FailoverConnection(candidates)));
+        }
+    }
+
+    if (captureWriter) {
+        for (std::vector<ConnectionPtr>::iterator it = connections.begin();
+             it != connections.end(); ++it) {
+            it->reset(new CapturingConnection(*it, captureWriter));
+        }
+    }
+
+    // Failing over after a receive error requires reconnecting.
+    unsigned int defaultReconnect = (daemons.size() > 1) ? 1000 : 0;
+
+    BusPtr bus = BusImpl::create(connections.front(),
+                                 std::vector<ConnectionPtr>
+                                 (connections.begin() + 1,
+                                  connections.end()),
+                                 this->metrics);
+    boost::shared_ptr<BusImpl> busImpl
+        = boost::static_pointer_cast<BusImpl>(bus);
+    busImpl->setClockSyncInterval(args.getAs<unsigned int>("clocksync", 0));
+    busImpl->setNackDelay(args.getAs<unsigned int>("nackdelay", 0));
+    busImpl->setReconnect(args.getAs<unsigned int>("reconnect",
+                                                   defaultReconnect),
+                          args.getAs<unsigned int>("reconnectbuffer", 1000));
+    busImpl->setScopeMetrics(args.getAs<bool>("scopemetrics", false));
+    RSCDEBUG(this->logger, (boost::format("Created new %1%") % bus));
+    bus->activate();
+    return bus;
+}
+
+BusPtr Factory::waitForBus(PendingBusPtr pending) {
+    boost::mutex::scoped_lock lock(pending->mutex);
+    while (!pending->done) {
+        pending->condition.wait(lock);
     }
+
+    if (!pending->bus) {
+        throw CommException(boost::str(boost::format("Could not create bus: %1%")
+                                       % pending->error));
+    }
+    return pending->bus;
+}
+
+CaptureWriterPtr Factory::obtainCaptureWriter(const std::string& fileName) {
+    // The first bus requesting a capture determines the file. All
+    // buses append to the same file since a file can only have one
+    // writer.
+    if (!this->captureWriter) {
+        RSCINFO(this->logger, (boost::format("Capturing Spread messages to %1%")
+                               % fileName));
+        this->captureWriter.reset(new CaptureWriter(fileName));
+    }
+    return this->captureWriter;
 }
 
 Factory::HostAndPort Factory::parseOptions(const rsc::runtime::Properties& args) {
@@ -82,23 +386,108 @@ Factory::HostAndPort Factory::parseOptions(const rsc::runtime::Properties& args)
                      args.getAs<unsigned int>("port", defaultPort()));
 }
 
+Factory::DaemonList Factory::parseDaemons(const rsc::runtime::Properties& args) {
+    DaemonList daemons;
+    if (!args.has("daemons")) {
+        daemons.push_back(parseOptions(args));
+        return daemons;
+    }
+
+    // Entries are of the form HOST[:PORT] and separated by commas.
+    string spec = args.get<string>("daemons");
+    unsigned int port = args.getAs<unsigned int>("port", defaultPort());
+    std::vector<string> entries;
+    boost::algorithm::split(entries, spec, boost::algorithm::is_any_of(", "),
+                            boost::algorithm::token_compress_on);
+    for (std::vector<string>::const_iterator it = entries.begin();
+         it != entries.end(); ++it) {
+        if (it->empty()) {
+            continue;
+        }
+        string::size_type colon = it->rfind(':');
+        if (colon == string::npos) {
+            daemons.push_back(make_pair(*it, port));
+            continue;
+        }
+        string host = it->substr(0, colon);
+        try {
+            daemons.push_back
+                (make_pair(host.empty() ? defaultHost() : host,
+                           boost::lexical_cast<unsigned int>(it->substr(colon + 1))));
+        } catch (const boost::bad_lexical_cast&) {
+            throw std::invalid_argument(boost::str(boost::format("Invalid daemon"
+                                                                 " '%1%'.")
+                                                   % *it));
+        }
+    }
+    if (daemons.empty()) {
+        throw std::invalid_argument("List of daemons must not be empty.");
+    }
+    return daemons;
+}
+
+bool Factory::parseDistribute(const rsc::runtime::Properties& args) {
+    string mode = args.get<string>("daemonmode", "failover");
+    if (mode == "failover") {
+        return false;
+    } else if (mode == "distribute") {
+        return true;
+    } else {
+        throw std::invalid_argument(boost::str(boost::format("Invalid daemon mode"
+                                                             " '%1%'; must be"
+                                                             " 'failover' or"
+                                                             " 'distribute'.")
+                                               % mode));
+    }
+}
+
+unsigned int Factory::parseNumConnections(const rsc::runtime::Properties& args) {
+    unsigned int numConnections = args.getAs<unsigned int>("connections", 1);
+    if (numConnections == 0) {
+        throw std::invalid_argument("Number of connections must be at least 1.");
+    }
+    return numConnections;
+}
+
 rsb::transport::InConnector*
 Factory::createInConnector(const rsc::runtime::Properties& args) {
     RSCDEBUG(this->logger, "Creating InConnector with properties " << args);
 
-    return new InConnector(
+    maybeStartMetricsDump(args);
+
+    InConnector* connector = new InConnector(
             args.get<ConverterSelectionStrategyPtr>("converters"),
-            obtainBus(parseOptions(args)));
+            obtainBus(args));
+    connector->setShareLocalData(args.getAs<bool>("sharelocaldata", false));
+    connector->setLazyDeserialization(
+            args.getAs<bool>("lazydeserialization", false));
+    addNotificationFilters(*connector, args);
+    return connector;
 }
 
 rsb::transport::OutConnector*
 Factory::createOutConnector(const rsc::runtime::Properties& args) {
     RSCDEBUG(this->logger, "Creating OutConnector with properties " << args);
 
-    return new OutConnector(
+    maybeStartMetricsDump(args);
+
+    // Look up the codec first to fail before creating the connector
+    // in case it is not supported.
+    PayloadCodecPtr compressionCodec
+        = findPayloadCodec(args.get<string>("compression", "none"));
+
+    OutConnector* connector = new OutConnector(
             args.get<ConverterSelectionStrategyPtr>("converters"),
-            obtainBus(parseOptions(args)),
+            obtainBus(args),
             args.getAs<unsigned int>("maxfragmentsize", 100000));
+    connector->setCompression(compressionCodec,
+                              args.getAs<unsigned int>("compressionthreshold",
+                                                       4096));
+    connector->setCompactFragments(
+            args.getAs<bool>("compactfragments", false));
+    connector->setParityFragments(
+            args.getAs<unsigned int>("fecparity", 0));
+    return connector;
 }
 
 }
@@ -28,17 +28,25 @@
 
 #include <string>
 #include <utility>
+#include <vector>
 
+#include <boost/function.hpp>
 #include <boost/shared_ptr.hpp>
 
+#include <boost/thread/condition_variable.hpp>
 #include <boost/thread/mutex.hpp>
 
 #include <rsc/runtime/Properties.h>
 
+#include <rsc/threading/ThreadedTaskExecutor.h>
+
 #include <rsb/transport/InConnector.h>
 #include <rsb/transport/OutConnector.h>
 
 #include "Bus.h"
+#include "Connection.h"
+#include "Metrics.h"
+#include "CaptureFile.h"
 
 #include "rsb/transport/spread/rsbspreadexports.h"
 
@@ -48,29 +56,167 @@ namespace spread {
 
 class RSBSPREAD_EXPORT Factory {
 public:
+    /**
+     * Creates an inactive connection to the daemon at the given host
+     * and port.
+     */
+    typedef boost::function<ConnectionPtr (const std::string&, unsigned int)> ConnectionFactory;
+
     Factory();
 
+    /**
+     * @param connectionFactory Creates the connections of all buses
+     *                          instead of connecting to Spread
+     *                          daemons, for example to use @ref
+     *                          LoopbackConnection in tests.
+     */
+    explicit Factory(ConnectionFactory connectionFactory);
+
+    ~Factory();
+
     rsb::transport::InConnector*
     createInConnector(const rsc::runtime::Properties& args);
 
     rsb::transport::OutConnector*
     createOutConnector(const rsc::runtime::Properties& args);
+
+    /**
+     * Returns the registry in which all buses created by this
+     * factory and their connectors record metrics.
+     *
+     * @return The registry.
+     */
+    MetricsRegistryPtr getMetrics() const;
+
+    /**
+     * Creates the bus for the daemons specified in @a args and joins
+     * the groups of the scopes listed in the "warmupscopes" option,
+     * such that the first participants using the bus do not have to
+     * wait for connecting and joining. The bus is kept alive until
+     * the factory is destroyed or @ref releaseWarmBuses is called.
+     *
+     * @param args The transport options, usually from the default
+     *             participant configuration.
+     */
+    void warmUp(const rsc::runtime::Properties& args);
+
+    /**
+     * Releases the buses kept alive by @ref warmUp. They are
+     * destroyed unless used by participants.
+     */
+    void releaseWarmBuses();
 private:
 
     typedef std::pair<std::string, unsigned int> HostAndPort;
 
-    typedef std::map< HostAndPort, boost::weak_ptr<Bus> > BusMap;
+    typedef std::vector<HostAndPort> DaemonList;
+
+    typedef std::map< DaemonList, boost::weak_ptr<Bus> > BusMap;
+
+    /**
+     * The future result of creating a bus. Participants which
+     * request a bus while it is being created wait for the result
+     * instead of connecting again.
+     */
+    struct PendingBus {
+        PendingBus();
+
+        boost::mutex              mutex;
+        boost::condition_variable condition;
+        bool                      done;
+        BusPtr                    bus;
+        std::string               error;
+    };
+
+    typedef boost::shared_ptr<PendingBus> PendingBusPtr;
+
+    typedef std::map<DaemonList, PendingBusPtr> PendingBusMap;
 
     rsc::logging::LoggerPtr logger;
 
+    ConnectionFactory       connectionFactory;
+
     BusMap                  buses;
+    PendingBusMap           pendingBuses;
 
     boost::mutex            busesLock;
 
-    BusPtr obtainBus(const HostAndPort& options);
+    MetricsRegistryPtr                   metrics;
+    rsc::threading::ThreadedTaskExecutor metricsExecutor;
+    rsc::threading::TaskPtr              metricsDumpTask;
+    boost::mutex                         metricsDumpLock;
+
+    CaptureWriterPtr                     captureWriter;
+
+    std::vector<BusPtr>                  warmBuses;
+    boost::mutex                         warmUpLock;
+
+    /**
+     * Returns the bus for the daemons specified in @a args, creating
+     * it if necessary. Options which configure the bus as a whole
+     * are taken from @a args of the participant which causes the
+     * creation of the bus.
+     */
+    BusPtr obtainBus(const rsc::runtime::Properties& args);
+
+    /**
+     * Creates and activates a bus for @a daemons configured by @a
+     * args. Called without @ref busesLock held since connecting may
+     * take long.
+     */
+    BusPtr createBus(const DaemonList&               daemons,
+                     const rsc::runtime::Properties& args,
+                     CaptureWriterPtr                captureWriter);
+
+    /**
+     * Stores the result of creating a bus for @a daemons in @a
+     * pending and wakes up participants waiting for it. @a bus is
+     * empty if the creation failed with @a error.
+     */
+    void finishPendingBus(const DaemonList&  daemons,
+                          PendingBusPtr      pending,
+                          BusPtr             bus,
+                          const std::string& error);
+
+    /**
+     * Waits for the creation of a bus by another participant to
+     * finish.
+     *
+     * @throw CommException if the creation failed.
+     */
+    static BusPtr waitForBus(PendingBusPtr pending);
+
+    /**
+     * Returns the writer which captures the messages of all buses,
+     * creating it for @a fileName if necessary. Must be called with
+     * @ref busesLock held.
+     */
+    CaptureWriterPtr obtainCaptureWriter(const std::string& fileName);
 
     static HostAndPort parseOptions(const rsc::runtime::Properties& args);
 
+    /**
+     * Returns the daemons of the "daemons" option in @a args or, if
+     * it is not present, the single daemon specified by the "host"
+     * and "port" options.
+     */
+    static DaemonList parseDaemons(const rsc::runtime::Properties& args);
+
+    /**
+     * Returns @c true if the "daemonmode" option in @a args requests
+     * distributing the connections of a bus over its daemons instead
+     * of connecting all of them to the first available daemon.
+     */
+    static bool parseDistribute(const rsc::runtime::Properties& args);
+
+    static unsigned int parseNumConnections(const rsc::runtime::Properties& args);
+
+    /**
+     * Starts periodically dumping metrics if requested in @a args
+     * and not already running.
+     */
+    void maybeStartMetricsDump(const rsc::runtime::Properties& args);
+
 };
 
 typedef boost::shared_ptr<Factory> FactoryPtr;
@@ -0,0 +1,147 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#include "FailoverConnection.h"
+
+#include <stdexcept>
+
+#include <boost/format.hpp>
+
+#include <rsc/misc/IllegalStateException.h>
+
+#include <rsb/CommException.h>
+
+namespace rsb {
+namespace transport {
+namespace spread {
+
+FailoverConnection::FailoverConnection(const std::vector<ConnectionPtr>& connections) :
+    logger(rsc::logging::Logger::getLogger("rsb.transport.spread.FailoverConnection")),
+    connections(connections), current(0), failed(false) {
+    if (this->connections.empty()) {
+        throw std::invalid_argument("At least one connection is required.");
+    }
+}
+
+void FailoverConnection::printContents(std::ostream& stream) const {
+    stream << "connections = " << this->connections.size()
+           << ", current = " << *this->connections[this->current];
+}
+
+const std::string FailoverConnection::getTransportURL() const {
+    return this->connections[this->current]->getTransportURL();
+}
+
+const std::string& FailoverConnection::getPrivateGroup() const {
+    return this->connections[this->current]->getPrivateGroup();
+}
+
+bool FailoverConnection::isActive() const {
+    return this->connections[this->current]->isActive();
+}
+
+void FailoverConnection::activate() {
+    if (isActive()) {
+        throw rsc::misc::IllegalStateException("Connection is already active.");
+    }
+
+    std::size_t start = this->current;
+    if (this->failed.exchange(false)) {
+        start = (start + 1) % this->connections.size();
+    }
+
+    std::string lastError;
+    for (std::size_t i = 0; i < this->connections.size(); ++i) {
+        std::size_t index = (start + i) % this->connections.size();
+        try {
+            this->connections[index]->activate();
+        } catch (const CommException& e) {
+            RSCWARN(this->logger,
+                    (boost::format("Could not connect to %1%: %2%")
+                     % this->connections[index]->getTransportURL() % e.what()));
+            lastError = e.what();
+            continue;
+        }
+
+        if (index != this->current) {
+            RSCINFO(this->logger,
+                    (boost::format("Failed over to %1%")
+                     % this->connections[index]->getTransportURL()));
+        }
+        this->current = index;
+        return;
+    }
+
+    throw CommException(boost::str(boost::format("Could not connect to any of"
+                                                 " %1% daemons. Last error: %2%")
+                                   % this->connections.size() % lastError));
+}
+
+void FailoverConnection::deactivate() {
+    this->connections[this->current]->deactivate();
+}
+
+void FailoverConnection::join(const std::string& group) {
+    this->connections[this->current]->join(group);
+}
+
+void FailoverConnection::leave(const std::string& group) {
+    this->connections[this->current]->leave(group);
+}
+
+void FailoverConnection::receive(SpreadMessage& message) {
+    try {
+        this->connections[this->current]->receive(message);
+    } catch (const CommException&) {
+        this->failed = true;
+        throw;
+    }
+}
+
+void FailoverConnection::send(const SpreadMessage& message) {
+    try {
+        this->connections[this->current]->send(message);
+    } catch (const CommException&) {
+        this->failed = true;
+        throw;
+    }
+}
+
+int FailoverConnection::getPendingBytes() const {
+    return this->connections[this->current]->getPendingBytes();
+}
+
+void FailoverConnection::interruptReceive() {
+    this->connections[this->current]->interruptReceive();
+}
+
+std::size_t FailoverConnection::getCurrentIndex() const {
+    return this->current;
+}
+
+}
+}
+}
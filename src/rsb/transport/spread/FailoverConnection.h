@@ -0,0 +1,111 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <boost/atomic.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <rsc/logging/Logger.h>
+
+#include "Connection.h"
+
+#include "rsb/transport/spread/rsbspreadexports.h"
+
+namespace rsb {
+namespace transport {
+namespace spread {
+
+/**
+ * A @ref Connection which uses one of several connections to
+ * different daemons at a time.
+ *
+ * Activating the connection tries the connections in order until
+ * one succeeds. If receiving or sending fails, the next activation
+ * starts with the connection following the failed one, such that a
+ * bus which reconnects after the failure fails over to the next
+ * daemon.
+ *
+ * @author jmoringe
+ */
+class RSBSPREAD_EXPORT FailoverConnection : public Connection {
+public:
+    /**
+     * @param connections The connections to the daemons in order of
+     *                    preference. Must not be empty.
+     */
+    explicit FailoverConnection(const std::vector<ConnectionPtr>& connections);
+
+    void printContents(std::ostream& stream) const;
+
+    const std::string getTransportURL() const;
+
+    const std::string& getPrivateGroup() const;
+
+    bool isActive() const;
+
+    /**
+     * @throw CommException if none of the connections could be
+     *                      activated.
+     */
+    void activate();
+    void deactivate();
+
+    void join(const std::string& group);
+    void leave(const std::string& group);
+
+    void receive(SpreadMessage& message);
+
+    void send(const SpreadMessage& message);
+
+    int getPendingBytes() const;
+
+    void interruptReceive();
+
+    /**
+     * Returns the index of the connection which is used currently or
+     * has been used last.
+     */
+    std::size_t getCurrentIndex() const;
+private:
+    rsc::logging::LoggerPtr    logger;
+
+    std::vector<ConnectionPtr> connections;
+
+    // current only changes while the connection is inactive. failed
+    // is set by the receiving and sending threads.
+    std::size_t                current;
+    boost::atomic<bool>        failed;
+};
+
+typedef boost::shared_ptr<FailoverConnection> FailoverConnectionPtr;
+
+}
+}
+}
@@ -0,0 +1,102 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#include "FragmentPool.h"
+
+namespace rsb {
+namespace transport {
+namespace spread {
+
+/**
+ * Deleter which returns fragments to their pool or deletes them if
+ * the pool no longer exists.
+ */
+class FragmentPool::Recycler {
+public:
+    Recycler(boost::weak_ptr<FragmentPool> pool) :
+        pool(pool) {
+    }
+
+    void operator()(rsb::protocol::FragmentedNotification* fragment) {
+        if (FragmentPoolPtr pool = this->pool.lock()) {
+            pool->release(fragment);
+        } else {
+            delete fragment;
+        }
+    }
+private:
+    boost::weak_ptr<FragmentPool> pool;
+};
+
+FragmentPool::FragmentPool(std::size_t maxSize,
+                           std::size_t maxRetainedPayloadSize) :
+    maxSize(maxSize), maxRetainedPayloadSize(maxRetainedPayloadSize) {
+}
+
+FragmentPool::~FragmentPool() {
+    for (FragmentList::iterator it = this->idle.begin();
+         it != this->idle.end(); ++it) {
+        delete *it;
+    }
+}
+
+rsb::protocol::FragmentedNotificationPtr FragmentPool::acquire() {
+    rsb::protocol::FragmentedNotification* fragment = 0;
+    {
+        boost::mutex::scoped_lock lock(this->mutex);
+        if (!this->idle.empty()) {
+            fragment = this->idle.back();
+            this->idle.pop_back();
+        }
+    }
+    if (!fragment) {
+        fragment = new rsb::protocol::FragmentedNotification();
+    }
+    return rsb::protocol::FragmentedNotificationPtr
+        (fragment, Recycler(shared_from_this()));
+}
+
+std::size_t FragmentPool::size() {
+    boost::mutex::scoped_lock lock(this->mutex);
+    return this->idle.size();
+}
+
+void FragmentPool::release(rsb::protocol::FragmentedNotification* fragment) {
+    // Do not keep huge payload buffers alive.
+    if (fragment->notification().data().capacity()
+        <= this->maxRetainedPayloadSize) {
+        boost::mutex::scoped_lock lock(this->mutex);
+        if (this->idle.size() < this->maxSize) {
+            this->idle.push_back(fragment);
+            return;
+        }
+    }
+    delete fragment;
+}
+
+}
+}
+}
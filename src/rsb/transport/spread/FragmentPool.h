@@ -0,0 +1,102 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#pragma once
+
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/weak_ptr.hpp>
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <rsb/protocol/FragmentedNotification.h>
+
+#include "rsb/transport/spread/rsbspreadexports.h"
+
+namespace rsb {
+namespace transport {
+namespace spread {
+
+/**
+ * A bounded pool of @ref rsb::protocol::FragmentedNotification
+ * objects which are reused for parsing received messages.
+ *
+ * Parsing into a previously used message reuses the strings,
+ * sub-messages and repeated fields allocated for earlier messages,
+ * such that parsing a typical fragment does not allocate
+ * memory. Acquired objects return to the pool when the last pointer
+ * to them is released, which may happen in any thread.
+ *
+ * Instances must be owned by a @c boost::shared_ptr.
+ *
+ * @author jmoringe
+ */
+class RSBSPREAD_EXPORT FragmentPool
+    : public boost::enable_shared_from_this<FragmentPool> {
+public:
+    /**
+     * @param maxSize Maximum number of idle objects kept in the pool.
+     * @param maxRetainedPayloadSize Objects whose payload buffer
+     *                               grew larger than this number of
+     *                               bytes are deleted instead of
+     *                               being kept in the pool.
+     */
+    FragmentPool(std::size_t maxSize                = 64,
+                 std::size_t maxRetainedPayloadSize = 1 << 20);
+    ~FragmentPool();
+
+    /**
+     * Returns an unused fragment object. Its contents are unspecified
+     * and have to be overwritten, for example by parsing.
+     *
+     * @return A fragment which returns to the pool when released.
+     */
+    rsb::protocol::FragmentedNotificationPtr acquire();
+
+    /**
+     * Returns the number of idle objects currently in the pool.
+     */
+    std::size_t size();
+private:
+    typedef std::vector<rsb::protocol::FragmentedNotification*> FragmentList;
+
+    class Recycler;
+
+    std::size_t   maxSize;
+    std::size_t   maxRetainedPayloadSize;
+
+    boost::mutex  mutex;
+    FragmentList  idle;
+
+    void release(rsb::protocol::FragmentedNotification* fragment);
+};
+
+typedef boost::shared_ptr<FragmentPool> FragmentPoolPtr;
+
+}
+}
+}
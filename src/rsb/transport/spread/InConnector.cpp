@@ -30,9 +30,12 @@
 
 #include <rsc/misc/langutils.h>
 #include <rsc/debug/DebugTools.h>
+#include <rsc/runtime/TypeStringTools.h>
 
 #include <rsb/MetaData.h>
 
+#include "LazyPayload.h"
+
 namespace rsb {
 namespace transport {
 namespace spread {
@@ -42,7 +45,9 @@ InConnector::InConnector(ConverterSelectionStrategyPtr converters,
     ConverterSelectingConnector<std::string>(converters),
     ConnectorBase(bus),
     logger(rsc::logging::Logger::getLogger("rsb.transport.spread.InConnector")),
-    errorStrategy(ParticipantConfig::ERROR_STRATEGY_LOG) {
+    errorStrategy(ParticipantConfig::ERROR_STRATEGY_LOG),
+    shareLocalData(false), lazyDeserialization(false),
+    sendToReceiveLatency(0), receiveToHandlerLatency(0) {
 }
 
 InConnector::~InConnector() {
@@ -54,6 +59,24 @@ InConnector::~InConnector() {
 void InConnector::activate() {
     ConnectorBase::activate();
 
+    // The scope cannot change while active, so the latency and
+    // handler duration histograms can be looked up once.
+    MetricsRegistryPtr metrics = this->bus->getMetrics();
+    if (metrics) {
+        MetricLabels labels = metricLabels();
+        this->sendToReceiveLatency = &metrics->getHistogram
+            ("rsb_spread_send_to_receive_latency_microseconds",
+             "Time from sending an event to receiving it.", labels);
+        this->receiveToHandlerLatency = &metrics->getHistogram
+            ("rsb_spread_receive_to_handler_latency_microseconds",
+             "Time from receiving an event to starting a handler for it.",
+             labels);
+    }
+    for (TimedHandlerList::iterator it = this->timedHandlers.begin();
+         it != this->timedHandlers.end(); ++it) {
+        it->second = lookUpHandlerDuration(*it->first);
+    }
+
     this->bus->addSink(this->scope,
                        boost::dynamic_pointer_cast<InConnector>
                        (enable_shared_from_this<rsb::transport::InConnector>::shared_from_this()));
@@ -83,14 +106,83 @@ void InConnector::setErrorStrategy(ParticipantConfig::ErrorStrategy strategy) {
     this->errorStrategy = strategy;
 }
 
+void InConnector::setShareLocalData(bool share) {
+    this->shareLocalData = share;
+}
+
+void InConnector::setLazyDeserialization(bool lazy) {
+    this->lazyDeserialization = lazy;
+}
+
+void InConnector::addLossHandler(eventprocessing::HandlerPtr handler) {
+    boost::mutex::scoped_lock lock(this->lossHandlersMutex);
+    this->lossHandlers.push_back(handler);
+}
+
+void InConnector::removeLossHandler(eventprocessing::HandlerPtr handler) {
+    boost::mutex::scoped_lock lock(this->lossHandlersMutex);
+    this->lossHandlers.remove(handler);
+}
+
+void InConnector::addNotificationFilter(NotificationFilterPtr filter) {
+    boost::mutex::scoped_lock lock(this->notificationFiltersMutex);
+    this->notificationFilters.push_back(filter);
+}
+
+void InConnector::removeNotificationFilter(NotificationFilterPtr filter) {
+    boost::mutex::scoped_lock lock(this->notificationFiltersMutex);
+    this->notificationFilters.remove(filter);
+}
+
+bool InConnector::matchNotificationFilters(const Notification& notification) {
+    boost::mutex::scoped_lock lock(this->notificationFiltersMutex);
+    for (std::list<NotificationFilterPtr>::const_iterator it
+             = this->notificationFilters.begin();
+         it != this->notificationFilters.end(); ++it) {
+        if (!(*it)->match(notification)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 void InConnector::handleNotification(NotificationPtr notification) {
+    // Drop the notification before deserializing the payload if it
+    // is not interesting.
+    if (!matchNotificationFilters(*notification)) {
+        return;
+    }
+
+    if (notification->numMissing > 0) {
+        deliverLossReport(*notification);
+    }
+
     EventPtr event = notificationToEvent(notification);
 
     if (event) {
+        boost::uint64_t receiveTime = event->getMetaData().getReceiveTime();
+        if (this->sendToReceiveLatency) {
+            // The send time is taken from the clock of the sending
+            // host. Correct by the estimated offset of that clock, if
+            // known, and clamp what remains of the disagreement.
+            boost::int64_t latency
+                = boost::int64_t(receiveTime)
+                - boost::int64_t(event->getMetaData().getSendTime())
+                + notification->clockOffset;
+            this->sendToReceiveLatency->record((latency > 0) ? latency : 0);
+        }
         try {
-            for (std::list<eventprocessing::HandlerPtr>::iterator it = this->handlers.begin();
-                 it != this->handlers.end(); ++it) {
-                (*it)->handle(event);
+            for (TimedHandlerList::iterator it = this->timedHandlers.begin();
+                 it != this->timedHandlers.end(); ++it) {
+                boost::uint64_t start = rsc::misc::currentTimeMicros();
+                if (this->receiveToHandlerLatency) {
+                    this->receiveToHandlerLatency->record
+                        ((start > receiveTime) ? start - receiveTime : 0);
+                }
+                it->first->handle(event);
+                if (it->second) {
+                    it->second->record(rsc::misc::currentTimeMicros() - start);
+                }
             }
         } catch (const std::exception& exception) {
             handleError("dispatching event to handlers", exception,
@@ -99,6 +191,48 @@ void InConnector::handleNotification(NotificationPtr notification) {
     }
 }
 
+void InConnector::addHandler(eventprocessing::HandlerPtr handler) {
+    transport::InConnector::addHandler(handler);
+
+    // Before activation, the histogram is looked up in activate
+    // since the scope may still change.
+    this->timedHandlers.push_back
+        (std::make_pair(handler,
+                        this->active ? lookUpHandlerDuration(*handler) : 0));
+}
+
+void InConnector::removeHandler(eventprocessing::HandlerPtr handler) {
+    transport::InConnector::removeHandler(handler);
+
+    for (TimedHandlerList::iterator it = this->timedHandlers.begin();
+         it != this->timedHandlers.end(); ++it) {
+        if (it->first == handler) {
+            this->timedHandlers.erase(it);
+            break;
+        }
+    }
+}
+
+MetricLabels InConnector::metricLabels() const {
+    MetricLabels labels;
+    if (this->bus->getScopeMetrics()) {
+        labels.add("scope", this->scope.toString());
+    }
+    return labels;
+}
+
+Histogram*
+InConnector::lookUpHandlerDuration(const eventprocessing::Handler& handler) const {
+    MetricsRegistryPtr metrics = this->bus->getMetrics();
+    if (!metrics) {
+        return 0;
+    }
+    return &metrics->getHistogram
+        ("rsb_spread_handler_duration_microseconds",
+         "Execution time of event handlers.",
+         metricLabels().add("handler", rsc::runtime::typeName(typeid(handler))));
+}
+
 void InConnector::handleError(const std::exception& error) {
     handleError("receiving Spread message", error,
                 "Skipping message", "Terminating");
@@ -108,13 +242,46 @@ EventPtr InConnector::notificationToEvent(NotificationPtr& notification) {
     EventPtr event(new Event());
 
     try {
-        ConverterPtr converter = getConverter(notification->wireSchema);
-        AnnotatedData deserialized
-            = converter->deserialize(notification->wireSchema,
-                                     notification->serializedPayload);
+        // Notifications originating in this process still carry the
+        // data of the sent event which can be used without a
+        // deserialization roundtrip.
+        const bool useLocalData
+            = this->shareLocalData && notification->localData.second;
+        if (this->lazyDeserialization) {
+            // The data is a LazyPayload regardless of the origin of
+            // the notification. Selecting the converter is cheap and
+            // reports missing converters here rather than in some
+            // handler.
+            LazyPayloadPtr payload;
+            if (useLocalData) {
+                payload.reset(new LazyPayload(notification,
+                                              notification->localData));
+            } else {
+                ConverterPtr converter = getConverter(notification->wireSchema);
+                payload.reset(new LazyPayload(notification, converter,
+                                              this->shareLocalData));
+            }
 
-        fillEvent(event, *notification->notification,
-                  deserialized.second, deserialized.first);
+            fillEvent(event, *notification->notification,
+                      payload, rsc::runtime::typeName<LazyPayload>());
+        } else if (useLocalData) {
+            fillEvent(event, *notification->notification,
+                      notification->localData.second,
+                      notification->localData.first);
+        } else {
+            // When sharing, other connectors using the same converter
+            // share the deserialized data. Otherwise each connector
+            // gets its own copy which its handlers may modify.
+            ConverterPtr converter = getConverter(notification->wireSchema);
+            AnnotatedData deserialized
+                = this->shareLocalData
+                ? notification->deserialize(converter)
+                : converter->deserialize(notification->wireSchema,
+                                         notification->serializedPayload);
+
+            fillEvent(event, *notification->notification,
+                      deserialized.second, deserialized.first);
+        }
 
         event->mutableMetaData().setReceiveTime();
     } catch (const std::exception& exception) {
@@ -125,6 +292,41 @@ EventPtr InConnector::notificationToEvent(NotificationPtr& notification) {
     return event;
 }
 
+void InConnector::deliverLossReport(const Notification& notification) {
+    // Dispatch to a copy such that handlers can add or remove loss
+    // handlers.
+    std::list<eventprocessing::HandlerPtr> handlers;
+    {
+        boost::mutex::scoped_lock lock(this->lossHandlersMutex);
+        handlers = this->lossHandlers;
+    }
+    if (handlers.empty()) {
+        return;
+    }
+
+    const rsb::protocol::EventId& eventId = notification.notification->event_id();
+
+    LossReportPtr report(new LossReport());
+    report->senderId
+        = rsc::misc::UUID((boost::uint8_t*) eventId.sender_id().c_str());
+    report->firstMissing = eventId.sequence_number() - notification.numMissing;
+    report->numMissing   = notification.numMissing;
+
+    EventPtr event(new Event(notification.scope, report,
+                             rsc::runtime::typeName<LossReport>()));
+    event->mutableMetaData().setReceiveTime();
+
+    try {
+        for (std::list<eventprocessing::HandlerPtr>::iterator it = handlers.begin();
+             it != handlers.end(); ++it) {
+            (*it)->handle(event);
+        }
+    } catch (const std::exception& exception) {
+        handleError("dispatching loss report to loss handlers", exception,
+                    "Continuing with next event", "Terminating");
+    }
+}
+
 void InConnector::handleError(const std::string&    context,
                               const std::exception& exception,
                               const std::string&    continueDescription,
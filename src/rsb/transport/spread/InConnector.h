@@ -27,6 +27,10 @@
 #pragma once
 
 #include <stdexcept>
+#include <list>
+#include <utility>
+
+#include <boost/thread/mutex.hpp>
 
 #include <rsc/logging/Logger.h>
 
@@ -40,6 +44,9 @@
 
 #include "ConnectorBase.h"
 #include "Notifications.h"
+#include "NotificationFilter.h"
+#include "Metrics.h"
+#include "SequenceTracker.h"
 #include "Bus.h"
 
 #include "rsb/transport/spread/rsbspreadexports.h"
@@ -71,6 +78,84 @@ public:
 
     void setErrorStrategy(ParticipantConfig::ErrorStrategy strategy);
 
+    /**
+     * Controls whether event data is shared with other connectors of
+     * the same process instead of being deserialized per connector.
+     *
+     * @param share If @c true, events created for notifications sent
+     *              by connectors of the same process share the data
+     *              object of the sent event instead of a
+     *              deserialized copy, and the data deserialized from
+     *              received notifications is shared with other
+     *              sharing connectors which use the same
+     *              converter. Handlers must then not modify the
+     *              data. Moreover, for local notifications, the data
+     *              type is the one chosen by the sender rather than
+     *              the one selected by the converters of this
+     *              connector.
+     */
+    void setShareLocalData(bool share);
+
+    /**
+     * Controls whether payloads are deserialized when events are
+     * created or only when handlers access them.
+     *
+     * @param lazy If @c true, the data of delivered events is a
+     *             @ref LazyPayload which holds the serialized payload
+     *             and deserializes it on first access. The type of
+     *             such events is the name of @ref LazyPayload. This
+     *             also applies to local notifications whose data is
+     *             shared (see @ref setShareLocalData), which are
+     *             delivered as already deserialized payloads.
+     */
+    void setLazyDeserialization(bool lazy);
+
+    /**
+     * Adds a handler which is informed about notifications which
+     * have not been received.
+     *
+     * Before each event which reveals missing notifications of its
+     * sender, an event with a @ref LossReport as data is delivered to
+     * the handlers added with this method. Such events are not
+     * delivered to the handlers added with @c addHandler. Their scope
+     * is the scope of the revealing notification, their type is the
+     * name of @ref LossReport and they have no id.
+     *
+     * Losses are only detected while the bus is a member of the group
+     * of the root scope, see @ref
+     * DeserializingHandler::setTrackSequenceNumbers.
+     *
+     * @param handler The handler to add.
+     */
+    void addLossHandler(eventprocessing::HandlerPtr handler);
+
+    /**
+     * Removes a handler previously added with @ref addLossHandler.
+     *
+     * @param handler The handler to remove.
+     */
+    void removeLossHandler(eventprocessing::HandlerPtr handler);
+
+    /**
+     * Adds a filter which is evaluated on the header of received
+     * notifications before their payloads are deserialized.
+     * Notifications not matched by all filters are dropped.
+     *
+     * @param filter The filter to add.
+     */
+    void addNotificationFilter(NotificationFilterPtr filter);
+
+    /**
+     * Removes a filter previously added with @ref
+     * addNotificationFilter.
+     *
+     * @param filter The filter to remove.
+     */
+    void removeNotificationFilter(NotificationFilterPtr filter);
+
+    void addHandler(eventprocessing::HandlerPtr handler);
+    void removeHandler(eventprocessing::HandlerPtr handler);
+
     void handleNotification(NotificationPtr notification);
 
     void handleError(const std::exception& error);
@@ -81,8 +166,41 @@ public:
 
     ParticipantConfig::ErrorStrategy errorStrategy;
 
+    bool shareLocalData;
+
+    bool lazyDeserialization;
+
+    boost::mutex                           lossHandlersMutex;
+    std::list<eventprocessing::HandlerPtr> lossHandlers;
+
+    boost::mutex                     notificationFiltersMutex;
+    std::list<NotificationFilterPtr> notificationFilters;
+
+    bool matchNotificationFilters(const Notification& notification);
+
+    // Handlers paired with the histogram of their execution time or
+    // 0 while the connector is inactive.
+    typedef std::list< std::pair<eventprocessing::HandlerPtr, Histogram*> >
+        TimedHandlerList;
+
+    TimedHandlerList timedHandlers;
+
+    Histogram*       sendToReceiveLatency;
+    Histogram*       receiveToHandlerLatency;
+
+    /**
+     * Returns the labels of metrics about notifications received by
+     * this connector, which include its scope only if the bus labels
+     * metrics with scopes.
+     */
+    MetricLabels metricLabels() const;
+
+    Histogram* lookUpHandlerDuration(const eventprocessing::Handler& handler) const;
+
     EventPtr notificationToEvent(NotificationPtr& notification);
 
+    void deliverLossReport(const Notification& notification);
+
     void handleError(const std::string&    context,
                      const std::exception& exception,
                      const std::string&    continueDescription,
@@ -0,0 +1,79 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#include "LazyPayload.h"
+
+namespace rsb {
+namespace transport {
+namespace spread {
+
+LazyPayload::LazyPayload(NotificationPtr notification,
+                         ConverterPtr    converter,
+                         bool            share) :
+    notification(notification), converter(converter), share(share) {
+}
+
+LazyPayload::LazyPayload(NotificationPtr      notification,
+                         const AnnotatedData& data) :
+    notification(notification), share(false), data(data) {
+}
+
+const std::string& LazyPayload::getWireSchema() const {
+    return this->notification->wireSchema;
+}
+
+const std::string& LazyPayload::getSerializedPayload() const {
+    return this->notification->serializedPayload;
+}
+
+std::string LazyPayload::getDataType() const {
+    // Payloads without converter are created deserialized and never
+    // modified.
+    if (!this->converter) {
+        return this->data.first;
+    }
+    return this->converter->getDataType();
+}
+
+AnnotatedData LazyPayload::get() const {
+    // When sharing, the notification caches the result, such that
+    // other connectors using the same converter share it.
+    if (this->share) {
+        return this->notification->deserialize(this->converter);
+    }
+
+    boost::mutex::scoped_lock lock(this->mutex);
+    if (!this->data.second) {
+        this->data = this->converter->deserialize
+            (this->notification->wireSchema,
+             this->notification->serializedPayload);
+    }
+    return this->data;
+}
+
+}
+}
+}
@@ -0,0 +1,124 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#pragma once
+
+#include <string>
+
+#include <boost/shared_ptr.hpp>
+
+#include <boost/thread/mutex.hpp>
+
+#include "Notifications.h"
+
+#include "rsb/transport/spread/rsbspreadexports.h"
+
+namespace rsb {
+namespace transport {
+namespace spread {
+
+/**
+ * Event data which defers deserialization of a received payload
+ * until it is accessed for the first time.
+ *
+ * Connectors configured for lazy deserialization deliver events
+ * whose data is an instance of this class. Handlers which only
+ * inspect meta data, scope or type or which forward the serialized
+ * payload never pay for deserialization.
+ *
+ * @author jmoringe
+ */
+class RSBSPREAD_EXPORT LazyPayload {
+public:
+    typedef Notification::ConverterPtr ConverterPtr;
+
+    /**
+     * @param notification The received notification.
+     * @param converter The converter for deserializing the payload.
+     * @param share If @c true, the deserialized data is shared with
+     *              other connectors which use the same converter for
+     *              @a notification. Otherwise it is private to this
+     *              object.
+     */
+    LazyPayload(NotificationPtr notification,
+                ConverterPtr    converter,
+                bool            share = false);
+
+    /**
+     * Creates a payload which is already deserialized, for example
+     * from the data of an event sent in this process.
+     *
+     * @param notification The notification.
+     * @param data The type and the data of the payload.
+     */
+    LazyPayload(NotificationPtr notification, const AnnotatedData& data);
+
+    /**
+     * Returns the wire schema of the serialized payload.
+     */
+    const std::string& getWireSchema() const;
+
+    /**
+     * Returns the serialized payload without deserializing it.
+     */
+    const std::string& getSerializedPayload() const;
+
+    /**
+     * Returns the data type the payload will be deserialized to.
+     */
+    std::string getDataType() const;
+
+    /**
+     * Deserializes the payload, if this has not been done yet, and
+     * returns the result.
+     *
+     * @return The type and the deserialized data.
+     * @throw std::exception If deserialization fails.
+     */
+    AnnotatedData get() const;
+
+    /**
+     * Like @ref get but returns only the deserialized data, cast to
+     * @a T.
+     */
+    template <typename T>
+    boost::shared_ptr<T> getAs() const {
+        return boost::static_pointer_cast<T>(get().second);
+    }
+private:
+    NotificationPtr       notification;
+    ConverterPtr          converter;
+    bool                  share;
+
+    mutable boost::mutex  mutex;
+    mutable AnnotatedData data;
+};
+
+typedef boost::shared_ptr<LazyPayload> LazyPayloadPtr;
+
+}
+}
+}
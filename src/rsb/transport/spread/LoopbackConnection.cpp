@@ -0,0 +1,393 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#include "LoopbackConnection.h"
+
+#include <boost/format.hpp>
+
+#include <boost/random/uniform_01.hpp>
+
+#include <boost/thread/thread.hpp>
+
+#include <rsc/misc/IllegalStateException.h>
+#include <rsc/misc/langutils.h>
+
+#include <rsb/CommException.h>
+
+namespace rsb {
+namespace transport {
+namespace spread {
+
+LoopbackDaemon::Faults::Faults() :
+    latency(0), loss(0.0), reordering(0.0), reorderDelay(0), duplication(0.0) {
+}
+
+LoopbackDaemon::LoopbackDaemon(boost::uint32_t seed) :
+    running(true), generator(seed), nextId(0) {
+}
+
+LoopbackDaemon::Faults LoopbackDaemon::getFaults() const {
+    boost::mutex::scoped_lock lock(this->mutex);
+    return this->faults;
+}
+
+void LoopbackDaemon::setFaults(const Faults& faults) {
+    boost::mutex::scoped_lock lock(this->mutex);
+    this->faults = faults;
+}
+
+std::size_t LoopbackDaemon::getNumMembers(const std::string& group) const {
+    boost::mutex::scoped_lock lock(this->mutex);
+
+    GroupMap::const_iterator it = this->groups.find(group);
+    return (it == this->groups.end()) ? 0 : it->second.size();
+}
+
+void LoopbackDaemon::stop() {
+    boost::mutex::scoped_lock lock(this->mutex);
+
+    this->running = false;
+    for (ConnectionMap::const_iterator it = this->connections.begin();
+         it != this->connections.end(); ++it) {
+        it->second->close();
+    }
+    this->connections.clear();
+    this->groups.clear();
+}
+
+void LoopbackDaemon::start() {
+    boost::mutex::scoped_lock lock(this->mutex);
+    this->running = true;
+}
+
+std::string LoopbackDaemon::connect(LoopbackConnection* connection) {
+    boost::mutex::scoped_lock lock(this->mutex);
+
+    if (!this->running) {
+        throw CommException("Error connecting to Spread daemon at"
+                            " 'loopback': daemon is not running");
+    }
+
+    // Mimic the "#USER#DAEMON" format of Spread private groups.
+    std::string privateGroup
+        = boost::str(boost::format("#loop%1%#loopback") % this->nextId++);
+    this->connections[privateGroup] = connection;
+    return privateGroup;
+}
+
+void LoopbackDaemon::disconnect(LoopbackConnection* connection) {
+    boost::mutex::scoped_lock lock(this->mutex);
+
+    this->connections.erase(connection->getPrivateGroup());
+    for (GroupMap::iterator it = this->groups.begin();
+         it != this->groups.end();) {
+        it->second.erase(connection);
+        if (it->second.empty()) {
+            this->groups.erase(it++);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void LoopbackDaemon::join(LoopbackConnection* connection,
+                          const std::string&  group) {
+    boost::mutex::scoped_lock lock(this->mutex);
+    checkConnected(connection);
+    this->groups[group].insert(connection);
+}
+
+void LoopbackDaemon::leave(LoopbackConnection* connection,
+                           const std::string&  group) {
+    boost::mutex::scoped_lock lock(this->mutex);
+    checkConnected(connection);
+
+    GroupMap::iterator it = this->groups.find(group);
+    if (it == this->groups.end() || !it->second.erase(connection)) {
+        throw CommException(boost::str(boost::format("Error leaving Spread"
+                                                     " group '%1%': not a"
+                                                     " member")
+                                       % group));
+    }
+    if (it->second.empty()) {
+        this->groups.erase(it);
+    }
+}
+
+void LoopbackDaemon::send(LoopbackConnection* sender,
+                          const SpreadMessage& message) {
+    boost::mutex::scoped_lock lock(this->mutex);
+    checkConnected(sender);
+
+    // Collect the receivers first such that a connection which is a
+    // member of multiple destination groups receives the message only
+    // once.
+    Members receivers;
+    const std::set<std::string>& destinations = message.getGroups();
+    for (std::set<std::string>::const_iterator it = destinations.begin();
+         it != destinations.end(); ++it) {
+        ConnectionMap::const_iterator connection = this->connections.find(*it);
+        if (connection != this->connections.end()) {
+            receivers.insert(connection->second);
+            continue;
+        }
+        GroupMap::const_iterator group = this->groups.find(*it);
+        if (group != this->groups.end()) {
+            receivers.insert(group->second.begin(), group->second.end());
+        }
+    }
+    receivers.erase(sender);
+
+    SpreadMessage delivered(SpreadMessage::REGULAR);
+    delivered.setQOS(message.getQOS());
+    delivered.setData(message.getData());
+    delivered.setSender(sender->getPrivateGroup());
+    for (std::set<std::string>::const_iterator it = destinations.begin();
+         it != destinations.end(); ++it) {
+        delivered.addGroup(*it);
+    }
+
+    boost::uint64_t deliveryTime
+        = rsc::misc::currentTimeMicros() + this->faults.latency;
+    bool unreliable = (message.getQOS() == SpreadMessage::UNRELIABLE);
+    for (Members::const_iterator it = receivers.begin();
+         it != receivers.end(); ++it) {
+        if (!unreliable) {
+            (*it)->deliver(delivered, deliveryTime);
+            continue;
+        }
+
+        if (random() < this->faults.loss) {
+            continue;
+        }
+        boost::uint64_t time = deliveryTime;
+        if (random() < this->faults.reordering) {
+            time += this->faults.reorderDelay;
+        }
+        (*it)->deliver(delivered, time);
+        if (random() < this->faults.duplication) {
+            (*it)->deliver(delivered, time);
+        }
+    }
+}
+
+void LoopbackDaemon::checkConnected(LoopbackConnection* connection) const {
+    ConnectionMap::const_iterator it
+        = this->connections.find(connection->getPrivateGroup());
+    if ((it == this->connections.end()) || (it->second != connection)) {
+        throw CommException("Connection has been closed by the daemon");
+    }
+}
+
+double LoopbackDaemon::random() {
+    return boost::uniform_01<boost::mt19937&>(this->generator)();
+}
+
+LoopbackConnection::LoopbackConnection(LoopbackDaemonPtr daemon) :
+    daemon(daemon), active(false), closed(false), nextSequenceNumber(0) {
+}
+
+LoopbackConnection::~LoopbackConnection() {
+    if (this->active) {
+        deactivate();
+    }
+}
+
+void LoopbackConnection::printContents(std::ostream& stream) const {
+    stream << this->privateGroup << "@loopback";
+}
+
+const std::string LoopbackConnection::getTransportURL() const {
+    return "spread://loopback";
+}
+
+const std::string& LoopbackConnection::getPrivateGroup() const {
+    return this->privateGroup;
+}
+
+bool LoopbackConnection::isActive() const {
+    boost::mutex::scoped_lock lock(this->mutex);
+    return this->active;
+}
+
+void LoopbackConnection::activate() {
+    {
+        boost::mutex::scoped_lock lock(this->mutex);
+        if (this->active) {
+            throw rsc::misc::IllegalStateException
+                (boost::str(boost::format("Connection with id %1% is already active.")
+                            % this->privateGroup));
+        }
+    }
+
+    // The daemon locks its own mutex and then the mutex of receiving
+    // connections. Therefore the daemon must not be called while
+    // holding this->mutex.
+    std::string privateGroup = this->daemon->connect(this);
+
+    boost::mutex::scoped_lock lock(this->mutex);
+    this->privateGroup = privateGroup;
+    this->queue.clear();
+    this->active = true;
+    this->closed = false;
+}
+
+void LoopbackConnection::deactivate() {
+    if (!isActive()) {
+        throw rsc::misc::IllegalStateException("Connection is not active.");
+    }
+
+    this->daemon->disconnect(this);
+
+    boost::mutex::scoped_lock lock(this->mutex);
+    this->active = false;
+}
+
+void LoopbackConnection::join(const std::string& group) {
+    if (!isActive()) {
+        throw rsc::misc::IllegalStateException("Connection is not active.");
+    }
+
+    this->daemon->join(this, group);
+}
+
+void LoopbackConnection::leave(const std::string& group) {
+    if (!isActive()) {
+        throw rsc::misc::IllegalStateException("Connection is not active.");
+    }
+
+    this->daemon->leave(this, group);
+}
+
+void LoopbackConnection::receive(SpreadMessage& message) {
+    boost::mutex::scoped_lock lock(this->mutex);
+
+    while (true) {
+        checkOpen();
+
+        if (this->queue.empty()) {
+            this->condition.wait(lock);
+            continue;
+        }
+
+        Queue::iterator head = this->queue.begin();
+        boost::uint64_t now = rsc::misc::currentTimeMicros();
+        if (head->first.first > now) {
+            this->condition.timed_wait
+                (lock, boost::posix_time::microseconds(head->first.first - now));
+            continue;
+        }
+
+        QueueEntry entry = head->second;
+        this->queue.erase(head);
+        if (entry.interrupt) {
+            throw boost::thread_interrupted();
+        }
+        message = entry.message;
+        return;
+    }
+}
+
+void LoopbackConnection::send(const SpreadMessage& message) {
+    if (!isActive()) {
+        throw rsc::misc::IllegalStateException("Connection is not active.");
+    }
+
+    if (message.getGroups().empty()) {
+        assert(false);
+        throw CommException("Group information missing in message");
+    }
+
+    this->daemon->send(this, message);
+}
+
+int LoopbackConnection::getPendingBytes() const {
+    boost::mutex::scoped_lock lock(this->mutex);
+
+    if (!this->active) {
+        throw rsc::misc::IllegalStateException("Connection is not active.");
+    }
+
+    boost::uint64_t now = rsc::misc::currentTimeMicros();
+    int result = 0;
+    for (Queue::const_iterator it = this->queue.begin();
+         it != this->queue.end() && it->first.first <= now; ++it) {
+        result += it->second.message.getSize();
+    }
+    return result;
+}
+
+void LoopbackConnection::interruptReceive() {
+    if (!isActive()) {
+        throw rsc::misc::IllegalStateException("Connection is not active.");
+    }
+
+    QueueEntry entry;
+    entry.interrupt = true;
+    enqueue(entry, rsc::misc::currentTimeMicros());
+}
+
+void LoopbackConnection::deliver(const SpreadMessage& message,
+                                 boost::uint64_t      deliveryTime) {
+    QueueEntry entry;
+    entry.interrupt = false;
+    entry.message   = message;
+    enqueue(entry, deliveryTime);
+}
+
+void LoopbackConnection::close() {
+    {
+        boost::mutex::scoped_lock lock(this->mutex);
+        this->closed = true;
+        this->queue.clear();
+    }
+    this->condition.notify_all();
+}
+
+void LoopbackConnection::checkOpen() const {
+    if (!this->active) {
+        throw rsc::misc::IllegalStateException("Connection is not active.");
+    }
+    if (this->closed) {
+        throw CommException("Spread receive error: connection has been"
+                            " closed by the daemon");
+    }
+}
+
+void LoopbackConnection::enqueue(const QueueEntry& entry,
+                                 boost::uint64_t   deliveryTime) {
+    {
+        boost::mutex::scoped_lock lock(this->mutex);
+        this->queue.insert(std::make_pair(QueueKey(deliveryTime,
+                                                   this->nextSequenceNumber++),
+                                          entry));
+    }
+    this->condition.notify_all();
+}
+
+}
+}
+}
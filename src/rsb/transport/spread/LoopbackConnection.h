@@ -0,0 +1,261 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#pragma once
+
+#include <string>
+#include <set>
+#include <map>
+
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+#include <boost/random/mersenne_twister.hpp>
+
+#include "Connection.h"
+
+#include "rsb/transport/spread/rsbspreadexports.h"
+
+namespace rsb {
+namespace transport {
+namespace spread {
+
+class LoopbackConnection;
+
+/**
+ * Stands in for a Spread daemon within a single process.
+ *
+ * All @ref LoopbackConnection s created for one daemon object can
+ * exchange messages with each other according to the group semantics
+ * of Spread. In addition, delivered messages can be delayed, lost,
+ * reordered and duplicated in a reproducible way to simulate an
+ * imperfect network.
+ *
+ * @author jmoringe
+ */
+class RSBSPREAD_EXPORT LoopbackDaemon {
+public:
+
+    /**
+     * Describes the faults which are injected when delivering
+     * messages to receiving connections.
+     *
+     * Loss, reordering and duplication only affect messages with QoS
+     * @ref SpreadMessage::UNRELIABLE since Spread guarantees delivery
+     * and ordering for all other QoS levels. Each decision is made
+     * independently for every receiving connection.
+     */
+    struct RSBSPREAD_EXPORT Faults {
+        Faults();
+
+        /**
+         * Delay of every delivered message in microseconds.
+         */
+        boost::uint64_t latency;
+
+        /**
+         * Probability with which a message is not delivered.
+         */
+        double          loss;
+
+        /**
+         * Probability with which a message is delayed by an
+         * additional @ref reorderDelay microseconds such that
+         * subsequent messages overtake it.
+         */
+        double          reordering;
+
+        /**
+         * Additional delay in microseconds of reordered messages.
+         */
+        boost::uint64_t reorderDelay;
+
+        /**
+         * Probability with which a message is delivered twice.
+         */
+        double          duplication;
+    };
+
+    /**
+     * Creates a daemon without faults.
+     *
+     * @param seed Seed of the random number generator which decides
+     *             about injected faults. Given the same seed and the
+     *             same sequence of sent messages, the same faults are
+     *             injected.
+     */
+    explicit LoopbackDaemon(boost::uint32_t seed = 0);
+
+    Faults getFaults() const;
+    void setFaults(const Faults& faults);
+
+    /**
+     * Returns the number of connections which are members of
+     * @a group.
+     */
+    std::size_t getNumMembers(const std::string& group) const;
+
+    /**
+     * Simulates a crash of the daemon: all connections are closed and
+     * lose their group memberships, and new connections are refused
+     * until @ref start is called.
+     */
+    void stop();
+
+    /**
+     * Accepts connections again after @ref stop.
+     */
+    void start();
+
+    /**
+     * Registers @a connection and returns the name of its private
+     * group.
+     *
+     * @throw CommException if the daemon has been stopped.
+     */
+    std::string connect(LoopbackConnection* connection);
+
+    /**
+     * Removes @a connection from all groups and unregisters it.
+     */
+    void disconnect(LoopbackConnection* connection);
+
+    void join(LoopbackConnection* connection, const std::string& group);
+    void leave(LoopbackConnection* connection, const std::string& group);
+
+    /**
+     * Delivers @a message to all members of its groups except
+     * @a sender, each member receiving it at most once.
+     */
+    void send(LoopbackConnection* sender, const SpreadMessage& message);
+private:
+    typedef std::set<LoopbackConnection*>                 Members;
+    typedef std::map<std::string, Members>                GroupMap;
+    typedef std::map<std::string, LoopbackConnection*>    ConnectionMap;
+
+    double random();
+
+    void checkConnected(LoopbackConnection* connection) const;
+
+    mutable boost::mutex mutex;
+    bool                 running;
+    Faults               faults;
+    boost::mt19937       generator;
+    unsigned int         nextId;
+    GroupMap             groups;
+    ConnectionMap        connections;
+};
+
+typedef boost::shared_ptr<LoopbackDaemon> LoopbackDaemonPtr;
+
+/**
+ * A @ref Connection to a @ref LoopbackDaemon in the same process.
+ *
+ * Can be used in place of @ref SpreadConnection to run buses and
+ * connectors without a Spread daemon, for example in tests and
+ * benchmarks.
+ *
+ * @note Unlike @ref SpreadConnection, all methods of this class are
+ *       thread-safe.
+ *
+ * @author jmoringe
+ */
+class RSBSPREAD_EXPORT LoopbackConnection : public Connection {
+public:
+    LoopbackConnection(LoopbackDaemonPtr daemon);
+    virtual ~LoopbackConnection();
+
+    void printContents(std::ostream& stream) const;
+
+    const std::string getTransportURL() const;
+
+    const std::string& getPrivateGroup() const;
+
+    bool isActive() const;
+
+    void activate();
+    void deactivate();
+
+    void join(const std::string& group);
+    void leave(const std::string& group);
+
+    void receive(SpreadMessage& message);
+
+    void send(const SpreadMessage& message);
+
+    int getPendingBytes() const;
+
+    void interruptReceive();
+
+    /**
+     * Queues @a message for receiving at or after @a deliveryTime,
+     * given in microseconds since the epoch. Called by the daemon.
+     */
+    void deliver(const SpreadMessage& message, boost::uint64_t deliveryTime);
+
+    /**
+     * Marks the connection as closed by the daemon, such that all
+     * operations except #deactivate fail with a CommException. Called
+     * by the daemon.
+     */
+    void close();
+private:
+    /**
+     * Messages are ordered by delivery time and, for equal delivery
+     * times, by the order in which they have been queued.
+     */
+    typedef std::pair<boost::uint64_t, boost::uint64_t> QueueKey;
+
+    struct QueueEntry {
+        bool          interrupt;
+        SpreadMessage message;
+    };
+
+    typedef std::map<QueueKey, QueueEntry> Queue;
+
+    void enqueue(const QueueEntry& entry, boost::uint64_t deliveryTime);
+
+    void checkOpen() const;
+
+    LoopbackDaemonPtr                 daemon;
+    std::string                       privateGroup;
+    bool                              active;
+    bool                              closed;
+
+    mutable boost::mutex              mutex;
+    boost::condition_variable         condition;
+    Queue                             queue;
+    boost::uint64_t                   nextSequenceNumber;
+};
+
+typedef boost::shared_ptr<LoopbackConnection> LoopbackConnectionPtr;
+
+}
+}
+}
@@ -31,8 +31,8 @@ namespace rsb {
 namespace transport {
 namespace spread {
 
-MembershipManager::MembershipManager(SpreadConnectionPtr connection) :
-    connection(connection) {
+MembershipManager::MembershipManager(ConnectionPtr connection) :
+    connection(connection), suspended(false) {
 }
 
 MembershipManager::~MembershipManager() {
@@ -41,7 +41,9 @@ MembershipManager::~MembershipManager() {
 void MembershipManager::join(const std::string& group) {
     GroupMap::iterator it = this->groups.find(group);
     if (it == this->groups.end()) {
-        this->connection->join(group);
+        if (!this->suspended) {
+            this->connection->join(group);
+        }
         this->groups[group] = 1;
     } else {
         it->second++;
@@ -53,10 +55,32 @@ void MembershipManager::leave(const std::string& group) {
     assert(it != this->groups.end());
     if (--it->second == 0) {
         this->groups.erase(it);
-        this->connection->leave(group);
+        if (!this->suspended) {
+            this->connection->leave(group);
+        }
     }
 }
 
+bool MembershipManager::isMember(const std::string& group) const {
+    return this->groups.find(group) != this->groups.end();
+}
+
+void MembershipManager::suspend() {
+    this->suspended = true;
+}
+
+void MembershipManager::rejoin() {
+    // Spread has no call for joining multiple groups at once, but
+    // joins are not acknowledged synchronously, so issuing them
+    // back-to-back restores all memberships within a single round
+    // trip to the daemon.
+    for (GroupMap::const_iterator it = this->groups.begin();
+         it != this->groups.end(); ++it) {
+        this->connection->join(it->first);
+    }
+    this->suspended = false;
+}
+
 }
 }
 }
@@ -32,7 +32,7 @@
 
 #include <boost/shared_ptr.hpp>
 
-#include "SpreadConnection.h"
+#include "Connection.h"
 
 #include "rsb/transport/spread/rsbspreadexports.h"
 
@@ -47,7 +47,7 @@ namespace spread {
  */
 class RSBSPREAD_EXPORT MembershipManager {
 public:
-    MembershipManager(SpreadConnectionPtr connection);
+    MembershipManager(ConnectionPtr connection);
     virtual ~MembershipManager();
 
     /**
@@ -67,11 +67,35 @@ public:
      */
     void leave(const std::string& group);
 
+    /**
+     * Tells whether the reference count for @a group is non-zero.
+     */
+    bool isMember(const std::string& group) const;
+
+    /**
+     * Stops joining and leaving groups via the connection, for
+     * example because the connection to the daemon has been lost.
+     * Reference counts are still maintained by #join and #leave.
+     */
+    void suspend();
+
+    /**
+     * Joins all groups with a non-zero reference count via the
+     * connection and resumes joining and leaving groups. Used to
+     * restore the memberships after the connection has been
+     * reestablished.
+     *
+     * @throw CommException error joining. The manager remains
+     *                      suspended in this case.
+     */
+    void rejoin();
+
 private:
     typedef std::map<std::string, unsigned int> GroupMap;
 
-    SpreadConnectionPtr connection;
-    GroupMap            groups;
+    ConnectionPtr connection;
+    GroupMap      groups;
+    bool          suspended;
 };
 
 }
@@ -0,0 +1,437 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#include "Metrics.h"
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+#include <boost/format.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/thread/thread.hpp>
+
+namespace rsb {
+namespace transport {
+namespace spread {
+
+namespace {
+
+std::string joinLabels(const std::string& labels, const std::string& extra) {
+    if (labels.empty()) {
+        return extra;
+    } else if (extra.empty()) {
+        return labels;
+    } else {
+        return labels + "," + extra;
+    }
+}
+
+void writeSample(std::ostream&      stream,
+                 const std::string& name,
+                 const std::string& labels,
+                 const std::string& value) {
+    stream << name;
+    if (!labels.empty()) {
+        stream << "{" << labels << "}";
+    }
+    stream << " " << value << "\n";
+}
+
+template <typename T>
+std::string toString(T value) {
+    return boost::str(boost::format("%1%") % value);
+}
+
+std::string escapeLabelValue(const std::string& value) {
+    std::string result;
+    result.reserve(value.size());
+    for (std::string::const_iterator it = value.begin();
+         it != value.end(); ++it) {
+        switch (*it) {
+        case '\\':
+            result += "\\\\";
+            break;
+        case '"':
+            result += "\\\"";
+            break;
+        case '\n':
+            result += "\\n";
+            break;
+        default:
+            result += *it;
+        }
+    }
+    return result;
+}
+
+}
+
+// Metric
+
+Metric::~Metric() {
+}
+
+// Counter
+
+Counter::Counter() :
+    value(0) {
+}
+
+void Counter::increment(boost::uint64_t amount) {
+    this->value.fetch_add(amount, boost::memory_order_relaxed);
+}
+
+boost::uint64_t Counter::get() const {
+    return this->value.load(boost::memory_order_relaxed);
+}
+
+void Counter::writePrometheus(std::ostream&      stream,
+                              const std::string& name,
+                              const std::string& labels) const {
+    writeSample(stream, name, labels, toString(get()));
+}
+
+// Gauge
+
+Gauge::Gauge() :
+    value(0) {
+}
+
+void Gauge::set(boost::int64_t value) {
+    this->value.store(value, boost::memory_order_relaxed);
+}
+
+void Gauge::add(boost::int64_t amount) {
+    this->value.fetch_add(amount, boost::memory_order_relaxed);
+}
+
+boost::int64_t Gauge::get() const {
+    return this->value.load(boost::memory_order_relaxed);
+}
+
+void Gauge::writePrometheus(std::ostream&      stream,
+                            const std::string& name,
+                            const std::string& labels) const {
+    writeSample(stream, name, labels, toString(get()));
+}
+
+// Histogram
+
+namespace {
+
+unsigned int mostSignificantBit(boost::uint64_t value) {
+#if defined(__GNUC__)
+    return 63 - __builtin_clzll(value);
+#else
+    unsigned int index = 0;
+    while (value >>= 1) {
+        ++index;
+    }
+    return index;
+#endif
+}
+
+unsigned int currentStripe() {
+    return boost::hash<boost::thread::id>()(boost::this_thread::get_id())
+        % Histogram::NUM_STRIPES;
+}
+
+}
+
+Histogram::Histogram() {
+    for (unsigned int i = 0; i < NUM_STRIPES; ++i) {
+        Stripe& stripe = this->stripes[i];
+        stripe.count.store(0, boost::memory_order_relaxed);
+        stripe.sum.store(0, boost::memory_order_relaxed);
+        for (unsigned int j = 0; j < NUM_BUCKETS; ++j) {
+            stripe.buckets[j].store(0, boost::memory_order_relaxed);
+        }
+    }
+}
+
+unsigned int Histogram::getBucketIndex(boost::uint64_t value) {
+    const unsigned int subBuckets = 1 << SUB_BUCKET_BITS;
+    if (value < subBuckets) {
+        return value;
+    }
+    unsigned int exponent = mostSignificantBit(value);
+    if (exponent > MAX_EXPONENT) {
+        return NUM_BUCKETS - 1;
+    }
+    unsigned int subBucket
+        = (value >> (exponent - SUB_BUCKET_BITS)) - subBuckets;
+    return subBuckets + (exponent - SUB_BUCKET_BITS) * subBuckets + subBucket;
+}
+
+boost::uint64_t Histogram::getBucketUpperBound(unsigned int index) {
+    const unsigned int subBuckets = 1 << SUB_BUCKET_BITS;
+    if (index < subBuckets) {
+        return index;
+    }
+    if (index >= NUM_BUCKETS - 1) {
+        return ~boost::uint64_t(0);
+    }
+    unsigned int shift     = (index - subBuckets) / subBuckets;
+    unsigned int subBucket = (index - subBuckets) % subBuckets;
+    boost::uint64_t lower = boost::uint64_t(subBuckets + subBucket) << shift;
+    return lower + (boost::uint64_t(1) << shift) - 1;
+}
+
+void Histogram::record(boost::uint64_t value) {
+    Stripe& stripe = this->stripes[currentStripe()];
+    stripe.buckets[getBucketIndex(value)].fetch_add(1, boost::memory_order_relaxed);
+    stripe.sum.fetch_add(value, boost::memory_order_relaxed);
+    stripe.count.fetch_add(1, boost::memory_order_relaxed);
+}
+
+boost::uint64_t Histogram::getCount() const {
+    boost::uint64_t result = 0;
+    for (unsigned int i = 0; i < NUM_STRIPES; ++i) {
+        result += this->stripes[i].count.load(boost::memory_order_relaxed);
+    }
+    return result;
+}
+
+boost::uint64_t Histogram::getSum() const {
+    boost::uint64_t result = 0;
+    for (unsigned int i = 0; i < NUM_STRIPES; ++i) {
+        result += this->stripes[i].sum.load(boost::memory_order_relaxed);
+    }
+    return result;
+}
+
+boost::uint64_t Histogram::getBucketCount(unsigned int index) const {
+    boost::uint64_t result = 0;
+    for (unsigned int i = 0; i < NUM_STRIPES; ++i) {
+        result += this->stripes[i].buckets[index].load(boost::memory_order_relaxed);
+    }
+    return result;
+}
+
+void Histogram::readBuckets(boost::uint64_t* counts) const {
+    // Buckets are read individually, so the result can be slightly
+    // inconsistent while samples are being recorded.
+    for (unsigned int i = 0; i < NUM_BUCKETS; ++i) {
+        counts[i] = getBucketCount(i);
+    }
+}
+
+boost::uint64_t Histogram::getQuantile(double quantile) const {
+    boost::uint64_t counts[NUM_BUCKETS];
+    readBuckets(counts);
+    boost::uint64_t total = 0;
+    for (unsigned int i = 0; i < NUM_BUCKETS; ++i) {
+        total += counts[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    boost::uint64_t rank = static_cast<boost::uint64_t>
+        (std::ceil(quantile * static_cast<double>(total)));
+    if (rank == 0) {
+        rank = 1;
+    }
+    boost::uint64_t seen = 0;
+    for (unsigned int i = 0; i < NUM_BUCKETS; ++i) {
+        seen += counts[i];
+        if (seen >= rank) {
+            return getBucketUpperBound(i);
+        }
+    }
+    return getBucketUpperBound(NUM_BUCKETS - 1);
+}
+
+void Histogram::writePrometheus(std::ostream&      stream,
+                                const std::string& name,
+                                const std::string& labels) const {
+    boost::uint64_t counts[NUM_BUCKETS];
+    readBuckets(counts);
+
+    // Only non-empty buckets are written to keep the output small.
+    // The overflow bucket is only represented by the "+Inf" bucket.
+    boost::uint64_t cumulative = 0;
+    for (unsigned int i = 0; i < NUM_BUCKETS; ++i) {
+        cumulative += counts[i];
+        if ((counts[i] != 0) && (i < NUM_BUCKETS - 1)) {
+            writeSample(stream, name + "_bucket",
+                        joinLabels(labels, "le=\"" + toString(getBucketUpperBound(i)) + "\""),
+                        toString(cumulative));
+        }
+    }
+    writeSample(stream, name + "_bucket", joinLabels(labels, "le=\"+Inf\""),
+                toString(cumulative));
+    writeSample(stream, name + "_sum", labels, toString(getSum()));
+    writeSample(stream, name + "_count", labels, toString(cumulative));
+}
+
+// MetricLabels
+
+MetricLabels::MetricLabels() {
+}
+
+MetricLabels& MetricLabels::add(const std::string& name,
+                                const std::string& value) {
+    this->formatted = joinLabels(this->formatted,
+                                 name + "=\"" + escapeLabelValue(value) + "\"");
+    return *this;
+}
+
+const std::string& MetricLabels::str() const {
+    return this->formatted;
+}
+
+// MetricsRegistry
+
+MetricsRegistry::MetricsRegistry() {
+}
+
+MetricsRegistry::~MetricsRegistry() {
+}
+
+template <typename T>
+T& MetricsRegistry::get(const std::string&  name,
+                        const std::string&  type,
+                        const std::string&  help,
+                        const MetricLabels& labels) {
+    boost::mutex::scoped_lock lock(this->mutex);
+
+    FamilyMap::iterator familyIt = this->families.find(name);
+    if (familyIt == this->families.end()) {
+        Family family;
+        family.type = type;
+        family.help = help;
+        familyIt = this->families.insert(std::make_pair(name, family)).first;
+    } else if (familyIt->second.type != type) {
+        throw std::logic_error(boost::str(boost::format("Metric %1% is a %2%, not a %3%")
+                                          % name % familyIt->second.type % type));
+    }
+
+    MetricPtr& metric = familyIt->second.members[labels.str()];
+    if (!metric) {
+        metric.reset(new T());
+    }
+    return static_cast<T&>(*metric);
+}
+
+Counter& MetricsRegistry::getCounter(const std::string&  name,
+                                     const std::string&  help,
+                                     const MetricLabels& labels) {
+    return get<Counter>(name, "counter", help, labels);
+}
+
+Gauge& MetricsRegistry::getGauge(const std::string&  name,
+                                 const std::string&  help,
+                                 const MetricLabels& labels) {
+    return get<Gauge>(name, "gauge", help, labels);
+}
+
+Histogram& MetricsRegistry::getHistogram(const std::string&  name,
+                                         const std::string&  help,
+                                         const MetricLabels& labels) {
+    return get<Histogram>(name, "histogram", help, labels);
+}
+
+const Metric* MetricsRegistry::find(const std::string&  name,
+                                    const MetricLabels& labels) const {
+    boost::mutex::scoped_lock lock(this->mutex);
+
+    FamilyMap::const_iterator familyIt = this->families.find(name);
+    if (familyIt == this->families.end()) {
+        return 0;
+    }
+    std::map<std::string, MetricPtr>::const_iterator it
+        = familyIt->second.members.find(labels.str());
+    if (it == familyIt->second.members.end()) {
+        return 0;
+    }
+    return it->second.get();
+}
+
+const Counter* MetricsRegistry::findCounter(const std::string&  name,
+                                            const MetricLabels& labels) const {
+    return dynamic_cast<const Counter*>(find(name, labels));
+}
+
+const Gauge* MetricsRegistry::findGauge(const std::string&  name,
+                                        const MetricLabels& labels) const {
+    return dynamic_cast<const Gauge*>(find(name, labels));
+}
+
+const Histogram* MetricsRegistry::findHistogram(const std::string&  name,
+                                                const MetricLabels& labels) const {
+    return dynamic_cast<const Histogram*>(find(name, labels));
+}
+
+void MetricsRegistry::writePrometheus(std::ostream& stream) const {
+    boost::mutex::scoped_lock lock(this->mutex);
+
+    for (FamilyMap::const_iterator familyIt = this->families.begin();
+         familyIt != this->families.end(); ++familyIt) {
+        const Family& family = familyIt->second;
+        stream << "# HELP " << familyIt->first << " " << family.help << "\n"
+               << "# TYPE " << familyIt->first << " " << family.type << "\n";
+        for (std::map<std::string, MetricPtr>::const_iterator it
+                 = family.members.begin();
+             it != family.members.end(); ++it) {
+            it->second->writePrometheus(stream, familyIt->first, it->first);
+        }
+    }
+}
+
+// MetricsDumpTask
+
+MetricsDumpTask::MetricsDumpTask(MetricsRegistryPtr  metrics,
+                                 const std::string&  fileName,
+                                 unsigned int        intervalMs) :
+    PeriodicTask(intervalMs),
+    logger(rsc::logging::Logger::getLogger("rsb.transport.spread.MetricsDumpTask")),
+    metrics(metrics), fileName(fileName) {
+}
+
+void MetricsDumpTask::execute() {
+    // Write to a temporary file and rename it to replace the
+    // previous dump atomically.
+    std::string temporaryFileName = this->fileName + ".tmp";
+    {
+        std::ofstream stream(temporaryFileName.c_str());
+        this->metrics->writePrometheus(stream);
+        if (!stream) {
+            RSCWARN(this->logger, "Could not write metrics to " << temporaryFileName);
+            return;
+        }
+    }
+    if (std::rename(temporaryFileName.c_str(), this->fileName.c_str()) != 0) {
+        RSCWARN(this->logger, "Could not rename " << temporaryFileName
+                << " to " << this->fileName);
+    }
+}
+
+}
+}
+}
@@ -0,0 +1,345 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#pragma once
+
+#include <string>
+#include <map>
+#include <vector>
+#include <ostream>
+
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/atomic.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <boost/thread/mutex.hpp>
+
+#include <rsc/logging/Logger.h>
+#include <rsc/threading/PeriodicTask.h>
+
+#include "rsb/transport/spread/rsbspreadexports.h"
+
+namespace rsb {
+namespace transport {
+namespace spread {
+
+/**
+ * Base class of all metrics in a @ref MetricsRegistry.
+ *
+ * @author jmoringe
+ */
+class RSBSPREAD_EXPORT Metric : private boost::noncopyable {
+public:
+    virtual ~Metric();
+
+    /**
+     * Writes the samples of this metric in the Prometheus text
+     * format.
+     *
+     * @param stream The stream to write to.
+     * @param name The name of the metric family.
+     * @param labels The formatted labels of this metric without
+     *               braces. May be empty.
+     */
+    virtual void writePrometheus(std::ostream&      stream,
+                                 const std::string& name,
+                                 const std::string& labels) const = 0;
+};
+
+/**
+ * A monotonically increasing count.
+ *
+ * @author jmoringe
+ */
+class RSBSPREAD_EXPORT Counter : public Metric {
+public:
+    Counter();
+
+    void increment(boost::uint64_t amount = 1);
+
+    boost::uint64_t get() const;
+
+    void writePrometheus(std::ostream&      stream,
+                         const std::string& name,
+                         const std::string& labels) const;
+private:
+    boost::atomic<boost::uint64_t> value;
+};
+
+/**
+ * A value which can go up and down.
+ *
+ * Gauges describing per-bus state are updated by adding differences,
+ * such that a gauge shared by several buses reports the total.
+ *
+ * @author jmoringe
+ */
+class RSBSPREAD_EXPORT Gauge : public Metric {
+public:
+    Gauge();
+
+    void set(boost::int64_t value);
+
+    void add(boost::int64_t amount);
+
+    boost::int64_t get() const;
+
+    void writePrometheus(std::ostream&      stream,
+                         const std::string& name,
+                         const std::string& labels) const;
+private:
+    boost::atomic<boost::int64_t> value;
+};
+
+/**
+ * A distribution of non-negative integer samples such as durations
+ * in microseconds or sizes.
+ *
+ * Samples are counted in log-linear buckets in the style of HDR
+ * histograms: values below 8 are counted exactly, larger values in
+ * buckets which split each power of two into 8 equal parts. This
+ * bounds the relative error of reported quantiles by 12.5%. Values
+ * of 2^40 and above share an overflow bucket.
+ *
+ * Recording a sample does not lock. Threads record into one of
+ * several stripes of counters chosen by their thread id, such that
+ * threads recording concurrently rarely contend for the same cache
+ * lines.
+ *
+ * @author jmoringe
+ */
+class RSBSPREAD_EXPORT Histogram : public Metric {
+public:
+    static const unsigned int SUB_BUCKET_BITS = 3;
+    static const unsigned int MAX_EXPONENT    = 39;
+    static const unsigned int NUM_BUCKETS
+        = (1 << SUB_BUCKET_BITS)
+        + (MAX_EXPONENT - SUB_BUCKET_BITS + 1) * (1 << SUB_BUCKET_BITS)
+        + 1;
+    static const unsigned int NUM_STRIPES = 4;
+
+    Histogram();
+
+    void record(boost::uint64_t value);
+
+    boost::uint64_t getCount() const;
+
+    boost::uint64_t getSum() const;
+
+    /**
+     * Returns the number of samples in bucket @a index.
+     */
+    boost::uint64_t getBucketCount(unsigned int index) const;
+
+    /**
+     * Returns the index of the bucket which counts @a value.
+     */
+    static unsigned int getBucketIndex(boost::uint64_t value);
+
+    /**
+     * Returns the largest value counted in bucket @a index.
+     */
+    static boost::uint64_t getBucketUpperBound(unsigned int index);
+
+    /**
+     * Returns an upper bound of the @a quantile quantile of the
+     * recorded samples.
+     *
+     * @param quantile A number in [0, 1].
+     * @return The upper bound of the bucket containing the quantile
+     *         or 0 if no samples have been recorded.
+     */
+    boost::uint64_t getQuantile(double quantile) const;
+
+    void writePrometheus(std::ostream&      stream,
+                         const std::string& name,
+                         const std::string& labels) const;
+private:
+    struct Stripe {
+        boost::atomic<boost::uint64_t> count;
+        boost::atomic<boost::uint64_t> sum;
+        boost::atomic<boost::uint64_t> buckets[NUM_BUCKETS];
+    };
+
+    Stripe stripes[NUM_STRIPES];
+
+    void readBuckets(boost::uint64_t* counts) const;
+};
+
+/**
+ * Label names and values which distinguish metrics within a family.
+ *
+ * @author jmoringe
+ */
+class RSBSPREAD_EXPORT MetricLabels {
+public:
+    MetricLabels();
+
+    /**
+     * Adds the label @a name with value @a value.
+     *
+     * @return This object for chaining calls.
+     */
+    MetricLabels& add(const std::string& name, const std::string& value);
+
+    /**
+     * Returns the labels in the Prometheus text format without
+     * braces.
+     */
+    const std::string& str() const;
+private:
+    std::string formatted;
+};
+
+/**
+ * A registry of named metrics which are created on first use.
+ *
+ * Metrics are never removed, so references returned by the accessor
+ * methods remain valid as long as the registry exists. Callers on
+ * hot paths should keep such references instead of looking metrics
+ * up repeatedly.
+ *
+ * @author jmoringe
+ */
+class RSBSPREAD_EXPORT MetricsRegistry : private boost::noncopyable {
+public:
+    MetricsRegistry();
+    virtual ~MetricsRegistry();
+
+    /**
+     * Returns the counter named @a name with labels @a labels,
+     * creating it if necessary.
+     *
+     * @param name The name of the metric family.
+     * @param help A description of the metric family.
+     * @param labels Labels which identify the counter within its
+     *               family.
+     * @throw std::logic_error If @a name is registered as a metric
+     *                         of a different kind.
+     */
+    Counter& getCounter(const std::string&  name,
+                        const std::string&  help,
+                        const MetricLabels& labels = MetricLabels());
+
+    /**
+     * Like @ref getCounter but for gauges.
+     */
+    Gauge& getGauge(const std::string&  name,
+                    const std::string&  help,
+                    const MetricLabels& labels = MetricLabels());
+
+    /**
+     * Like @ref getCounter but for histograms.
+     */
+    Histogram& getHistogram(const std::string&  name,
+                            const std::string&  help,
+                            const MetricLabels& labels = MetricLabels());
+
+    /**
+     * Returns the counter named @a name with labels @a labels
+     * without creating it.
+     *
+     * @return The counter or 0 if it does not exist.
+     */
+    const Counter* findCounter(const std::string&  name,
+                               const MetricLabels& labels = MetricLabels()) const;
+
+    /**
+     * Like @ref findCounter but for gauges.
+     */
+    const Gauge* findGauge(const std::string&  name,
+                           const MetricLabels& labels = MetricLabels()) const;
+
+    /**
+     * Like @ref findCounter but for histograms.
+     */
+    const Histogram* findHistogram(const std::string&  name,
+                                   const MetricLabels& labels = MetricLabels()) const;
+
+    /**
+     * Writes all metrics in the Prometheus text exposition format.
+     *
+     * @param stream The stream to write to.
+     */
+    void writePrometheus(std::ostream& stream) const;
+private:
+    typedef boost::shared_ptr<Metric> MetricPtr;
+
+    struct Family {
+        std::string                        type;
+        std::string                        help;
+        std::map<std::string, MetricPtr>   members;
+    };
+
+    typedef std::map<std::string, Family> FamilyMap;
+
+    mutable boost::mutex mutex;
+    FamilyMap            families;
+
+    template <typename T>
+    T& get(const std::string&  name,
+           const std::string&  type,
+           const std::string&  help,
+           const MetricLabels& labels);
+
+    const Metric* find(const std::string&  name,
+                       const MetricLabels& labels) const;
+};
+
+typedef boost::shared_ptr<MetricsRegistry> MetricsRegistryPtr;
+
+/**
+ * Periodically writes the contents of a @ref MetricsRegistry to a
+ * file in the Prometheus text format.
+ *
+ * The file is replaced atomically, such that readers never observe
+ * partially written contents.
+ *
+ * @author jmoringe
+ */
+class RSBSPREAD_EXPORT MetricsDumpTask : public rsc::threading::PeriodicTask {
+public:
+    /**
+     * @param metrics The registry to dump.
+     * @param fileName The name of the file which should be written.
+     * @param intervalMs The interval between dumps in milliseconds.
+     */
+    MetricsDumpTask(MetricsRegistryPtr  metrics,
+                    const std::string&  fileName,
+                    unsigned int        intervalMs);
+
+    void execute();
+private:
+    rsc::logging::LoggerPtr logger;
+
+    MetricsRegistryPtr      metrics;
+    std::string             fileName;
+};
+
+}
+}
+}
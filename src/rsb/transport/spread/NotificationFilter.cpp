@@ -0,0 +1,118 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#include "NotificationFilter.h"
+
+#include <rsb/protocol/Notification.h>
+
+namespace rsb {
+namespace transport {
+namespace spread {
+
+namespace {
+
+// Returns the bytes of @a id in the representation used by the
+// sender_id field of EventId messages.
+std::string uuidBytes(const rsc::misc::UUID& id) {
+    boost::uuids::uuid raw = id.getId();
+    return std::string(raw.begin(), raw.end());
+}
+
+}
+
+NotificationFilter::~NotificationFilter() {
+}
+
+ScopeNotificationFilter::ScopeNotificationFilter(const Scope& scope) :
+    scope(scope) {
+}
+
+bool ScopeNotificationFilter::match(const Notification& notification) const {
+    return (notification.scope == this->scope)
+        || notification.scope.isSubScopeOf(this->scope);
+}
+
+OriginNotificationFilter::OriginNotificationFilter(const rsc::misc::UUID& origin,
+                                                   bool                   invert) :
+    origin(uuidBytes(origin)), invert(invert) {
+}
+
+bool OriginNotificationFilter::match(const Notification& notification) const {
+    bool result
+        = (notification.notification->event_id().sender_id() == this->origin);
+    return this->invert ? !result : result;
+}
+
+MethodNotificationFilter::MethodNotificationFilter(const std::string& method) :
+    method(method) {
+}
+
+bool MethodNotificationFilter::match(const Notification& notification) const {
+    return notification.notification->method() == this->method;
+}
+
+CauseNotificationFilter::CauseNotificationFilter(const EventId& cause) :
+    senderId(uuidBytes(cause.getParticipantId())),
+    sequenceNumber(cause.getSequenceNumber()) {
+}
+
+bool CauseNotificationFilter::match(const Notification& notification) const {
+    const rsb::protocol::Notification& header = *notification.notification;
+    for (int i = 0; i < header.causes_size(); ++i) {
+        const rsb::protocol::EventId& cause = header.causes(i);
+        if ((cause.sequence_number() == this->sequenceNumber)
+            && (cause.sender_id() == this->senderId)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+UserInfoNotificationFilter::UserInfoNotificationFilter(const std::string& key) :
+    key(key), checkValue(false) {
+}
+
+UserInfoNotificationFilter::UserInfoNotificationFilter(const std::string& key,
+                                                       const std::string& value) :
+    key(key), value(value), checkValue(true) {
+}
+
+bool UserInfoNotificationFilter::match(const Notification& notification) const {
+    const rsb::protocol::EventMetaData& metaData
+        = notification.notification->meta_data();
+    for (int i = 0; i < metaData.user_infos_size(); ++i) {
+        const rsb::protocol::UserInfo& info = metaData.user_infos(i);
+        if ((info.key() == this->key)
+            && (!this->checkValue || (info.value() == this->value))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+}
+}
+}
@@ -0,0 +1,168 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#pragma once
+
+#include <string>
+
+#include <boost/shared_ptr.hpp>
+
+#include <rsc/misc/UUID.h>
+
+#include <rsb/Scope.h>
+#include <rsb/EventId.h>
+
+#include "Notifications.h"
+
+#include "rsb/transport/spread/rsbspreadexports.h"
+
+namespace rsb {
+namespace transport {
+namespace spread {
+
+/**
+ * Predicate on the header of received notifications.
+ *
+ * In contrast to @ref rsb::filter::Filter, which operates on
+ * events, instances of this class are evaluated before the payload
+ * of a notification is deserialized. Connectors can therefore drop
+ * uninteresting notifications without paying for deserialization.
+ *
+ * @author jmoringe
+ */
+class RSBSPREAD_EXPORT NotificationFilter {
+public:
+    virtual ~NotificationFilter();
+
+    /**
+     * Decides whether @a notification should be delivered.
+     *
+     * @param notification The received notification. Only its scope
+     *                     and header fields may be inspected.
+     * @return @c true if the notification should be delivered.
+     */
+    virtual bool match(const Notification& notification) const = 0;
+};
+
+typedef boost::shared_ptr<NotificationFilter> NotificationFilterPtr;
+
+/**
+ * Matches notifications whose scope is @a scope or a sub-scope of
+ * it.
+ *
+ * @author jmoringe
+ */
+class RSBSPREAD_EXPORT ScopeNotificationFilter : public NotificationFilter {
+public:
+    ScopeNotificationFilter(const Scope& scope);
+
+    bool match(const Notification& notification) const;
+private:
+    Scope scope;
+};
+
+/**
+ * Matches notifications sent by the participant with id @a origin.
+ *
+ * @author jmoringe
+ */
+class RSBSPREAD_EXPORT OriginNotificationFilter : public NotificationFilter {
+public:
+    /**
+     * @param origin The id of the sending participant.
+     * @param invert If @c true, match notifications of all other
+     *               participants instead.
+     */
+    OriginNotificationFilter(const rsc::misc::UUID& origin,
+                             bool                   invert = false);
+
+    bool match(const Notification& notification) const;
+private:
+    std::string origin;
+    bool        invert;
+};
+
+/**
+ * Matches notifications whose method is @a method. The empty
+ * string matches notifications without method.
+ *
+ * @author jmoringe
+ */
+class RSBSPREAD_EXPORT MethodNotificationFilter : public NotificationFilter {
+public:
+    MethodNotificationFilter(const std::string& method);
+
+    bool match(const Notification& notification) const;
+private:
+    std::string method;
+};
+
+/**
+ * Matches notifications which have @a cause among their causes.
+ *
+ * @author jmoringe
+ */
+class RSBSPREAD_EXPORT CauseNotificationFilter : public NotificationFilter {
+public:
+    CauseNotificationFilter(const EventId& cause);
+
+    bool match(const Notification& notification) const;
+private:
+    std::string     senderId;
+    boost::uint32_t sequenceNumber;
+};
+
+/**
+ * Matches notifications which have a user info item with key
+ * @a key and, optionally, value @a value.
+ *
+ * @author jmoringe
+ */
+class RSBSPREAD_EXPORT UserInfoNotificationFilter : public NotificationFilter {
+public:
+    /**
+     * Matches notifications with a user info item @a key regardless
+     * of its value.
+     */
+    UserInfoNotificationFilter(const std::string& key);
+
+    /**
+     * Matches notifications with a user info item @a key which has
+     * the value @a value.
+     */
+    UserInfoNotificationFilter(const std::string& key,
+                               const std::string& value);
+
+    bool match(const Notification& notification) const;
+private:
+    std::string key;
+    std::string value;
+    bool        checkValue;
+};
+
+}
+}
+}
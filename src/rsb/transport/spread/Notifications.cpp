@@ -0,0 +1,87 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#include "Notifications.h"
+
+namespace rsb {
+namespace transport {
+namespace spread {
+
+std::string notificationKey(const rsb::protocol::EventId& eventId) {
+    std::string key = eventId.sender_id();
+    boost::uint64_t sequenceNumber = eventId.sequence_number();
+    key.push_back((sequenceNumber & 0x000000ff) >> 0);
+    key.push_back((sequenceNumber & 0x0000ff00) >> 8);
+    key.push_back((sequenceNumber & 0x00ff0000) >> 16);
+    key.push_back((sequenceNumber & 0xff000000) >> 24);
+    return key;
+}
+
+Notification::Notification() :
+    notification(0), clockOffset(0), numMissing(0) {
+}
+
+AnnotatedData Notification::deserialize(ConverterPtr converter) {
+    {
+        boost::mutex::scoped_lock lock(this->deserializationMutex);
+        DeserializationCache::const_iterator it = findCached(converter);
+        if (it != this->deserializationCache.end()) {
+            return it->second;
+        }
+    }
+
+    // The lock is not held while deserializing, such that slow
+    // converters do not block connectors using other converters and
+    // converters may deserialize other payloads of this
+    // notification. If several connectors deserialize concurrently,
+    // all of them use the first result.
+    AnnotatedData result
+        = converter->deserialize(this->wireSchema, this->serializedPayload);
+
+    boost::mutex::scoped_lock lock(this->deserializationMutex);
+    DeserializationCache::const_iterator it = findCached(converter);
+    if (it != this->deserializationCache.end()) {
+        return it->second;
+    }
+    this->deserializationCache.push_back(std::make_pair(converter, result));
+    return result;
+}
+
+Notification::DeserializationCache::const_iterator
+Notification::findCached(ConverterPtr converter) const {
+    // There are typically only one or two different converters, so
+    // a linear search is sufficient.
+    DeserializationCache::const_iterator it
+        = this->deserializationCache.begin();
+    while ((it != this->deserializationCache.end()) && (it->first != converter)) {
+        ++it;
+    }
+    return it;
+}
+
+}
+}
+}
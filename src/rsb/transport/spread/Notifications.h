@@ -29,10 +29,15 @@
 #include <string>
 #include <vector>
 
+#include <boost/cstdint.hpp>
 #include <boost/shared_ptr.hpp>
 
+#include <boost/thread/mutex.hpp>
+
 #include <rsb/Scope.h>
 
+#include <rsb/converter/Converter.h>
+
 #include <rsb/protocol/Notification.h>
 #include <rsb/protocol/FragmentedNotification.h>
 
@@ -44,12 +49,76 @@ namespace rsb {
 namespace transport {
 namespace spread {
 
+/**
+ * Returns a key which identifies the notification for the event
+ * with id @a eventId, for example among the fragments of different
+ * notifications.
+ */
+RSBSPREAD_EXPORT std::string notificationKey(const rsb::protocol::EventId& eventId);
+
 class RSBSPREAD_EXPORT Notification {
 public:
+    typedef converter::Converter<std::string>::Ptr ConverterPtr;
+
+    Notification();
+
+    /**
+     * Deserializes the payload using @a converter.
+     *
+     * The result is cached, such that all connectors which receive
+     * this notification, share data (see @ref
+     * InConnector::setShareLocalData) and select the same converter
+     * share a single deserialized data object instead of
+     * deserializing the payload once per connector. Connectors which
+     * do not share data must not use this function since their
+     * handlers may modify the data. Since deserialized data cannot
+     * be copied generically, such connectors deserialize the payload
+     * themselves.
+     *
+     * @param converter The converter to use for deserialization.
+     * @return The type and the deserialized data.
+     */
+    AnnotatedData deserialize(ConverterPtr converter);
+
     Scope                        scope;
     std::string                  wireSchema;
     std::string                  serializedPayload;
+
+    /**
+     * The protobuf header. For received notifications, its wire
+     * schema and data fields are empty since their contents have
+     * been moved to @ref wireSchema and @ref serializedPayload.
+     */
     rsb::protocol::Notification* notification;
+
+    /**
+     * Type and data of the event from which the notification has
+     * been created if it originates in this process. Empty for
+     * received notifications.
+     */
+    AnnotatedData                localData;
+
+    /**
+     * Estimated clock of the sending host minus the local clock in
+     * microseconds. Zero if unknown or if the notification
+     * originates in this process.
+     */
+    boost::int64_t               clockOffset;
+
+    /**
+     * Number of notifications of the same sender which have not been
+     * received immediately before this one. Zero if none are missing
+     * or if the notification originates in this process.
+     */
+    boost::uint32_t              numMissing;
+private:
+    typedef std::vector< std::pair<ConverterPtr, AnnotatedData> > DeserializationCache;
+
+    boost::mutex                 deserializationMutex;
+    DeserializationCache         deserializationCache;
+
+    // Must be called with deserializationMutex held.
+    DeserializationCache::const_iterator findCached(ConverterPtr converter) const;
 };
 
 typedef boost::shared_ptr<Notification> NotificationPtr;
@@ -57,6 +126,12 @@ typedef boost::shared_ptr<Notification> NotificationPtr;
 class RSBSPREAD_EXPORT IncomingNotification : public Notification {
 public:
     rsb::protocol::NotificationPtr notificationOwnership;
+
+    /**
+     * The private group of the Spread connection which sent the
+     * notification.
+     */
+    std::string                    sender;
 };
 
 typedef boost::shared_ptr<IncomingNotification> IncomingNotificationPtr;
@@ -64,9 +139,26 @@ typedef boost::shared_ptr<IncomingNotification> IncomingNotificationPtr;
 
 class RSBSPREAD_EXPORT OutgoingNotification : public Notification {
 public:
+    OutgoingNotification() :
+        compactFragments(false), parityFragments(0) {
+    }
+
     SpreadMessage::QOS                                 qos;
     std::vector<std::string>                           groups;
     std::vector<rsb::protocol::FragmentedNotification> fragments;
+
+    /**
+     * Indicates whether fragments other than the first should be
+     * sent as compact continuation fragments. Only the first
+     * fragment then contains a complete header.
+     */
+    bool                                               compactFragments;
+
+    /**
+     * The number of parity fragments which should be sent after the
+     * fragments if there is more than one fragment.
+     */
+    unsigned int                                       parityFragments;
 };
 
 typedef boost::shared_ptr<OutgoingNotification> OutgoingNotificationPtr;
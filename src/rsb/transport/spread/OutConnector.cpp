@@ -36,6 +36,9 @@
 #include <rsb/protocol/ProtocolException.h>
 #include <rsb/protocol/FragmentedNotification.h>
 
+#include "WireFormat.h"
+#include "Tracepoints.h"
+
 using namespace std;
 
 using namespace rsc::runtime;
@@ -57,7 +60,8 @@ OutConnector::OutConnector(ConverterSelectionStrategyPtr converters,
     qosSpecs(QualityOfServiceSpec(QualityOfServiceSpec::ORDERED,
                                   QualityOfServiceSpec::RELIABLE)),
     messageQOS(SpreadMessage::FIFO),
-    maxFragmentSize(maxFragmentSize), minDataSpace(5) {
+    maxFragmentSize(maxFragmentSize), minDataSpace(5),
+    compressionThreshold(0), compactFragments(false), parityFragments(0) {
 }
 
 OutConnector::~OutConnector() {
@@ -108,6 +112,20 @@ void OutConnector::setQualityOfServiceSpecs(const QualityOfServiceSpec& specs) {
     }
 }
 
+void OutConnector::setCompression(PayloadCodecPtr codec,
+                                  unsigned int    threshold) {
+    this->compressionCodec     = codec;
+    this->compressionThreshold = threshold;
+}
+
+void OutConnector::setCompactFragments(bool compact) {
+    this->compactFragments = compact;
+}
+
+void OutConnector::setParityFragments(unsigned int numParity) {
+    this->parityFragments = numParity;
+}
+
 void OutConnector::handle(EventPtr event) {
     // Store send time in the event. The sending informer could in
     // principle inspect this.
@@ -119,6 +137,11 @@ void OutConnector::handle(EventPtr event) {
     notification->scope  = event->getScope();
     notification->qos    = this->messageQOS;
     notification->groups = this->groupNameCache.scopeToGroups(notification->scope);
+    notification->compactFragments = this->compactFragments;
+    // Reliable delivery makes parity fragments useless.
+    if (this->qosSpecs.getReliability() == QualityOfServiceSpec::UNRELIABLE) {
+        notification->parityFragments = this->parityFragments;
+    }
 
     // TODO exception handling if converter is not available
     std::string& wire = notification->serializedPayload;
@@ -128,23 +151,44 @@ void OutConnector::handle(EventPtr event) {
                                               event->getData()),
                                wire);
     notification->wireSchema = wireSchema;
+    notification->localData  = std::make_pair(event->getType(), event->getData());
+
+    // Local sinks receive the uncompressed payload. Only the
+    // fragments contain the compressed payload, if any.
+    std::string        fragmentWireSchema = wireSchema;
+    std::string        compressedWire;
+    const std::string* fragmentWire       = &wire;
+    if (this->compressionCodec
+        && maybeCompressPayload(*this->compressionCodec,
+                                this->compressionThreshold,
+                                wire, fragmentWireSchema, compressedWire)) {
+        fragmentWire = &compressedWire;
+    }
 
     for (unsigned int fragment = 0, offset = 0;
-         (fragment == 0) || (offset < wire.size());
+         (fragment == 0) || (offset < fragmentWire->size());
          ++fragment) {
         // Allocate and populate a new fragment. When processing the
-        // first fragment, transmit all meta data.
+        // first fragment, transmit all meta data. Compact
+        // continuation fragments take the event id from the first
+        // fragment when being encoded.
         notification->fragments.resize(fragment + 1);
         FragmentedNotification& fragmentNotification
             = notification->fragments.back();
-        fillNotificationId(*(fragmentNotification.mutable_notification()), event);
-        if (fragment == 0) {
-            fillNotificationHeader(*(fragmentNotification.mutable_notification()),
-                                   event, wireSchema);
+        unsigned int headerByteSize;
+        if ((fragment == 0) || !this->compactFragments) {
+            fillNotificationId(*(fragmentNotification.mutable_notification()), event);
+            if (fragment == 0) {
+                fillNotificationHeader(*(fragmentNotification.mutable_notification()),
+                                       event, fragmentWireSchema);
+            }
+            headerByteSize = fragmentNotification.ByteSize();
+        } else {
+            headerByteSize = continuationFragmentHeaderSize
+                (notification->fragments[0].notification().event_id());
         }
 
         // Use remaining space in fragment for payload data.
-        unsigned int headerByteSize = fragmentNotification.ByteSize();
         assert(headerByteSize <= maxFragmentSize - minDataSpace);
         if (headerByteSize >= maxFragmentSize - minDataSpace) {
             throw ProtocolException(
@@ -152,13 +196,21 @@ void OutConnector::handle(EventPtr event) {
         }
         unsigned int maxDataPartSize = maxFragmentSize - headerByteSize;
 
-        std::string dataPart = wire.substr(offset, maxDataPartSize);
-        fragmentNotification.mutable_notification()->set_data(dataPart);
+        fragmentNotification.mutable_notification()->mutable_data()
+            ->assign(*fragmentWire, offset, maxDataPartSize);
         offset += maxDataPartSize;
 
         // Optimistic guess for the number of required fragments.
         fragmentNotification.set_data_part(fragment);
         fragmentNotification.set_num_data_parts(1);
+
+        RSBSPREAD_TRACE4(fragment,
+                         notification->fragments[0].notification().event_id()
+                             .sender_id().data(),
+                         notification->fragments[0].notification().event_id()
+                             .sequence_number(),
+                         fragment,
+                         fragmentNotification.notification().data().size());
     }
 
     // We must apparently delay this until now since the pointer
@@ -40,6 +40,7 @@
 
 #include "GroupNameCache.h"
 #include "SpreadMessage.h"
+#include "Compression.h"
 
 #include "rsb/transport/spread/rsbspreadexports.h"
 
@@ -68,6 +69,47 @@ public:
 
     void setQualityOfServiceSpecs(const QualityOfServiceSpec& specs);
 
+    /**
+     * Configures compression of serialized payloads.
+     *
+     * @param codec The codec which should be used for compressing
+     *              payloads. An empty pointer disables compression.
+     * @param threshold Payloads smaller than this number of bytes
+     *                  are sent uncompressed.
+     */
+    void setCompression(PayloadCodecPtr codec, unsigned int threshold);
+
+    /**
+     * Controls whether fragments other than the first are sent with
+     * a compact binary header instead of a protobuf header.
+     *
+     * Receivers of versions which do not understand compact
+     * fragments fail to parse them and stop receiving altogether.
+     * Compact fragments should therefore only be enabled when all
+     * participants on the Spread segment support them.
+     *
+     * @param compact If @c true, send compact continuation
+     *                fragments.
+     */
+    void setCompactFragments(bool compact);
+
+    /**
+     * Sets the number of parity fragments which are sent in addition
+     * to the data fragments of each fragmented event on scopes with
+     * unreliable quality of service. Receivers use a parity fragment
+     * to rebuild one lost data fragment of its group. Data fragment
+     * i belongs to group i modulo @a numParity.
+     *
+     * Like compact fragments, parity fragments make receivers of
+     * versions which do not understand them stop receiving and
+     * should only be enabled when all participants on the Spread
+     * segment support them.
+     *
+     * @param numParity The number of parity fragments per event. 0
+     *                  disables parity fragments.
+     */
+    void setParityFragments(unsigned int numParity);
+
 private:
 
     rsc::logging::LoggerPtr logger;
@@ -85,6 +127,13 @@ private:
      */
     unsigned int            minDataSpace;
 
+    PayloadCodecPtr         compressionCodec;
+    unsigned int            compressionThreshold;
+
+    bool                    compactFragments;
+
+    unsigned int            parityFragments;
+
 };
 
 }
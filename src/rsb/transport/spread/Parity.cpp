@@ -0,0 +1,145 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#include "Parity.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include <boost/format.hpp>
+
+#include <rsb/protocol/ProtocolException.h>
+
+namespace rsb {
+namespace transport {
+namespace spread {
+
+namespace {
+
+void xorInto(std::string& target, const std::string& source) {
+    assert(source.size() <= target.size());
+    std::string::iterator out = target.begin();
+    for (std::string::const_iterator it = source.begin();
+         it != source.end(); ++it, ++out) {
+        *out ^= *it;
+    }
+}
+
+}
+
+void makeParityFragments(std::vector<rsb::protocol::FragmentedNotification>& fragments,
+                         unsigned int                                        numParity,
+                         std::vector<ParityFragment>&                        parity) {
+    assert(!fragments.empty());
+
+    unsigned int numData = fragments.size();
+    numParity = std::min(numParity, numData);
+
+    // Receivers need the header of the first fragment to rebuild it.
+    std::string header;
+    {
+        rsb::protocol::Notification* first = fragments[0].mutable_notification();
+        std::string data;
+        data.swap(*first->mutable_data());
+        first->SerializeToString(&header);
+        data.swap(*first->mutable_data());
+    }
+
+    parity.clear();
+    parity.resize(numParity);
+    for (unsigned int group = 0; group < numParity; ++group) {
+        ParityFragment& fragment = parity[group];
+        fragment.eventId        = fragments[0].notification().event_id();
+        fragment.numDataParts   = numData;
+        fragment.numParityParts = numParity;
+        fragment.parityIndex    = group;
+        fragment.lengthParity   = 0;
+        fragment.header         = header;
+
+        std::size_t maxSize = 0;
+        for (unsigned int part = group; part < numData; part += numParity) {
+            maxSize = std::max(maxSize, fragments[part].notification().data().size());
+        }
+        fragment.data.assign(maxSize, '\0');
+        for (unsigned int part = group; part < numData; part += numParity) {
+            const std::string& data = fragments[part].notification().data();
+            xorInto(fragment.data, data);
+            fragment.lengthParity ^= data.size();
+        }
+    }
+}
+
+rsb::protocol::FragmentedNotificationPtr
+recoverFragment(const ParityFragment&                                          parity,
+                const std::vector<rsb::protocol::FragmentedNotificationPtr>& fragments,
+                unsigned int                                                   part) {
+    assert(fragments.size() == parity.numDataParts);
+    assert(part % parity.numParityParts == parity.parityIndex);
+
+    std::string     data   = parity.data;
+    boost::uint32_t length = parity.lengthParity;
+    for (unsigned int i = parity.parityIndex; i < parity.numDataParts;
+         i += parity.numParityParts) {
+        if (i == part) {
+            continue;
+        }
+        assert(fragments[i]);
+        const std::string& other = fragments[i]->notification().data();
+        if (other.size() > data.size()) {
+            throw rsb::protocol::ProtocolException
+                ("Parity fragment is shorter than a data fragment of its group");
+        }
+        xorInto(data, other);
+        length ^= other.size();
+    }
+    if (length > data.size()) {
+        throw rsb::protocol::ProtocolException
+            (boost::str(boost::format("Rebuilt fragment length %1% exceeds parity "
+                                      "fragment length %2%")
+                        % length % data.size()));
+    }
+    data.resize(length);
+
+    rsb::protocol::FragmentedNotificationPtr result
+        (new rsb::protocol::FragmentedNotification());
+    rsb::protocol::Notification* notification = result->mutable_notification();
+    if (part == 0) {
+        if (!notification->ParseFromString(parity.header)) {
+            throw rsb::protocol::ProtocolException
+                ("Failed to parse notification header of parity fragment");
+        }
+    } else {
+        *notification->mutable_event_id() = parity.eventId;
+    }
+    notification->mutable_data()->swap(data);
+    result->set_data_part(part);
+    result->set_num_data_parts(parity.numDataParts);
+    return result;
+}
+
+}
+}
+}
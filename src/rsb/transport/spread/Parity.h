@@ -0,0 +1,91 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#pragma once
+
+#include <vector>
+
+#include <rsb/protocol/FragmentedNotification.h>
+
+#include "WireFormat.h"
+
+#include "rsb/transport/spread/rsbspreadexports.h"
+
+namespace rsb {
+namespace transport {
+namespace spread {
+
+/**
+ * @name Forward error correction
+ *
+ * Parity fragments, see @ref ParityFragment, allow receivers to
+ * rebuild one lost data fragment per parity group without a
+ * retransmission. Since consecutive data fragments belong to
+ * different groups, a burst of up to as many lost fragments as there
+ * are parity fragments can be repaired.
+ */
+//@{
+
+/**
+ * Computes parity fragments for the data fragments @a fragments.
+ *
+ * @param fragments The complete data fragments of one
+ *                  notification. Not modified, but the data of the
+ *                  first fragment is temporarily moved out to
+ *                  serialize its header without copying the data.
+ * @param numParity The number of parity fragments. Values larger
+ *                  than the number of data fragments are reduced to
+ *                  that number.
+ * @param parity Replaced by the parity fragments.
+ */
+RSBSPREAD_EXPORT void
+makeParityFragments(std::vector<rsb::protocol::FragmentedNotification>& fragments,
+                    unsigned int                                        numParity,
+                    std::vector<ParityFragment>&                        parity);
+
+/**
+ * Rebuilds the data fragment with index @a part from @a parity and
+ * the other fragments of its parity group.
+ *
+ * @param parity The parity fragment of the group of @a part.
+ * @param fragments The received data fragments indexed by part. All
+ *                  fragments of the group other than @a part must be
+ *                  present.
+ * @param part The index of the fragment to rebuild.
+ * @return The rebuilt fragment.
+ * @throw rsb::protocol::ProtocolException if the parity fragment is
+ *        inconsistent with the data fragments.
+ */
+RSBSPREAD_EXPORT rsb::protocol::FragmentedNotificationPtr
+recoverFragment(const ParityFragment&                                          parity,
+                const std::vector<rsb::protocol::FragmentedNotificationPtr>& fragments,
+                unsigned int                                                   part);
+
+//@}
+
+}
+}
+}
@@ -27,19 +27,67 @@
 
 #include "ReceiverTask.h"
 
+#include <algorithm>
+
+#include <rsc/misc/langutils.h>
+
 #include <rsb/CommException.h>
+#include <rsb/protocol/ProtocolException.h>
+
+#include "WireFormat.h"
 
 namespace rsb {
 namespace transport {
 namespace spread {
 
-ReceiverTask::ReceiverTask(SpreadConnectionPtr connection,
-                           HandlerPtr          handler) :
+namespace {
+
+// Interval in microseconds between queries of the pending bytes.
+const boost::uint64_t PENDING_BYTES_QUERY_INTERVAL = 100000;
+
+}
+
+ReceiverTask::ReceiverTask(ConnectionPtr                connection,
+                           HandlerPtr                   handler,
+                           const std::set<std::string>& ignoredSenders,
+                           MetricsRegistryPtr           metrics) :
     logger(rsc::logging::Logger::getLogger("rsb.transport.spread.ReceiverTask")),
-    connection(connection), handler(handler) {
+    connection(connection), ignoredSenders(ignoredSenders), handler(handler),
+    metrics(metrics ? metrics : MetricsRegistryPtr(new MetricsRegistry())),
+    receiveFailures(this->metrics->getCounter
+                    ("rsb_spread_receive_failures_total",
+                     "Errors which terminated receiving from a connection,"
+                     " for example because the daemon closed the"
+                     " connection.")),
+    malformedMessages(this->metrics->getCounter
+                      ("rsb_spread_malformed_messages_total",
+                       "Received Spread messages which have been discarded"
+                       " because they could not be parsed.")),
+    pendingBytes(this->metrics->getGauge
+                 ("rsb_spread_receive_queue_bytes",
+                  "Bytes of received Spread messages waiting to be processed.")),
+    lastPendingBytes(0), lastPendingBytesQuery(0) {
+    this->messageHandler.setMetrics(this->metrics);
+
+    const SpreadMessage::QOS levels[NUM_QOS_LEVELS] = {
+        SpreadMessage::UNRELIABLE, SpreadMessage::RELIABLE,
+        SpreadMessage::FIFO, SpreadMessage::CAUSAL,
+        SpreadMessage::AGREED, SpreadMessage::SAFE
+    };
+    for (unsigned int i = 0; i < NUM_QOS_LEVELS; ++i) {
+        MetricLabels labels;
+        labels.add("qos", qosName(levels[i]));
+        this->messagesReceived[qosIndex(levels[i])] = &this->metrics->getCounter
+            ("rsb_spread_messages_received_total",
+             "Spread messages received.", labels);
+        this->bytesReceived[qosIndex(levels[i])] = &this->metrics->getCounter
+            ("rsb_spread_bytes_received_total",
+             "Bytes of received Spread messages.", labels);
+    }
 }
 
 ReceiverTask::~ReceiverTask() {
+    this->pendingBytes.add(-this->lastPendingBytes);
 }
 
 void ReceiverTask::execute() {
@@ -48,12 +96,41 @@ void ReceiverTask::execute() {
         SpreadMessage message;
         this->connection->receive(message);
 
-        IncomingNotificationPtr notification
-            = this->messageHandler.handleMessage(message);
+        unsigned int qos = qosIndex(message.getQOS());
+        this->messagesReceived[qos]->increment();
+        this->bytesReceived[qos]->increment(message.getSize());
+
+        updatePendingBytes(message);
+
+        // Messages sent via sibling connections have already been
+        // delivered locally by the sending bus.
+        if (!this->ignoredSenders.empty()
+            && this->ignoredSenders.count(message.getSender())) {
+            return;
+        }
+
+        if (isControlMessage(message.getData())) {
+            this->handler->handleControlMessage(message);
+            return;
+        }
+
+        // A malformed message, for example from a participant using
+        // an incompatible version, says nothing about the connection.
+        // Discard it instead of reconnecting.
+        IncomingNotificationPtr notification;
+        try {
+            notification = this->messageHandler.handleMessage(message);
+        } catch (const rsb::protocol::ProtocolException& exception) {
+            this->malformedMessages.increment();
+            RSCWARN(this->logger, "Discarding malformed message from "
+                    << message.getSender() << ": " << exception.what());
+            return;
+        }
         if (notification) {
             this->handler->handleIncomingNotification(notification);
         }
     } catch (const rsb::CommException& exception) {
+        this->receiveFailures.increment();
         this->handler->handleError(exception);
         this->cancel();
     } catch (const boost::thread_interrupted&) {
@@ -61,10 +138,43 @@ void ReceiverTask::execute() {
     }
 }
 
+void ReceiverTask::updatePendingBytes(const SpreadMessage& message) {
+    // Between queries, the received messages are subtracted from the
+    // last result. Messages arriving in the meantime are only
+    // accounted for by the next query.
+    int pending;
+    boost::uint64_t now = rsc::misc::currentTimeMicros();
+    if (now - this->lastPendingBytesQuery >= PENDING_BYTES_QUERY_INTERVAL) {
+        pending = this->connection->getPendingBytes();
+        this->lastPendingBytesQuery = now;
+    } else {
+        pending = std::max(0, this->lastPendingBytes - message.getSize());
+    }
+
+    // Gauges are shared between buses, so only the change is
+    // recorded.
+    this->pendingBytes.add(pending - this->lastPendingBytes);
+    this->lastPendingBytes = pending;
+}
+
 void ReceiverTask::setPruning(const bool& pruning) {
     this->messageHandler.setPruning(pruning);
 }
 
+void ReceiverTask::setScopeMetrics(bool scopeMetrics) {
+    this->messageHandler.setScopeMetrics(scopeMetrics);
+}
+
+void ReceiverTask::setTrackSequenceNumbers(bool track) {
+    this->messageHandler.setTrackSequenceNumbers(track);
+}
+
+void ReceiverTask::collectNacks(unsigned int                            delayMs,
+                                unsigned int                            maxNacks,
+                                std::vector<AssemblyPool::NackRequest>& requests) {
+    this->messageHandler.collectNacks(delayMs, maxNacks, requests);
+}
+
 }
 }
 }
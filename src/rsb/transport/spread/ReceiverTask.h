@@ -27,6 +27,10 @@
 
 #pragma once
 
+#include <set>
+#include <string>
+
+#include <boost/cstdint.hpp>
 #include <boost/shared_ptr.hpp>
 
 #include <boost/thread.hpp>
@@ -38,9 +42,10 @@
 
 #include <rsb/protocol/Notification.h>
 
-#include "SpreadConnection.h"
+#include "Connection.h"
 #include "DeserializingHandler.h"
 #include "Notifications.h"
+#include "Metrics.h"
 
 #include "rsb/transport/spread/rsbspreadexports.h"
 
@@ -50,7 +55,7 @@ namespace spread {
 
 /**
  * A task that receives @c FragmentedNotifications from a @c
- * SpreadConnection, deserializes them to events and notifies a
+ * Connection, deserializes them to events and notifies a
  * handler with deserialized Events.
  *
  * Messages may be split into multiple @c FragmentedNotifications to
@@ -71,12 +76,40 @@ public:
     public:
         virtual void handleIncomingNotification(IncomingNotificationPtr notification) = 0;
 
+        /**
+         * Handles a received control message, such as a clock
+         * synchronization request, which does not carry a
+         * notification.
+         */
+        virtual void handleControlMessage(const SpreadMessage& message) = 0;
+
         virtual void handleError(const std::exception& error) = 0;
     };
     typedef boost::shared_ptr<Handler> HandlerPtr;
 
-    ReceiverTask(SpreadConnectionPtr connection,
-                 HandlerPtr          handler);
+    /**
+     * Creates a task that receives from @a connection and notifies
+     * @a handler.
+     *
+     * @param connection The connection from which messages should be
+     *                   received.
+     * @param handler The handler which should be notified about
+     *                received notifications and errors.
+     * @param ignoredSenders Private groups of connections whose
+     *                       messages should be discarded without
+     *                       deserializing them. This is used to
+     *                       suppress messages sent via other
+     *                       connections of the same bus.
+     * @param metrics Registry in which metrics about received
+     *                messages and the receive queue should be
+     *                recorded. If empty, a private registry is used.
+     */
+    ReceiverTask(ConnectionPtr                connection,
+                 HandlerPtr                   handler,
+                 const std::set<std::string>& ignoredSenders
+                 = std::set<std::string>(),
+                 MetricsRegistryPtr           metrics
+                 = MetricsRegistryPtr());
     virtual ~ReceiverTask();
 
     void execute();
@@ -90,6 +123,28 @@ public:
      */
     void setPruning(const bool& pruning);
 
+    /**
+     * See @ref DeserializingHandler::setScopeMetrics. Has to be
+     * called before the task is scheduled.
+     */
+    void setScopeMetrics(bool scopeMetrics);
+
+    /**
+     * See @ref DeserializingHandler::setTrackSequenceNumbers.
+     * Thread-safe method.
+     */
+    void setTrackSequenceNumbers(bool track);
+
+    /**
+     * Collects requests for missing fragments of incomplete
+     * notifications. Thread-safe method.
+     *
+     * See @ref AssemblyPool::collectNacks.
+     */
+    void collectNacks(unsigned int                            delayMs,
+                      unsigned int                            maxNacks,
+                      std::vector<AssemblyPool::NackRequest>& requests);
+
 private:
 
     /**
@@ -101,13 +156,33 @@ private:
      */
     void notifyHandler(protocol::NotificationPtr notification);
 
+    /**
+     * Updates the gauge of pending bytes after receiving @a message.
+     */
+    void updatePendingBytes(const SpreadMessage& message);
+
     rsc::logging::LoggerPtr logger;
 
-    SpreadConnectionPtr     connection;
+    ConnectionPtr           connection;
+    std::set<std::string>   ignoredSenders;
     DeserializingHandler    messageHandler;
 
     HandlerPtr              handler;
     boost::recursive_mutex  handlerMutex;
+
+    // Metrics are looked up once since the registry is locked for
+    // each lookup.
+    MetricsRegistryPtr      metrics;
+    Counter*                messagesReceived[NUM_QOS_LEVELS];
+    Counter*                bytesReceived[NUM_QOS_LEVELS];
+    Counter&                receiveFailures;
+    Counter&                malformedMessages;
+
+    // Querying the pending bytes is a call into the Spread library,
+    // so it is only done periodically.
+    Gauge&                  pendingBytes;
+    int                     lastPendingBytes;
+    boost::uint64_t         lastPendingBytesQuery;
 };
 
 }
@@ -0,0 +1,188 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#include "ReplayConnection.h"
+
+#include <boost/format.hpp>
+
+#include <boost/thread/thread.hpp>
+
+#include <rsc/misc/IllegalStateException.h>
+#include <rsc/misc/langutils.h>
+
+namespace rsb {
+namespace transport {
+namespace spread {
+
+ReplayConnection::ReplayConnection(CaptureReaderPtr reader, bool realTime) :
+    reader(reader), realTime(realTime), privateGroup("#replay#capture"),
+    active(false), interrupted(false), started(false), finished(false), numReplayed(0),
+    replayStart(0), captureStart(0) {
+}
+
+void ReplayConnection::printContents(std::ostream& stream) const {
+    boost::mutex::scoped_lock lock(this->mutex);
+    stream << "realTime = " << this->realTime
+           << ", numReplayed = " << this->numReplayed;
+}
+
+const std::string ReplayConnection::getTransportURL() const {
+    return "spread://replay";
+}
+
+const std::string& ReplayConnection::getPrivateGroup() const {
+    return this->privateGroup;
+}
+
+bool ReplayConnection::isActive() const {
+    boost::mutex::scoped_lock lock(this->mutex);
+    return this->active;
+}
+
+void ReplayConnection::activate() {
+    boost::mutex::scoped_lock lock(this->mutex);
+    if (this->active) {
+        throw rsc::misc::IllegalStateException
+            ("Replay connection is already active.");
+    }
+    this->active = true;
+}
+
+void ReplayConnection::deactivate() {
+    boost::mutex::scoped_lock lock(this->mutex);
+    if (!this->active) {
+        throw rsc::misc::IllegalStateException("Connection is not active.");
+    }
+    this->active = false;
+}
+
+void ReplayConnection::join(const std::string& /*group*/) {
+    if (!isActive()) {
+        throw rsc::misc::IllegalStateException("Connection is not active.");
+    }
+}
+
+void ReplayConnection::leave(const std::string& /*group*/) {
+    if (!isActive()) {
+        throw rsc::misc::IllegalStateException("Connection is not active.");
+    }
+}
+
+void ReplayConnection::receive(SpreadMessage& message) {
+    boost::mutex::scoped_lock lock(this->mutex);
+
+    if (!this->active) {
+        throw rsc::misc::IllegalStateException("Connection is not active.");
+    }
+
+    CaptureRecord record;
+    while (true) {
+        if (this->interrupted) {
+            this->interrupted = false;
+            throw boost::thread_interrupted();
+        }
+
+        if (!this->started || this->finished) {
+            this->condition.wait(lock);
+            continue;
+        }
+
+        if (!this->reader->next(record)) {
+            this->finished = true;
+            this->condition.notify_all();
+            continue;
+        }
+        if (record.direction == CAPTURE_RECEIVED) {
+            break;
+        }
+    }
+
+    if (this->realTime) {
+        boost::uint64_t now = rsc::misc::currentTimeMicros();
+        if (this->numReplayed == 0) {
+            this->replayStart  = now;
+            this->captureStart = record.timestamp;
+        }
+        boost::uint64_t due
+            = this->replayStart + (record.timestamp - this->captureStart);
+        while ((now < due) && !this->interrupted) {
+            this->condition.timed_wait
+                (lock, boost::posix_time::microseconds(due - now));
+            now = rsc::misc::currentTimeMicros();
+        }
+    }
+
+    message = record.message;
+    ++this->numReplayed;
+}
+
+void ReplayConnection::send(const SpreadMessage& /*message*/) {
+    if (!isActive()) {
+        throw rsc::misc::IllegalStateException("Connection is not active.");
+    }
+}
+
+int ReplayConnection::getPendingBytes() const {
+    if (!isActive()) {
+        throw rsc::misc::IllegalStateException("Connection is not active.");
+    }
+    return 0;
+}
+
+void ReplayConnection::interruptReceive() {
+    {
+        boost::mutex::scoped_lock lock(this->mutex);
+        if (!this->active) {
+            throw rsc::misc::IllegalStateException("Connection is not active.");
+        }
+        this->interrupted = true;
+    }
+    this->condition.notify_all();
+}
+
+void ReplayConnection::start() {
+    {
+        boost::mutex::scoped_lock lock(this->mutex);
+        this->started = true;
+    }
+    this->condition.notify_all();
+}
+
+void ReplayConnection::waitFinished() {
+    boost::mutex::scoped_lock lock(this->mutex);
+    while (!this->finished) {
+        this->condition.wait(lock);
+    }
+}
+
+boost::uint64_t ReplayConnection::getNumReplayed() const {
+    boost::mutex::scoped_lock lock(this->mutex);
+    return this->numReplayed;
+}
+
+}
+}
+}
@@ -0,0 +1,138 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#pragma once
+
+#include <string>
+
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+#include "Connection.h"
+#include "CaptureFile.h"
+
+#include "rsb/transport/spread/rsbspreadexports.h"
+
+namespace rsb {
+namespace transport {
+namespace spread {
+
+/**
+ * A @ref Connection which receives the messages recorded as received
+ * in a capture file instead of communicating with a Spread daemon.
+ *
+ * A @ref BusImpl using this connection processes captured traffic
+ * like live traffic, which allows profiling reassembly and dispatch
+ * on identical input. Sent messages are discarded and joining or
+ * leaving groups has no effect. Messages are only received after
+ * #start has been called, such that sinks can be added to the bus
+ * first. Once all messages have been received, #receive blocks until
+ * it is interrupted.
+ *
+ * @note Unlike @ref SpreadConnection, all methods of this class are
+ *       thread-safe.
+ *
+ * @author jmoringe
+ */
+class RSBSPREAD_EXPORT ReplayConnection : public Connection {
+public:
+    /**
+     * @param reader Reader for the capture file. Reading starts at
+     *               its current position.
+     * @param realTime If @c true, messages are received with the
+     *                 delays between them at capture time. Otherwise
+     *                 messages are received as fast as possible.
+     */
+    ReplayConnection(CaptureReaderPtr reader, bool realTime);
+
+    void printContents(std::ostream& stream) const;
+
+    const std::string getTransportURL() const;
+
+    const std::string& getPrivateGroup() const;
+
+    bool isActive() const;
+
+    void activate();
+    void deactivate();
+
+    void join(const std::string& group);
+    void leave(const std::string& group);
+
+    void receive(SpreadMessage& message);
+
+    void send(const SpreadMessage& message);
+
+    int getPendingBytes() const;
+
+    void interruptReceive();
+
+    /**
+     * Starts receiving captured messages.
+     */
+    void start();
+
+    /**
+     * Blocks until all captured messages have been received and the
+     * receiver asks for the next message, i.e. until the receiver
+     * has processed all captured messages.
+     */
+    void waitFinished();
+
+    /**
+     * Returns the number of messages received so far.
+     */
+    boost::uint64_t getNumReplayed() const;
+private:
+    CaptureReaderPtr          reader;
+    bool                      realTime;
+    std::string               privateGroup;
+
+    mutable boost::mutex      mutex;
+    boost::condition_variable condition;
+    bool                      active;
+    bool                      interrupted;
+    bool                      started;
+    bool                      finished;
+    boost::uint64_t           numReplayed;
+
+    /**
+     * Start of the replay and capture time of the first received
+     * message in microseconds since the epoch. Used for receiving
+     * in real time.
+     */
+    boost::uint64_t           replayStart;
+    boost::uint64_t           captureStart;
+};
+
+typedef boost::shared_ptr<ReplayConnection> ReplayConnectionPtr;
+
+}
+}
+}
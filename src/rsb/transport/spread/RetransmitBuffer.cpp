@@ -0,0 +1,90 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#include "RetransmitBuffer.h"
+
+#include <rsc/misc/langutils.h>
+
+namespace rsb {
+namespace transport {
+namespace spread {
+
+RetransmitBuffer::RetransmitBuffer(unsigned int maxNotifications,
+                                   unsigned int maxAgeMs) :
+    maxNotifications(maxNotifications),
+    maxAgeMicros(boost::uint64_t(maxAgeMs) * 1000) {
+}
+
+void RetransmitBuffer::add(OutgoingNotificationPtr notification) {
+    boost::mutex::scoped_lock lock(this->mutex);
+
+    boost::uint64_t now = rsc::misc::currentTimeMicros();
+    std::string key = notificationKey(notification->notification->event_id());
+
+    Entry entry;
+    entry.notification = notification;
+    entry.addTime      = now;
+    if (this->entries.insert(std::make_pair(key, entry)).second) {
+        this->order.push_back(key);
+    }
+
+    dropOld(now);
+}
+
+OutgoingNotificationPtr
+RetransmitBuffer::find(const rsb::protocol::EventId& eventId) {
+    boost::mutex::scoped_lock lock(this->mutex);
+
+    dropOld(rsc::misc::currentTimeMicros());
+
+    EntryMap::const_iterator it = this->entries.find(notificationKey(eventId));
+    if (it == this->entries.end()) {
+        return OutgoingNotificationPtr();
+    }
+    return it->second.notification;
+}
+
+unsigned int RetransmitBuffer::size() const {
+    boost::mutex::scoped_lock lock(this->mutex);
+
+    return this->entries.size();
+}
+
+void RetransmitBuffer::dropOld(boost::uint64_t now) {
+    while (!this->order.empty()) {
+        EntryMap::iterator it = this->entries.find(this->order.front());
+        if ((this->entries.size() <= this->maxNotifications)
+            && (now - it->second.addTime <= this->maxAgeMicros)) {
+            break;
+        }
+        this->entries.erase(it);
+        this->order.pop_front();
+    }
+}
+
+}
+}
+}
@@ -0,0 +1,110 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#pragma once
+
+#include <string>
+#include <map>
+#include <deque>
+
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <boost/thread/mutex.hpp>
+
+#include <rsb/protocol/FragmentedNotification.h>
+
+#include "Notifications.h"
+
+#include "rsb/transport/spread/rsbspreadexports.h"
+
+namespace rsb {
+namespace transport {
+namespace spread {
+
+/**
+ * Keeps recently sent notifications such that fragments which
+ * receivers report as missing can be sent again.
+ *
+ * The buffer is bounded by the number of notifications and by their
+ * age. When a notification is added, the oldest notifications are
+ * dropped until both limits are satisfied.
+ *
+ * Instances are thread-safe.
+ *
+ * @author jmoringe
+ */
+class RSBSPREAD_EXPORT RetransmitBuffer {
+public:
+    /**
+     * @param maxNotifications The maximum number of buffered
+     *                         notifications.
+     * @param maxAgeMs The time in milliseconds after which buffered
+     *                 notifications are dropped.
+     */
+    explicit RetransmitBuffer(unsigned int maxNotifications = 64,
+                              unsigned int maxAgeMs         = 10000);
+
+    /**
+     * Buffers @a notification after it has been sent.
+     */
+    void add(OutgoingNotificationPtr notification);
+
+    /**
+     * Returns the buffered notification of the event with id
+     * @a eventId or a 0 pointer if it is not (or no longer)
+     * buffered.
+     */
+    OutgoingNotificationPtr find(const rsb::protocol::EventId& eventId);
+
+    /**
+     * Returns the number of buffered notifications.
+     */
+    unsigned int size() const;
+private:
+    struct Entry {
+        OutgoingNotificationPtr notification;
+        boost::uint64_t         addTime;
+    };
+
+    typedef std::map<std::string, Entry> EntryMap;
+
+    unsigned int            maxNotifications;
+    boost::uint64_t         maxAgeMicros;
+
+    mutable boost::mutex    mutex;
+    EntryMap                entries;
+    // Keys of entries in the order in which they have been added.
+    std::deque<std::string> order;
+
+    void dropOld(boost::uint64_t now);
+};
+
+typedef boost::shared_ptr<RetransmitBuffer> RetransmitBufferPtr;
+
+}
+}
+}
@@ -0,0 +1,128 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#include "SequenceTracker.h"
+
+namespace rsb {
+namespace transport {
+namespace spread {
+
+namespace {
+
+const boost::uint32_t WINDOW_SIZE = 64;
+
+}
+
+SequenceTracker::SequenceTracker(unsigned int maxSenders) :
+    maxSenders(maxSenders), useCounter(0) {
+    this->stats.received   = 0;
+    this->stats.missing    = 0;
+    this->stats.reordered  = 0;
+    this->stats.duplicates = 0;
+}
+
+SequenceTracker::Observation
+SequenceTracker::observe(const std::string& senderId,
+                         boost::uint32_t    sequenceNumber) {
+    ++this->stats.received;
+
+    Observation result;
+    result.kind       = Observation::IN_ORDER;
+    result.numMissing = 0;
+
+    SenderMap::iterator it = this->senders.find(senderId);
+    if (it == this->senders.end()) {
+        // Nothing is known about the notifications of the sender
+        // before it has been observed for the first time.
+        if (this->senders.size() >= this->maxSenders) {
+            evictLeastRecentlyUsed();
+        }
+        Sender sender;
+        sender.highest = sequenceNumber;
+        sender.seen    = 1;
+        sender.lastUse = ++this->useCounter;
+        this->senders.insert(std::make_pair(senderId, sender));
+        return result;
+    }
+
+    Sender& sender = it->second;
+    sender.lastUse = ++this->useCounter;
+
+    // Unsigned differences handle wrap-around of sequence
+    // numbers. Differences of less than half the range indicate
+    // newer sequence numbers.
+    boost::uint32_t ahead = sequenceNumber - sender.highest;
+    if (ahead == 0) {
+        result.kind = Observation::DUPLICATE;
+        ++this->stats.duplicates;
+    } else if (ahead < 0x80000000u) {
+        if (ahead > 1) {
+            result.kind       = Observation::GAP;
+            result.numMissing = ahead - 1;
+            this->stats.missing += ahead - 1;
+        }
+        sender.seen    = (ahead < WINDOW_SIZE) ? ((sender.seen << ahead) | 1) : 1;
+        sender.highest = sequenceNumber;
+    } else {
+        boost::uint32_t behind = sender.highest - sequenceNumber;
+        boost::uint64_t bit = (behind < WINDOW_SIZE)
+            ? (boost::uint64_t(1) << behind) : 0;
+        if (bit && (sender.seen & bit)) {
+            result.kind = Observation::DUPLICATE;
+            ++this->stats.duplicates;
+        } else {
+            result.kind = Observation::REORDERED;
+            ++this->stats.reordered;
+            sender.seen |= bit;
+        }
+    }
+    return result;
+}
+
+SequenceTracker::Stats SequenceTracker::getStats() const {
+    return this->stats;
+}
+
+unsigned int SequenceTracker::getNumSenders() const {
+    return this->senders.size();
+}
+
+void SequenceTracker::evictLeastRecentlyUsed() {
+    SenderMap::iterator oldest = this->senders.begin();
+    for (SenderMap::iterator it = this->senders.begin();
+         it != this->senders.end(); ++it) {
+        if (it->second.lastUse < oldest->second.lastUse) {
+            oldest = it;
+        }
+    }
+    if (oldest != this->senders.end()) {
+        this->senders.erase(oldest);
+    }
+}
+
+}
+}
+}
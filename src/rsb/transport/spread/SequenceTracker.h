@@ -0,0 +1,184 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#pragma once
+
+#include <string>
+#include <map>
+
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <rsc/misc/UUID.h>
+
+#include <rsb/Scope.h>
+
+#include "rsb/transport/spread/rsbspreadexports.h"
+
+namespace rsb {
+namespace transport {
+namespace spread {
+
+/**
+ * Tracks the sequence numbers of received notifications per sender
+ * to detect lost, reordered and duplicated notifications.
+ *
+ * Sequence numbers are assigned consecutively by each sending
+ * participant. A notification whose sequence number is larger than
+ * the next expected one reveals a gap. Notifications from within a
+ * gap which arrive later are reported as reordered, such that the
+ * number of lost notifications is the number of missing ones minus
+ * the number of reordered ones. Within a window of the most recent
+ * 64 sequence numbers, notifications which have been received before
+ * are reported as duplicates. Older notifications are always
+ * reported as reordered.
+ *
+ * Since only complete notifications are observed, notifications of
+ * which some fragments have been lost count as missing.
+ *
+ * Instances are not thread-safe.
+ *
+ * @author jmoringe
+ */
+class RSBSPREAD_EXPORT SequenceTracker {
+public:
+    /**
+     * The classification of an observed sequence number.
+     */
+    struct Observation {
+        enum Kind {
+            /**
+             * The expected next sequence number or the first
+             * sequence number of a sender.
+             */
+            IN_ORDER,
+            /**
+             * A sequence number following one or more missing ones.
+             */
+            GAP,
+            /**
+             * A sequence number which is older than the most recent
+             * one and has not been received before.
+             */
+            REORDERED,
+            /**
+             * A sequence number which has been received before.
+             */
+            DUPLICATE
+        };
+
+        Kind            kind;
+
+        /**
+         * For @ref GAP, the number of sequence numbers missing
+         * immediately before the observed one. 0 otherwise.
+         */
+        boost::uint32_t numMissing;
+    };
+
+    /**
+     * Totals of all observations.
+     */
+    struct Stats {
+        boost::uint64_t received;
+        boost::uint64_t missing;
+        boost::uint64_t reordered;
+        boost::uint64_t duplicates;
+    };
+
+    /**
+     * @param maxSenders The maximum number of senders which are
+     *                   tracked. When exceeded, the sender which
+     *                   has been observed least recently is
+     *                   forgotten.
+     */
+    explicit SequenceTracker(unsigned int maxSenders = 1024);
+
+    /**
+     * Classifies @a sequenceNumber of a notification from the
+     * sender with id @a senderId.
+     */
+    Observation observe(const std::string& senderId,
+                        boost::uint32_t    sequenceNumber);
+
+    Stats getStats() const;
+
+    /**
+     * Returns the number of currently tracked senders.
+     */
+    unsigned int getNumSenders() const;
+private:
+    struct Sender {
+        boost::uint32_t highest;
+        // Bit i is set if highest - i has been received.
+        boost::uint64_t seen;
+        boost::uint64_t lastUse;
+    };
+
+    typedef std::map<std::string, Sender> SenderMap;
+
+    unsigned int    maxSenders;
+    SenderMap       senders;
+    boost::uint64_t useCounter;
+    Stats           stats;
+
+    void evictLeastRecentlyUsed();
+};
+
+/**
+ * Event data which reports notifications of a sender which have not
+ * been received.
+ *
+ * Connectors deliver an event with an instance of this class to
+ * their loss handlers before the event of the notification which
+ * revealed the loss. The scope of the event is the scope of that
+ * notification.
+ *
+ * @author jmoringe
+ */
+struct RSBSPREAD_EXPORT LossReport {
+    /**
+     * The id of the participant which sent the missing
+     * notifications.
+     */
+    rsc::misc::UUID senderId;
+
+    /**
+     * The sequence number of the first missing notification.
+     */
+    boost::uint32_t firstMissing;
+
+    /**
+     * The number of consecutive missing notifications.
+     */
+    boost::uint32_t numMissing;
+};
+
+typedef boost::shared_ptr<LossReport> LossReportPtr;
+
+}
+}
+}
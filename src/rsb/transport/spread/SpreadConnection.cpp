@@ -41,6 +41,7 @@
 #include <rsb/CommException.h>
 
 #include "ErrorMessages.h"
+#include "Tracepoints.h"
 
 using namespace rsc::logging;
 
@@ -89,6 +90,10 @@ const std::string SpreadConnection::getTransportURL() const {
                       % this->host % this->port);
 }
 
+const std::string& SpreadConnection::getPrivateGroup() const {
+    return this->privateGroup;
+}
+
 bool SpreadConnection::isActive() const {
     return this->connected;
 }
@@ -196,13 +201,19 @@ void SpreadConnection::receive(SpreadMessage& message) {
 
     // handle normal messages
     if (Is_regular_mess(serviceType)) {
-        // cancel if requested
-        if (numGroups == 1 && std::string(groups[0]) == this->privateGroup) {
+        // cancel if requested. Other processes may send messages to
+        // the private group as well, so only messages sent by this
+        // connection itself interrupt.
+        if (numGroups == 1 && std::string(groups[0]) == this->privateGroup
+            && std::string(sender) == this->privateGroup) {
             throw boost::thread_interrupted();
         }
+        RSBSPREAD_TRACE3(receive, sender, ret, serviceType & REGULAR_MESS);
 
         message.setType(SpreadMessage::REGULAR);
+        message.setQOS(SpreadMessage::QOS(serviceType & REGULAR_MESS));
         message.setData(std::string(buf, ret));
+        message.setSender(sender);
         if (numGroups < 0) {
             // TODO check whether we shall implement a best effort strategy here
             RSCWARN(this->logger,
@@ -253,6 +264,9 @@ void SpreadConnection::send(const SpreadMessage& message) {
     boost::mutex::scoped_lock lock(this->mutex);
 #endif
 
+    RSBSPREAD_TRACE4(send_start, groups.begin()->c_str(), groups.size(),
+                     data.size(), message.getQOS());
+
     int ret;
     if (groups.size() == 1) { // only one group => use SP_multicast
         const std::string& group = *groups.begin();
@@ -274,12 +288,22 @@ void SpreadConnection::send(const SpreadMessage& message) {
              groups.size(), (const char(*)[MAX_GROUP_NAME]) groupNames, 0,
              data.size(), data.c_str());
     }
+    RSBSPREAD_TRACE3(send_done, groups.begin()->c_str(), data.size(), ret);
     if (ret < 0) {
         throw CommException(boost::str(boost::format("Spread send error: %1%")
                                        % spreadErrorString(ret)));
     }
 }
 
+int SpreadConnection::getPendingBytes() const {
+    if (!this->connected) {
+        throw rsc::misc::IllegalStateException("Connection is not active.");
+    }
+
+    int ret = SP_poll(this->mailbox);
+    return (ret < 0) ? 0 : ret;
+}
+
 void SpreadConnection::interruptReceive() {
     if (!this->connected) {
         throw rsc::misc::IllegalStateException("Connection is not active.");
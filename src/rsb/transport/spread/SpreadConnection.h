@@ -36,10 +36,9 @@
 #include <boost/thread/mutex.hpp>
 #endif
 
-#include <rsc/runtime/Printable.h>
-
 #include <rsc/logging/Logger.h>
 
+#include "Connection.h"
 #include "SpreadMessage.h"
 
 #include "rsb/transport/spread/rsbspreadexports.h"
@@ -63,7 +62,7 @@ RSBSPREAD_EXPORT unsigned int defaultPort();
  * @author jwienke
  * @author jmoringe
  */
-class RSBSPREAD_EXPORT SpreadConnection : public rsc::runtime::Printable {
+class RSBSPREAD_EXPORT SpreadConnection : public Connection {
 public:
     SpreadConnection(const std::string& host = defaultHost(),
                      unsigned int port       = defaultPort());
@@ -73,17 +72,8 @@ public:
 
     const std::string getTransportURL() const;
 
-    /**
-     * @name connection state management
-     * @todo is this really necessary?
-     */
-    //@{
+    const std::string& getPrivateGroup() const;
 
-    /**
-     * Tells if this instance is connected to spread daemon.
-     *
-     * @return @c true if connected
-     */
     bool isActive() const;
 
     /**
@@ -103,38 +93,10 @@ public:
      */
     virtual void deactivate();
 
-    //@}
-
-    /**
-     * @name group management
-     */
-    //@{
-
-    /**
-     * Joins the Spread group @a group.
-     *
-     * @param group Name of the group
-     * @throw rsc::misc::IllegalStateException connection was not active
-     * @throw CommException Spread error joining
-     */
     void join(const std::string& group);
 
-    /**
-     * Leaves the Spread group @a group.
-     *
-     * @param group Name of the Spread group.
-     * @throw rsc::misc::IllegalStateException connection was not active
-     * @throw CommException Spread error leaving
-     */
     void leave(const std::string& group);
 
-    //@}
-
-    /**
-     * @name fundamental message exchange
-     */
-    //@{
-
     /**
      * Receives the next message from this connection into @a message.
      *
@@ -151,27 +113,10 @@ public:
      */
     void receive(SpreadMessage& message);
 
-    /**
-     * Sends @a message over the Spread ring.
-     *
-     * @param message message to send
-     * @throw rsc::misc::IllegalStateException connection was not active
-     * @throw CommException communication error sending the message
-     */
     void send(const SpreadMessage& message);
 
-    //@}
+    int getPendingBytes() const;
 
-    /**
-     * Interrupts a potential receiver blocking in the read call some time after
-     * this call. The receiver may receive all queued messages before being
-     * interrupted.
-     *
-     * @note this method may explicitly be called from a different thread than
-     *       the one blocking in #receive. Nevertheless only one other thread at
-     *       a time is allowed call this method.
-     * @throw rsc::misc::IllegalStateException connection was not active
-     */
     void interruptReceive();
 
 private:
@@ -111,6 +111,50 @@ void SpreadMessage::addGroup(const std::string& name) {
     this->groups.insert(name);
 }
 
+const std::string& SpreadMessage::getSender() const {
+    return this->sender;
+}
+
+void SpreadMessage::setSender(const std::string& sender) {
+    this->sender = sender;
+}
+
+std::string qosName(SpreadMessage::QOS qos) {
+    switch (qos) {
+    case SpreadMessage::UNRELIABLE:
+        return "unreliable";
+    case SpreadMessage::RELIABLE:
+        return "reliable";
+    case SpreadMessage::FIFO:
+        return "fifo";
+    case SpreadMessage::CAUSAL:
+        return "causal";
+    case SpreadMessage::AGREED:
+        return "agreed";
+    case SpreadMessage::SAFE:
+        return "safe";
+    default:
+        return "unknown";
+    }
+}
+
+unsigned int qosIndex(SpreadMessage::QOS qos) {
+    switch (qos) {
+    case SpreadMessage::RELIABLE:
+        return 1;
+    case SpreadMessage::FIFO:
+        return 2;
+    case SpreadMessage::CAUSAL:
+        return 3;
+    case SpreadMessage::AGREED:
+        return 4;
+    case SpreadMessage::SAFE:
+        return 5;
+    default:
+        return 0;
+    }
+}
+
 }
 }
 }
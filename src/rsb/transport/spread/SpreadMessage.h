@@ -114,13 +114,40 @@ public:
 
     const std::set<std::string>& getGroups() const;
     void addGroup(const std::string& name);
+
+    /**
+     * Returns the private group of the connection which sent this
+     * message.
+     *
+     * @return The name of the private group or the empty string if
+     *         the sender is not known.
+     */
+    const std::string& getSender() const;
+    void setSender(const std::string& sender);
 private:
     Type                  type;
     QOS                   qos;
     std::string           data;
     std::set<std::string> groups;
+    std::string           sender;
 };
 
+/**
+ * Returns a human-readable name for @a qos.
+ */
+RSBSPREAD_EXPORT std::string qosName(SpreadMessage::QOS qos);
+
+/**
+ * The number of distinct values of @ref SpreadMessage::QOS.
+ */
+const unsigned int NUM_QOS_LEVELS = 6;
+
+/**
+ * Returns a number in [0, @ref NUM_QOS_LEVELS) for @a qos, for
+ * example to index arrays of per-QoS metrics.
+ */
+RSBSPREAD_EXPORT unsigned int qosIndex(SpreadMessage::QOS qos);
+
 typedef boost::shared_ptr<SpreadMessage> SpreadMessagePtr;
 
 }
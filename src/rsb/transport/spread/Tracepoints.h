@@ -0,0 +1,90 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#pragma once
+
+/**
+ * @file
+ *
+ * Static tracepoints in the style of USDT/SystemTap SDT probes.
+ *
+ * If the library is built with RSBSPREAD_HAVE_SDT, each tracepoint
+ * is a no-op instruction in the instruction stream, plus a note
+ * section entry describing the locations of its arguments. Tools
+ * such as bpftrace or perf can attach to a tracepoint at runtime. If
+ * the library is built without RSBSPREAD_HAVE_SDT, tracepoints
+ * expand to nothing and their arguments are not evaluated.
+ *
+ * Since arguments are evaluated even when no tool is attached, they
+ * must be cheap to compute: integers and pointers to existing
+ * strings, never temporaries.
+ *
+ * All tracepoints use the provider "rsbspread":
+ *
+ * | Tracepoint         | Arguments                                           |
+ * |--------------------|-----------------------------------------------------|
+ * | send_start         | first group, number of groups, size, QoS            |
+ * | send_done          | first group, size, result                           |
+ * | receive            | sender, size, QoS                                   |
+ * | fragment           | sender id, sequence number, part index, size        |
+ * | assembly_new       | sender id, sequence number, part index, part count  |
+ * | assembly_complete  | sender id, sequence number, part count, size        |
+ * | assembly_duplicate | sender id, sequence number, part index, part count  |
+ * | assembly_recovered | sender id, sequence number, part index, part count  |
+ * | assembly_expired   | sender id, age in seconds, buffered size            |
+ * | prune_done         | number of expired assemblies, remaining assemblies  |
+ * | dispatch_start     | scope, sender id, sequence number, outgoing flag    |
+ * | dispatch_done      | scope, sender id, sequence number, outgoing flag    |
+ *
+ * Groups, senders and scopes are NUL-terminated strings. Sender ids
+ * are pointers to the 16 bytes of the participant UUID.
+ */
+
+#ifdef RSBSPREAD_HAVE_SDT
+
+#include <sys/sdt.h>
+
+#define RSBSPREAD_TRACE2(name, a1, a2)                 \
+    DTRACE_PROBE2(rsbspread, name, a1, a2)
+#define RSBSPREAD_TRACE3(name, a1, a2, a3)             \
+    DTRACE_PROBE3(rsbspread, name, a1, a2, a3)
+#define RSBSPREAD_TRACE4(name, a1, a2, a3, a4)         \
+    DTRACE_PROBE4(rsbspread, name, a1, a2, a3, a4)
+
+#else
+
+// sizeof marks variables which are only used in tracepoints as used
+// without evaluating anything.
+#define RSBSPREAD_TRACE2(name, a1, a2)                          \
+    do { (void) sizeof(a1); (void) sizeof(a2); } while (false)
+#define RSBSPREAD_TRACE3(name, a1, a2, a3)                      \
+    do { (void) sizeof(a1); (void) sizeof(a2);                  \
+         (void) sizeof(a3); } while (false)
+#define RSBSPREAD_TRACE4(name, a1, a2, a3, a4)                  \
+    do { (void) sizeof(a1); (void) sizeof(a2);                  \
+         (void) sizeof(a3); (void) sizeof(a4); } while (false)
+
+#endif
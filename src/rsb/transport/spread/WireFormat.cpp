@@ -0,0 +1,351 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#include "WireFormat.h"
+
+#include <cassert>
+
+namespace rsb {
+namespace transport {
+namespace spread {
+
+namespace {
+
+const std::size_t PREAMBLE_SIZE = 3;
+
+void appendPreamble(CompactMessageKind kind, std::string& output) {
+    output.push_back(0);
+    output.push_back(static_cast<char>(kind));
+    output.push_back(static_cast<char>(COMPACT_FORMAT_VERSION));
+}
+
+void appendUInt32(boost::uint32_t value, std::string& output) {
+    output.push_back(static_cast<char>(value & 0xff));
+    output.push_back(static_cast<char>((value >> 8) & 0xff));
+    output.push_back(static_cast<char>((value >> 16) & 0xff));
+    output.push_back(static_cast<char>((value >> 24) & 0xff));
+}
+
+void appendUInt64(boost::uint64_t value, std::string& output) {
+    appendUInt32(static_cast<boost::uint32_t>(value & 0xffffffff), output);
+    appendUInt32(static_cast<boost::uint32_t>(value >> 32), output);
+}
+
+/**
+ * Reads from a compact message while checking bounds.
+ */
+class Reader {
+public:
+    Reader(const std::string& input) :
+        input(input), offset(0) {
+    }
+
+    bool readByte(boost::uint8_t& value) {
+        if (remaining() < 1) {
+            return false;
+        }
+        value = static_cast<boost::uint8_t>(this->input[this->offset++]);
+        return true;
+    }
+
+    bool readUInt32(boost::uint32_t& value) {
+        if (remaining() < 4) {
+            return false;
+        }
+        value = 0;
+        for (unsigned int i = 0; i < 4; ++i) {
+            value |= (static_cast<boost::uint32_t>
+                      (static_cast<boost::uint8_t>(this->input[this->offset + i]))
+                      << (8 * i));
+        }
+        this->offset += 4;
+        return true;
+    }
+
+    bool readUInt64(boost::uint64_t& value) {
+        boost::uint32_t low;
+        boost::uint32_t high;
+        if (!(readUInt32(low) && readUInt32(high))) {
+            return false;
+        }
+        value = (static_cast<boost::uint64_t>(high) << 32) | low;
+        return true;
+    }
+
+    bool readBytes(std::size_t size, std::string& value) {
+        if (remaining() < size) {
+            return false;
+        }
+        value.assign(this->input, this->offset, size);
+        this->offset += size;
+        return true;
+    }
+
+    /**
+     * Skips the preamble and checks kind and version.
+     */
+    bool readPreamble(CompactMessageKind kind) {
+        boost::uint8_t marker;
+        boost::uint8_t actualKind;
+        boost::uint8_t version;
+        return readByte(marker) && (marker == 0)
+            && readByte(actualKind) && (actualKind == kind)
+            && readByte(version) && (version == COMPACT_FORMAT_VERSION);
+    }
+
+    std::size_t remaining() const {
+        return this->input.size() - this->offset;
+    }
+private:
+    const std::string& input;
+    std::size_t        offset;
+};
+
+}
+
+bool isCompactMessage(const std::string& data) {
+    return !data.empty() && (data[0] == 0);
+}
+
+boost::uint8_t compactMessageKind(const std::string& data) {
+    if (data.size() < PREAMBLE_SIZE) {
+        return 0;
+    }
+    return static_cast<boost::uint8_t>(data[1]);
+}
+
+bool isControlMessage(const std::string& data) {
+    if (!isCompactMessage(data)) {
+        return false;
+    }
+    boost::uint8_t kind = compactMessageKind(data);
+    return (kind != COMPACT_CONTINUATION_FRAGMENT)
+        && (kind != COMPACT_PARITY_FRAGMENT);
+}
+
+std::size_t
+continuationFragmentHeaderSize(const rsb::protocol::EventId& eventId) {
+    return PREAMBLE_SIZE + 1 + eventId.sender_id().size() + 4 * 4;
+}
+
+void encodeContinuationFragment(const rsb::protocol::EventId& eventId,
+                                boost::uint32_t               part,
+                                boost::uint32_t               numParts,
+                                const std::string&            data,
+                                std::string&                  output) {
+    const std::string& senderId = eventId.sender_id();
+    assert(senderId.size() <= 0xff);
+
+    output.clear();
+    output.reserve(continuationFragmentHeaderSize(eventId) + data.size());
+    appendPreamble(COMPACT_CONTINUATION_FRAGMENT, output);
+    output.push_back(static_cast<char>(senderId.size()));
+    output.append(senderId);
+    appendUInt32(eventId.sequence_number(), output);
+    appendUInt32(part, output);
+    appendUInt32(numParts, output);
+    appendUInt32(data.size(), output);
+    output.append(data);
+}
+
+bool decodeContinuationFragment(const std::string&                     input,
+                                rsb::protocol::FragmentedNotification& fragment) {
+    Reader reader(input);
+    if (!reader.readPreamble(COMPACT_CONTINUATION_FRAGMENT)) {
+        return false;
+    }
+
+    fragment.Clear();
+    rsb::protocol::Notification* notification
+        = fragment.mutable_notification();
+    rsb::protocol::EventId* eventId = notification->mutable_event_id();
+
+    boost::uint8_t  senderIdLength;
+    boost::uint32_t sequenceNumber;
+    boost::uint32_t part;
+    boost::uint32_t numParts;
+    boost::uint32_t dataLength;
+    if (!(reader.readByte(senderIdLength)
+          && reader.readBytes(senderIdLength, *eventId->mutable_sender_id())
+          && reader.readUInt32(sequenceNumber)
+          && reader.readUInt32(part)
+          && reader.readUInt32(numParts)
+          && reader.readUInt32(dataLength)
+          && (reader.remaining() == dataLength)
+          && (part < numParts)
+          && reader.readBytes(dataLength, *notification->mutable_data()))) {
+        return false;
+    }
+    eventId->set_sequence_number(sequenceNumber);
+    fragment.set_data_part(part);
+    fragment.set_num_data_parts(numParts);
+    return true;
+}
+
+void encodeParityFragment(const ParityFragment& fragment,
+                          std::string&          output) {
+    const std::string& senderId = fragment.eventId.sender_id();
+    assert(senderId.size() <= 0xff);
+
+    output.clear();
+    output.reserve(PREAMBLE_SIZE + 1 + senderId.size() + 7 * 4
+                   + fragment.header.size() + fragment.data.size());
+    appendPreamble(COMPACT_PARITY_FRAGMENT, output);
+    output.push_back(static_cast<char>(senderId.size()));
+    output.append(senderId);
+    appendUInt32(fragment.eventId.sequence_number(), output);
+    appendUInt32(fragment.numDataParts, output);
+    appendUInt32(fragment.numParityParts, output);
+    appendUInt32(fragment.parityIndex, output);
+    appendUInt32(fragment.lengthParity, output);
+    appendUInt32(fragment.header.size(), output);
+    output.append(fragment.header);
+    appendUInt32(fragment.data.size(), output);
+    output.append(fragment.data);
+}
+
+bool decodeParityFragment(const std::string& input,
+                          ParityFragment&    fragment) {
+    Reader reader(input);
+    if (!reader.readPreamble(COMPACT_PARITY_FRAGMENT)) {
+        return false;
+    }
+
+    fragment.eventId.Clear();
+
+    boost::uint8_t  senderIdLength;
+    boost::uint32_t sequenceNumber;
+    boost::uint32_t headerLength;
+    boost::uint32_t dataLength;
+    if (!(reader.readByte(senderIdLength)
+          && reader.readBytes(senderIdLength,
+                              *fragment.eventId.mutable_sender_id())
+          && reader.readUInt32(sequenceNumber)
+          && reader.readUInt32(fragment.numDataParts)
+          && reader.readUInt32(fragment.numParityParts)
+          && reader.readUInt32(fragment.parityIndex)
+          && reader.readUInt32(fragment.lengthParity)
+          && reader.readUInt32(headerLength)
+          && reader.readBytes(headerLength, fragment.header)
+          && reader.readUInt32(dataLength)
+          && (reader.remaining() == dataLength)
+          && reader.readBytes(dataLength, fragment.data))) {
+        return false;
+    }
+    fragment.eventId.set_sequence_number(sequenceNumber);
+    return (fragment.numDataParts > 1)
+        && (fragment.numParityParts > 0)
+        && (fragment.numParityParts <= fragment.numDataParts)
+        && (fragment.parityIndex < fragment.numParityParts);
+}
+
+void encodeNack(const rsb::protocol::EventId&       eventId,
+                const std::vector<boost::uint32_t>& parts,
+                std::string&                        output) {
+    const std::string& senderId = eventId.sender_id();
+    assert(senderId.size() <= 0xff);
+
+    output.clear();
+    output.reserve(PREAMBLE_SIZE + 1 + senderId.size() + 4 * (2 + parts.size()));
+    appendPreamble(COMPACT_NACK, output);
+    output.push_back(static_cast<char>(senderId.size()));
+    output.append(senderId);
+    appendUInt32(eventId.sequence_number(), output);
+    appendUInt32(parts.size(), output);
+    for (std::vector<boost::uint32_t>::const_iterator it = parts.begin();
+         it != parts.end(); ++it) {
+        appendUInt32(*it, output);
+    }
+}
+
+bool decodeNack(const std::string&            input,
+                rsb::protocol::EventId&       eventId,
+                std::vector<boost::uint32_t>& parts) {
+    Reader reader(input);
+    if (!reader.readPreamble(COMPACT_NACK)) {
+        return false;
+    }
+
+    eventId.Clear();
+    parts.clear();
+
+    boost::uint8_t  senderIdLength;
+    boost::uint32_t sequenceNumber;
+    boost::uint32_t numParts;
+    if (!(reader.readByte(senderIdLength)
+          && reader.readBytes(senderIdLength, *eventId.mutable_sender_id())
+          && reader.readUInt32(sequenceNumber)
+          && reader.readUInt32(numParts)
+          && (reader.remaining() == 4 * std::size_t(numParts)))) {
+        return false;
+    }
+    eventId.set_sequence_number(sequenceNumber);
+    parts.resize(numParts);
+    for (boost::uint32_t i = 0; i < numParts; ++i) {
+        reader.readUInt32(parts[i]);
+    }
+    return true;
+}
+
+void encodeClockPing(boost::uint64_t sendTime, std::string& output) {
+    output.clear();
+    appendPreamble(COMPACT_CLOCK_PING, output);
+    appendUInt64(sendTime, output);
+}
+
+bool decodeClockPing(const std::string& input, boost::uint64_t& sendTime) {
+    Reader reader(input);
+    return reader.readPreamble(COMPACT_CLOCK_PING)
+        && reader.readUInt64(sendTime)
+        && (reader.remaining() == 0);
+}
+
+void encodeClockPong(boost::uint64_t requestSendTime,
+                     boost::uint64_t requestReceiveTime,
+                     boost::uint64_t replySendTime,
+                     std::string&    output) {
+    output.clear();
+    appendPreamble(COMPACT_CLOCK_PONG, output);
+    appendUInt64(requestSendTime, output);
+    appendUInt64(requestReceiveTime, output);
+    appendUInt64(replySendTime, output);
+}
+
+bool decodeClockPong(const std::string& input,
+                     boost::uint64_t&   requestSendTime,
+                     boost::uint64_t&   requestReceiveTime,
+                     boost::uint64_t&   replySendTime) {
+    Reader reader(input);
+    return reader.readPreamble(COMPACT_CLOCK_PONG)
+        && reader.readUInt64(requestSendTime)
+        && reader.readUInt64(requestReceiveTime)
+        && reader.readUInt64(replySendTime)
+        && (reader.remaining() == 0);
+}
+
+}
+}
+}
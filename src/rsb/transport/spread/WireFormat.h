@@ -0,0 +1,266 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <rsb/protocol/FragmentedNotification.h>
+
+#include "rsb/transport/spread/rsbspreadexports.h"
+
+namespace rsb {
+namespace transport {
+namespace spread {
+
+/**
+ * @name Compact binary messages
+ *
+ * Besides serialized @ref rsb::protocol::FragmentedNotification
+ * messages, Spread messages can contain compact binary messages
+ * which are cheaper to produce and parse. Such messages start with
+ * a zero byte, which cannot start a valid protobuf message, followed
+ * by a byte indicating the kind of message and a format version
+ * byte. The remainder depends on the kind.
+ *
+ * Integers are encoded in little-endian byte order.
+ */
+//@{
+
+/**
+ * Kinds of compact messages.
+ */
+enum CompactMessageKind {
+    /**
+     * A fragment other than the first of a fragmented notification:
+     * sender id length (one byte), sender id, sequence number, part
+     * index, part count, data length, data.
+     */
+    COMPACT_CONTINUATION_FRAGMENT = 0x01,
+
+    /**
+     * A clock synchronization request sent to the private group of
+     * a peer: send time of the request (eight bytes).
+     */
+    COMPACT_CLOCK_PING            = 0x02,
+
+    /**
+     * The answer to a @ref COMPACT_CLOCK_PING: send time of the
+     * request, receive time of the request and send time of the
+     * answer (eight bytes each).
+     */
+    COMPACT_CLOCK_PONG            = 0x03,
+
+    /**
+     * A parity fragment of a fragmented notification: sender id
+     * length (one byte), sender id, sequence number, data part
+     * count, parity part count, parity part index, length parity,
+     * header length, header, data length, data. See @ref
+     * ParityFragment.
+     */
+    COMPACT_PARITY_FRAGMENT       = 0x04,
+
+    /**
+     * A request for retransmitting fragments of a notification sent
+     * to the private group of its sender: sender id length (one
+     * byte), sender id, sequence number, number of requested parts,
+     * indices of the requested parts.
+     */
+    COMPACT_NACK                  = 0x05
+};
+
+/**
+ * The version of the compact message format produced by this
+ * implementation.
+ */
+const boost::uint8_t COMPACT_FORMAT_VERSION = 1;
+
+/**
+ * Tells whether @a data is a compact message rather than a
+ * serialized protobuf message.
+ */
+RSBSPREAD_EXPORT bool isCompactMessage(const std::string& data);
+
+/**
+ * Returns the kind of the compact message @a data. @a data must
+ * satisfy @ref isCompactMessage.
+ *
+ * @return The kind byte of the message or 0 if the message is too
+ *         short.
+ */
+RSBSPREAD_EXPORT boost::uint8_t compactMessageKind(const std::string& data);
+
+/**
+ * Tells whether @a data is a compact control message, that is a
+ * compact message which is not part of a notification.
+ */
+RSBSPREAD_EXPORT bool isControlMessage(const std::string& data);
+
+/**
+ * Returns the number of bytes a continuation fragment for an event
+ * with id @a eventId requires in addition to its data.
+ */
+RSBSPREAD_EXPORT std::size_t
+continuationFragmentHeaderSize(const rsb::protocol::EventId& eventId);
+
+/**
+ * Encodes fragment @a part of @a numParts, carrying @a data, of the
+ * notification for the event with id @a eventId into @a output.
+ *
+ * @param output Replaced by the encoded message.
+ */
+RSBSPREAD_EXPORT void
+encodeContinuationFragment(const rsb::protocol::EventId& eventId,
+                           boost::uint32_t               part,
+                           boost::uint32_t               numParts,
+                           const std::string&            data,
+                           std::string&                  output);
+
+/**
+ * Decodes a continuation fragment produced by @ref
+ * encodeContinuationFragment into @a fragment which is cleared
+ * first. Only the event id, data, part index and part count are
+ * set.
+ *
+ * @return @c true if @a input is a well-formed continuation fragment
+ *         of a supported version, @c false otherwise.
+ */
+RSBSPREAD_EXPORT bool
+decodeContinuationFragment(const std::string&                     input,
+                           rsb::protocol::FragmentedNotification& fragment);
+
+/**
+ * A parity fragment which allows rebuilding one lost data fragment
+ * of a fragmented notification.
+ *
+ * Data fragment i belongs to the parity group i modulo @ref
+ * numParityParts. The data of the parity fragment of a group is the
+ * bytewise XOR of the data of all fragments of the group, each
+ * padded with zeros to the longest one. Similarly, @ref
+ * lengthParity is the XOR of their data lengths.
+ */
+struct RSBSPREAD_EXPORT ParityFragment {
+    rsb::protocol::EventId eventId;
+    boost::uint32_t        numDataParts;
+    boost::uint32_t        numParityParts;
+    boost::uint32_t        parityIndex;
+    boost::uint32_t        lengthParity;
+
+    /**
+     * The serialized @ref rsb::protocol::Notification of the first
+     * data fragment without its data. Required for rebuilding the
+     * first data fragment.
+     */
+    std::string            header;
+
+    std::string            data;
+};
+
+typedef boost::shared_ptr<ParityFragment> ParityFragmentPtr;
+
+/**
+ * Encodes @a fragment into @a output.
+ *
+ * @param output Replaced by the encoded message.
+ */
+RSBSPREAD_EXPORT void encodeParityFragment(const ParityFragment& fragment,
+                                           std::string&          output);
+
+/**
+ * Decodes a parity fragment produced by @ref encodeParityFragment
+ * into @a fragment.
+ *
+ * @return @c true if @a input is a well-formed parity fragment of a
+ *         supported version, @c false otherwise.
+ */
+RSBSPREAD_EXPORT bool decodeParityFragment(const std::string& input,
+                                           ParityFragment&    fragment);
+
+/**
+ * Encodes a request for retransmitting the fragments @a parts of the
+ * notification for the event with id @a eventId into @a output.
+ */
+RSBSPREAD_EXPORT void encodeNack(const rsb::protocol::EventId&       eventId,
+                                 const std::vector<boost::uint32_t>& parts,
+                                 std::string&                        output);
+
+/**
+ * Decodes a request produced by @ref encodeNack.
+ *
+ * @return @c true if @a input is a well-formed request of a
+ *         supported version, @c false otherwise.
+ */
+RSBSPREAD_EXPORT bool decodeNack(const std::string&            input,
+                                 rsb::protocol::EventId&       eventId,
+                                 std::vector<boost::uint32_t>& parts);
+
+/**
+ * Encodes a clock synchronization request sent at @a sendTime into
+ * @a output.
+ */
+RSBSPREAD_EXPORT void encodeClockPing(boost::uint64_t sendTime,
+                                      std::string&    output);
+
+/**
+ * Decodes a clock synchronization request produced by @ref
+ * encodeClockPing.
+ *
+ * @return @c true if @a input is a well-formed request of a
+ *         supported version, @c false otherwise.
+ */
+RSBSPREAD_EXPORT bool decodeClockPing(const std::string& input,
+                                      boost::uint64_t&   sendTime);
+
+/**
+ * Encodes the answer to a clock synchronization request sent at
+ * @a requestSendTime, received at @a requestReceiveTime and answered
+ * at @a replySendTime into @a output.
+ */
+RSBSPREAD_EXPORT void encodeClockPong(boost::uint64_t requestSendTime,
+                                      boost::uint64_t requestReceiveTime,
+                                      boost::uint64_t replySendTime,
+                                      std::string&    output);
+
+/**
+ * Decodes an answer produced by @ref encodeClockPong.
+ *
+ * @return @c true if @a input is a well-formed answer of a supported
+ *         version, @c false otherwise.
+ */
+RSBSPREAD_EXPORT bool decodeClockPong(const std::string& input,
+                                      boost::uint64_t&   requestSendTime,
+                                      boost::uint64_t&   requestReceiveTime,
+                                      boost::uint64_t&   replySendTime);
+
+//@}
+
+}
+}
+}
@@ -27,7 +27,15 @@
 #include "registration.h"
 
 #include <boost/bind.hpp>
+#include <boost/format.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <rsc/logging/Logger.h>
+
+#include <rsb/Factory.h>
+#include <rsb/ParticipantConfig.h>
 
 #include <rsb/transport/Factory.h>
 
@@ -39,6 +47,34 @@ namespace spread {
 
 static FactoryPtr factory;
 static boost::mutex registrationMutex;
+static boost::scoped_ptr<boost::thread> warmUpThread;
+
+/**
+ * Warms up the bus for the spread transport options of the default
+ * participant configuration if the "warmup" option is set.
+ *
+ * Runs in a separate thread since plugins are initialized while the
+ * RSB factory, which provides the configuration, is being created.
+ */
+static void warmUp(FactoryPtr factory) {
+    rsc::logging::LoggerPtr logger
+        = rsc::logging::Logger::getLogger("rsb.transport.spread.registration");
+
+    try {
+        ParticipantConfig::Transport transport
+            = rsb::getFactory().getDefaultParticipantConfig()
+            .getTransport("spread");
+        rsc::runtime::Properties options = transport.getOptions();
+        if (!transport.isEnabled() || !options.getAs<bool>("warmup", false)) {
+            return;
+        }
+
+        factory->warmUp(options);
+    } catch (const std::exception& e) {
+        RSCWARN(logger, (boost::format("Could not warm up Spread bus: %1%")
+                         % e.what()));
+    }
+}
 
 void registerTransport() {
     boost::mutex::scoped_lock lock(registrationMutex);
@@ -49,6 +85,28 @@ void registerTransport() {
         std::set<std::string> options;
         options.insert("host");
         options.insert("port");
+        options.insert("connections");
+        options.insert("compression");
+        options.insert("compressionthreshold");
+        options.insert("sharelocaldata");
+        options.insert("lazydeserialization");
+        options.insert("compactfragments");
+        options.insert("fecparity");
+        options.insert("metricsfile");
+        options.insert("metricsinterval");
+        options.insert("scopemetrics");
+        options.insert("clocksync");
+        options.insert("filtermethod");
+        options.insert("filterorigin");
+        options.insert("filteruserinfo");
+        options.insert("nackdelay");
+        options.insert("capturefile");
+        options.insert("reconnect");
+        options.insert("reconnectbuffer");
+        options.insert("daemons");
+        options.insert("daemonmode");
+        options.insert("warmup");
+        options.insert("warmupscopes");
 
         {
             InFactory& connectorFactory = getInFactory();
@@ -67,6 +125,11 @@ void registerTransport() {
                  boost::bind(&Factory::createOutConnector, factory, _1),
                  "spread", true, options);
         }
+
+        // Warming up may block on connecting to a slow or
+        // unreachable daemon. unregisterTransport waits for the
+        // thread since it executes code of the plugin.
+        warmUpThread.reset(new boost::thread(boost::bind(&warmUp, factory)));
     }
 
 }
@@ -87,6 +150,15 @@ void unregisterTransport() {
         connectorFactory.unregisterConnector("spread");
     }*/
 
+    if (warmUpThread) {
+        warmUpThread->interrupt();
+        warmUpThread->join();
+        warmUpThread.reset();
+    }
+
+    if (factory) {
+        factory->releaseWarmBuses();
+    }
     factory.reset();
 }
 
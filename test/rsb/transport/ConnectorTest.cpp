@@ -88,7 +88,13 @@ public:
     MOCK_METHOD1(handleOutgoingNotification,
                  void(rsb::transport::spread::OutgoingNotificationPtr
                       notification));
+    MOCK_METHOD1(handleControlMessage,
+                 void(const rsb::transport::spread::SpreadMessage& message));
     MOCK_METHOD1(handleError, void(const std::exception& error));
+
+    MOCK_CONST_METHOD0(getMetrics,
+                       rsb::transport::spread::MetricsRegistryPtr());
+    MOCK_CONST_METHOD0(getScopeMetrics, bool());
 };
 
 TEST_P(ConnectorTest, testIsolatedConstruction) {
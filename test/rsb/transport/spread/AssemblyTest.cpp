@@ -24,6 +24,9 @@
  *
  * ============================================================ */
 
+#include <set>
+#include <vector>
+
 #include <boost/bind.hpp>
 #include <boost/shared_ptr.hpp>
 
@@ -36,6 +39,7 @@
 #include <rsb/protocol/Notification.pb.h>
 
 #include <rsb/transport/spread/Assembly.h>
+#include <rsb/transport/spread/Parity.h>
 
 #include "../../InformerTask.h"
 
@@ -346,3 +350,178 @@ TEST(AssemblyPoolTest, testPruning) {
     }
 
 }
+
+namespace {
+
+vector<protocol::FragmentedNotification> makeFragments(boost::uint32_t seqnum,
+                                                       unsigned int    dataParts,
+                                                       string&         data) {
+    vector<protocol::FragmentedNotification> fragments(dataParts);
+    data.clear();
+    for (unsigned int i = 0; i < dataParts; ++i) {
+        protocol::Notification* notification
+            = fragments[i].mutable_notification();
+        notification->mutable_event_id()->set_sender_id("0123456789abcdef");
+        notification->mutable_event_id()->set_sequence_number(seqnum);
+        if (i == 0) {
+            notification->set_scope("/parity/test");
+        }
+        // The first and the last fragment are shorter.
+        const string part = rsc::misc::randAlnumStr
+            (((i == 0) || (i == dataParts - 1)) ? 7 + i : 30);
+        notification->set_data(part);
+        data += part;
+        fragments[i].set_data_part(i);
+        fragments[i].set_num_data_parts(dataParts);
+    }
+    return fragments;
+}
+
+}
+
+TEST(AssemblyPoolTest, testParityRecovery) {
+
+    AssemblyPool pool;
+
+    const unsigned int dataParts = 7;
+    const unsigned int numParity = 3;
+
+    // Lose bursts of consecutive data fragments, one per parity
+    // group, including the first and the last fragment.
+    for (unsigned int seqnum = 0; seqnum + numParity <= dataParts; ++seqnum) {
+        string data;
+        vector<protocol::FragmentedNotification> fragments
+            = makeFragments(seqnum, dataParts, data);
+        vector<ParityFragment> parity;
+        makeParityFragments(fragments, numParity, parity);
+        ASSERT_EQ(numParity, parity.size());
+
+        set<unsigned int> lost;
+        for (unsigned int i = 0; i < numParity; ++i) {
+            lost.insert(seqnum + i);
+        }
+
+        protocol::NotificationPtr result;
+        for (unsigned int i = 0; i < dataParts; ++i) {
+            if (!lost.count(i)) {
+                EXPECT_FALSE(pool.add(protocol::FragmentedNotificationPtr
+                                      (new protocol::FragmentedNotification
+                                       (fragments[i]))));
+            }
+        }
+        for (unsigned int i = 0; i < numParity; ++i) {
+            result = pool.addParity(ParityFragmentPtr
+                                    (new ParityFragment(parity[i])));
+            EXPECT_EQ(i == numParity - 1, bool(result));
+        }
+        ASSERT_TRUE(result.get());
+        EXPECT_EQ(data, result->data());
+        EXPECT_EQ("/parity/test", result->scope());
+        EXPECT_EQ(seqnum, result->event_id().sequence_number());
+
+        // Late fragments of the completed notification are discarded.
+        EXPECT_FALSE(pool.add(protocol::FragmentedNotificationPtr
+                              (new protocol::FragmentedNotification
+                               (fragments[seqnum]))));
+    }
+
+}
+
+TEST(AssemblyPoolTest, testParityInsufficient) {
+
+    AssemblyPool pool;
+
+    string data;
+    vector<protocol::FragmentedNotification> fragments
+        = makeFragments(0, 4, data);
+    vector<ParityFragment> parity;
+    makeParityFragments(fragments, 2, parity);
+
+    // Fragments 0 and 2 are in the same group.
+    EXPECT_FALSE(pool.addParity(ParityFragmentPtr(new ParityFragment(parity[0]))));
+    EXPECT_FALSE(pool.add(protocol::FragmentedNotificationPtr
+                          (new protocol::FragmentedNotification(fragments[1]))));
+    EXPECT_FALSE(pool.add(protocol::FragmentedNotificationPtr
+                          (new protocol::FragmentedNotification(fragments[3]))));
+    EXPECT_FALSE(pool.addParity(ParityFragmentPtr(new ParityFragment(parity[1]))));
+
+    // Receiving one of them allows rebuilding the other.
+    protocol::NotificationPtr result
+        = pool.add(protocol::FragmentedNotificationPtr
+                   (new protocol::FragmentedNotification(fragments[2])));
+    ASSERT_TRUE(result.get());
+    EXPECT_EQ(data, result->data());
+
+}
+
+TEST(AssemblyPoolTest, testCollectNacks) {
+
+    AssemblyPool pool;
+
+    const unsigned int dataParts = 5;
+    string data;
+    vector<protocol::FragmentedNotification> fragments
+        = makeFragments(3, dataParts, data);
+
+    // Fragments 1 and 3 are missing.
+    EXPECT_FALSE(pool.add(protocol::FragmentedNotificationPtr
+                          (new protocol::FragmentedNotification(fragments[0])),
+                          "#sender#daemon"));
+    EXPECT_FALSE(pool.add(protocol::FragmentedNotificationPtr
+                          (new protocol::FragmentedNotification(fragments[2]))));
+    EXPECT_FALSE(pool.add(protocol::FragmentedNotificationPtr
+                          (new protocol::FragmentedNotification(fragments[4]))));
+
+    // Not due yet.
+    vector<AssemblyPool::NackRequest> requests;
+    pool.collectNacks(200, 2, requests);
+    EXPECT_TRUE(requests.empty());
+
+    boost::this_thread::sleep(boost::posix_time::milliseconds(250));
+    pool.collectNacks(200, 2, requests);
+    ASSERT_EQ(1u, requests.size());
+    EXPECT_EQ("#sender#daemon", requests[0].senderGroup);
+    EXPECT_EQ(3u, requests[0].eventId.sequence_number());
+    ASSERT_EQ(2u, requests[0].missingParts.size());
+    EXPECT_EQ(1u, requests[0].missingParts[0]);
+    EXPECT_EQ(3u, requests[0].missingParts[1]);
+
+    // The next request is due after the delay and the number of
+    // requests is limited.
+    requests.clear();
+    pool.collectNacks(200, 2, requests);
+    EXPECT_TRUE(requests.empty());
+    boost::this_thread::sleep(boost::posix_time::milliseconds(250));
+    pool.collectNacks(200, 2, requests);
+    EXPECT_EQ(1u, requests.size());
+    requests.clear();
+    boost::this_thread::sleep(boost::posix_time::milliseconds(250));
+    pool.collectNacks(200, 2, requests);
+    EXPECT_TRUE(requests.empty());
+
+    // Retransmitted fragments complete the notification.
+    EXPECT_FALSE(pool.add(protocol::FragmentedNotificationPtr
+                          (new protocol::FragmentedNotification(fragments[1]))));
+    protocol::NotificationPtr result
+        = pool.add(protocol::FragmentedNotificationPtr
+                   (new protocol::FragmentedNotification(fragments[3])));
+    ASSERT_TRUE(result.get());
+    EXPECT_EQ(data, result->data());
+
+}
+
+TEST(AssemblyPoolTest, testCollectNacksWithoutSender) {
+
+    AssemblyPool pool;
+
+    string data;
+    vector<protocol::FragmentedNotification> fragments
+        = makeFragments(0, 3, data);
+    EXPECT_FALSE(pool.add(protocol::FragmentedNotificationPtr
+                          (new protocol::FragmentedNotification(fragments[0]))));
+
+    vector<AssemblyPool::NackRequest> requests;
+    pool.collectNacks(0, 1, requests);
+    EXPECT_TRUE(requests.empty());
+
+}
@@ -0,0 +1,156 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
+#include "rsb/transport/spread/CaptureFile.h"
+#include "rsb/transport/spread/CapturingConnection.h"
+#include "rsb/transport/spread/LoopbackConnection.h"
+#include "rsb/transport/spread/ReplayConnection.h"
+
+using namespace std;
+using namespace rsb::transport::spread;
+using namespace testing;
+
+class CaptureFileTest : public ::testing::Test {
+protected:
+    CaptureFileTest() :
+        fileName("CaptureFileTest.capture") {
+    }
+
+    virtual void TearDown() {
+        std::remove(this->fileName.c_str());
+    }
+
+    string fileName;
+};
+
+TEST_F(CaptureFileTest, testRoundtrip) {
+    SpreadMessage first(SpreadMessage::REGULAR);
+    first.setQOS(SpreadMessage::UNRELIABLE);
+    first.addGroup("a");
+    first.addGroup("b");
+    first.setData(string("\0foo", 4));
+
+    SpreadMessage second(SpreadMessage::REGULAR);
+    second.setQOS(SpreadMessage::RELIABLE);
+    second.addGroup("c");
+    second.setData(string(1000, 'x'));
+
+    {
+        // A small chunk size forces growing the file for each
+        // record.
+        CaptureWriter writer(this->fileName, 64);
+        writer.append(CAPTURE_RECEIVED, "#sender#host", first);
+        writer.append(CAPTURE_SENT, "#self#host", second);
+    }
+
+    CaptureReader reader(this->fileName);
+    CaptureRecord record;
+    for (unsigned int pass = 0; pass < 2; ++pass) {
+        ASSERT_TRUE(reader.next(record));
+        EXPECT_EQ(CAPTURE_RECEIVED, record.direction);
+        EXPECT_LT(0u, record.timestamp);
+        EXPECT_EQ(SpreadMessage::REGULAR, record.message.getType());
+        EXPECT_EQ(SpreadMessage::UNRELIABLE, record.message.getQOS());
+        EXPECT_EQ("#sender#host", record.message.getSender());
+        EXPECT_EQ(first.getGroups(), record.message.getGroups());
+        EXPECT_EQ(first.getData(), record.message.getData());
+
+        ASSERT_TRUE(reader.next(record));
+        EXPECT_EQ(CAPTURE_SENT, record.direction);
+        EXPECT_EQ(SpreadMessage::RELIABLE, record.message.getQOS());
+        EXPECT_EQ("#self#host", record.message.getSender());
+        EXPECT_EQ(second.getGroups(), record.message.getGroups());
+        EXPECT_EQ(second.getData(), record.message.getData());
+
+        EXPECT_FALSE(reader.next(record));
+        reader.rewind();
+    }
+}
+
+TEST_F(CaptureFileTest, testInvalidFile) {
+    {
+        ofstream stream(this->fileName.c_str());
+        stream << "this is not a capture file";
+    }
+    EXPECT_THROW(CaptureReader reader(this->fileName), std::runtime_error);
+}
+
+TEST_F(CaptureFileTest, testCaptureAndReplay) {
+    LoopbackDaemonPtr daemon(new LoopbackDaemon());
+    ConnectionPtr sender(new LoopbackConnection(daemon));
+    sender->activate();
+    CaptureWriterPtr writer(new CaptureWriter(this->fileName));
+    ConnectionPtr receiver(new CapturingConnection
+                           (ConnectionPtr(new LoopbackConnection(daemon)),
+                            writer));
+    receiver->activate();
+    receiver->join("a");
+
+    SpreadMessage message("foo");
+    message.addGroup("a");
+    sender->send(message);
+    message.setData("bar");
+    sender->send(message);
+
+    SpreadMessage received;
+    receiver->receive(received);
+    receiver->receive(received);
+    receiver->send(message);
+    writer.reset();
+
+    ReplayConnectionPtr replay(new ReplayConnection
+                               (CaptureReaderPtr(new CaptureReader(this->fileName)),
+                                false));
+    replay->activate();
+    replay->start();
+
+    // The sent message is not replayed.
+    replay->receive(received);
+    EXPECT_EQ("foo", received.getData());
+    EXPECT_EQ(sender->getPrivateGroup(), received.getSender());
+    EXPECT_EQ(message.getGroups(), received.getGroups());
+    replay->receive(received);
+    EXPECT_EQ("bar", received.getData());
+    EXPECT_EQ(2u, replay->getNumReplayed());
+
+    boost::thread waiter(boost::bind(&ReplayConnection::waitFinished, replay));
+    replay->interruptReceive();
+    EXPECT_THROW(replay->receive(received), boost::thread_interrupted);
+    boost::thread finalReceiver(boost::bind(&ReplayConnection::receive, replay,
+                                        boost::ref(received)));
+    waiter.join();
+    replay->interruptReceive();
+    finalReceiver.join();
+}
@@ -0,0 +1,147 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#include <gtest/gtest.h>
+
+#include <rsb/transport/spread/ClockSync.h>
+
+using namespace std;
+
+using namespace rsb::transport::spread;
+
+TEST(ClockSyncTest, testUnknownPeer)
+{
+    ClockSync sync;
+    ClockSync::PeerClock clock;
+    EXPECT_FALSE(sync.addSample("#a#d1", 0, 10, 10, 20));
+    EXPECT_FALSE(sync.getPeerClock("#a#d1", clock));
+    EXPECT_TRUE(sync.getPingTargets().empty());
+}
+
+TEST(ClockSyncTest, testTargets)
+{
+    ClockSync sync;
+    sync.observeSender("#a#d1");
+    sync.observeSender("#b#d1");
+    sync.observeSender("#c#d2");
+
+    sync.observeSender("#a#d1");
+
+    // Connections to the same daemon may be on different hosts and
+    // are separate peers.
+    vector<string> targets = sync.getPingTargets();
+    ASSERT_EQ(3u, targets.size());
+    EXPECT_EQ("#a#d1", targets[0]);
+    EXPECT_EQ("#b#d1", targets[1]);
+    EXPECT_EQ("#c#d2", targets[2]);
+}
+
+TEST(ClockSyncTest, testMaxPeers)
+{
+    ClockSync sync(2);
+    sync.observeSender("#a#d1");
+    sync.observeSender("#b#d2");
+    sync.observeSender("#a#d1");
+
+    // The peer which has been silent for the longest time is
+    // dropped.
+    sync.observeSender("#c#d3");
+    vector<string> targets = sync.getPingTargets();
+    ASSERT_EQ(2u, targets.size());
+    EXPECT_EQ("#a#d1", targets[0]);
+    EXPECT_EQ("#c#d3", targets[1]);
+}
+
+TEST(ClockSyncTest, testPeersOfSameDaemon)
+{
+    ClockSync sync;
+    sync.observeSender("#a#d1");
+    sync.observeSender("#b#d1");
+
+    ASSERT_TRUE(sync.addSample("#a#d1", 0, 1100, 1110, 210));
+    ASSERT_TRUE(sync.addSample("#b#d1", 0, 2100, 2110, 210));
+    ClockSync::PeerClock clock;
+    ASSERT_TRUE(sync.getPeerClock("#a#d1", clock));
+    EXPECT_EQ(1000, clock.offset);
+    ASSERT_TRUE(sync.getPeerClock("#b#d1", clock));
+    EXPECT_EQ(2000, clock.offset);
+}
+
+TEST(ClockSyncTest, testOffsetEstimate)
+{
+    ClockSync sync;
+    sync.observeSender("#a#d1");
+
+    // Peer clock is 1000 ahead, 100 in each direction, 10 to answer.
+    ASSERT_TRUE(sync.addSample("#a#d1", 0, 1100, 1110, 210));
+    ClockSync::PeerClock clock;
+    ASSERT_TRUE(sync.getPeerClock("#a#d1", clock));
+    EXPECT_EQ(1000, clock.offset);
+    EXPECT_EQ(200u, clock.roundTripTime);
+    EXPECT_EQ(1u, clock.numSamples);
+
+    // An exchange with a larger round-trip time and an asymmetric
+    // delay must not replace the better estimate.
+    ASSERT_TRUE(sync.addSample("#a#d1", 1000, 2100, 2110, 1610));
+    ASSERT_TRUE(sync.getPeerClock("#a#d1", clock));
+    EXPECT_EQ(1000, clock.offset);
+    EXPECT_EQ(200u, clock.roundTripTime);
+
+    // A better exchange does.
+    ASSERT_TRUE(sync.addSample("#a#d1", 2000, 3020, 3030, 2050));
+    ASSERT_TRUE(sync.getPeerClock("#a#d1", clock));
+    EXPECT_EQ(1000, clock.offset);
+    EXPECT_EQ(40u, clock.roundTripTime);
+    EXPECT_EQ(3u, clock.numSamples);
+
+    EXPECT_EQ(1u, sync.getPeerClocks().size());
+}
+
+TEST(ClockSyncTest, testWindow)
+{
+    ClockSync sync(256, 2);
+    sync.observeSender("#a#d1");
+
+    ASSERT_TRUE(sync.addSample("#a#d1", 0, 510, 510, 20));
+    ASSERT_TRUE(sync.addSample("#a#d1", 0, 600, 600, 100));
+    ClockSync::PeerClock clock;
+    ASSERT_TRUE(sync.getPeerClock("#a#d1", clock));
+    EXPECT_EQ(20u, clock.roundTripTime);
+
+    // The good sample leaves the window.
+    ASSERT_TRUE(sync.addSample("#a#d1", 0, 600, 600, 100));
+    ASSERT_TRUE(sync.getPeerClock("#a#d1", clock));
+    EXPECT_EQ(100u, clock.roundTripTime);
+    EXPECT_EQ(550, clock.offset);
+}
+
+TEST(ClockSyncTest, testInconsistentSample)
+{
+    ClockSync sync;
+    sync.observeSender("#a#d1");
+    EXPECT_FALSE(sync.addSample("#a#d1", 100, 10, 20, 50));
+    EXPECT_FALSE(sync.addSample("#a#d1", 0, 20, 10, 50));
+}
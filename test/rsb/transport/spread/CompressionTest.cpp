@@ -0,0 +1,155 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <rsc/misc/langutils.h>
+
+#include <rsb/transport/spread/Compression.h>
+
+using namespace std;
+
+using namespace rsb::transport::spread;
+
+using namespace testing;
+
+TEST(CompressionTest, testNone)
+{
+    EXPECT_FALSE(findPayloadCodec("none"));
+    EXPECT_THROW(findPayloadCodec("no-such-codec"), std::invalid_argument);
+}
+
+TEST(CompressionTest, testRoundtrip)
+{
+    const string original(100000, 'a');
+
+    set<string> codecs = availablePayloadCodecs();
+    for (set<string>::const_iterator it = codecs.begin();
+         it != codecs.end(); ++it) {
+        PayloadCodecPtr codec = findPayloadCodec(*it);
+        ASSERT_TRUE(codec);
+        EXPECT_EQ(*it, codec->getName());
+
+        string wireSchema = "utf-8-string";
+        string compressed;
+        ASSERT_TRUE(maybeCompressPayload(*codec, 1000, original,
+                                         wireSchema, compressed))
+            << "Codec " << *it;
+        EXPECT_TRUE(isCompressedWireSchema(wireSchema));
+        EXPECT_LT(compressed.size(), original.size());
+
+        ASSERT_TRUE(maybeDecompressPayload(wireSchema, compressed));
+        EXPECT_EQ("utf-8-string", wireSchema);
+        EXPECT_EQ(original, compressed);
+    }
+}
+
+TEST(CompressionTest, testThresholdAndIncompressible)
+{
+    set<string> codecs = availablePayloadCodecs();
+    for (set<string>::const_iterator it = codecs.begin();
+         it != codecs.end(); ++it) {
+        PayloadCodecPtr codec = findPayloadCodec(*it);
+
+        // Below threshold.
+        {
+            string wireSchema = "utf-8-string";
+            string compressed;
+            EXPECT_FALSE(maybeCompressPayload(*codec, 1000, string(999, 'a'),
+                                              wireSchema, compressed));
+            EXPECT_EQ("utf-8-string", wireSchema);
+        }
+
+        // Does not shrink.
+        {
+            string wireSchema = "utf-8-string";
+            string compressed;
+            EXPECT_FALSE(maybeCompressPayload(*codec, 0, "ab",
+                                              wireSchema, compressed));
+            EXPECT_EQ("utf-8-string", wireSchema);
+        }
+    }
+}
+
+TEST(CompressionTest, testUncompressedPassThrough)
+{
+    string wireSchema = "utf-8-string";
+    string payload    = rsc::misc::randAlnumStr(100);
+    string original   = payload;
+    EXPECT_FALSE(isCompressedWireSchema(wireSchema));
+    EXPECT_TRUE(maybeDecompressPayload(wireSchema, payload));
+    EXPECT_EQ("utf-8-string", wireSchema);
+    EXPECT_EQ(original, payload);
+}
+
+TEST(CompressionTest, testCorruptPayload)
+{
+    {
+        string wireSchema = "compressed:no-such-codec:utf-8-string";
+        string payload    = "foo bar";
+        EXPECT_FALSE(maybeDecompressPayload(wireSchema, payload));
+        EXPECT_EQ("compressed:no-such-codec:utf-8-string", wireSchema);
+        EXPECT_EQ("foo bar", payload);
+    }
+
+    set<string> codecs = availablePayloadCodecs();
+    for (set<string>::const_iterator it = codecs.begin();
+         it != codecs.end(); ++it) {
+        string wireSchema = "compressed:" + *it + ":utf-8-string";
+        string payload    = string("\x10\x00\x00\x00", 4) + "garbage";
+        EXPECT_FALSE(maybeDecompressPayload(wireSchema, payload));
+        EXPECT_EQ("compressed:" + *it + ":utf-8-string", wireSchema);
+    }
+}
+
+TEST(CompressionTest, testForgedSize)
+{
+    set<string> codecs = availablePayloadCodecs();
+    for (set<string>::const_iterator it = codecs.begin();
+         it != codecs.end(); ++it) {
+        PayloadCodecPtr codec = findPayloadCodec(*it);
+
+        string wireSchema = "utf-8-string";
+        string compressed;
+        ASSERT_TRUE(maybeCompressPayload(*codec, 0, string(10000, 'a'),
+                                         wireSchema, compressed));
+
+        // Claim an uncompressed size of almost 4 GiB.
+        string forged = compressed;
+        forged.replace(0, 4, "\xf0\xff\xff\xff", 4);
+        string forgedWireSchema = wireSchema;
+        EXPECT_FALSE(maybeDecompressPayload(forgedWireSchema, forged))
+            << "Codec " << *it;
+        EXPECT_EQ(wireSchema, forgedWireSchema);
+
+        // A size within the ratio but not matching the data.
+        forged = compressed;
+        forged.replace(0, 4, "\x11\x27\x00\x00", 4);
+        EXPECT_FALSE(maybeDecompressPayload(forgedWireSchema, forged))
+            << "Codec " << *it;
+    }
+}
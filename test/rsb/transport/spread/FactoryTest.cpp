@@ -0,0 +1,211 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#include <gtest/gtest.h>
+
+#include <map>
+
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
+#include <rsc/runtime/Properties.h>
+
+#include <rsc/misc/UUID.h>
+#include <rsc/runtime/TypeStringTools.h>
+
+#include <rsb/Handler.h>
+#include <rsb/Scope.h>
+
+#include "rsb/converter/Repository.h"
+
+#include "rsb/transport/spread/Factory.h"
+#include "rsb/transport/spread/GroupNameCache.h"
+#include "rsb/transport/spread/InConnector.h"
+#include "rsb/transport/spread/LoopbackConnection.h"
+#include "rsb/transport/spread/OutConnector.h"
+
+#include "../../InformerTask.h"
+
+using namespace std;
+using namespace rsb;
+using namespace rsb::converter;
+using namespace rsb::test;
+using namespace rsb::transport::spread;
+using namespace testing;
+
+// Creates loopback connections instead of spread connections and
+// counts them.
+class LoopbackConnectionFactory {
+public:
+    explicit LoopbackConnectionFactory(LoopbackDaemonPtr daemon)
+        : daemon(daemon), numCreated(0) {
+    }
+
+    ConnectionPtr create(const string& /*host*/, unsigned int /*port*/) {
+        ++this->numCreated;
+        return ConnectionPtr(new LoopbackConnection(this->daemon));
+    }
+
+    LoopbackDaemonPtr daemon;
+    unsigned int      numCreated;
+};
+
+// Creates loopback connections to one of several daemons selected
+// by port.
+class LoopbackDaemonsFactory {
+public:
+    ConnectionPtr create(const string& /*host*/, unsigned int port) {
+        return ConnectionPtr(new LoopbackConnection(this->daemons[port]));
+    }
+
+    map<unsigned int, LoopbackDaemonPtr> daemons;
+};
+
+rsc::runtime::Properties makeProperties() {
+    rsc::runtime::Properties properties;
+    properties.set<string>("host", "localhost");
+    properties.set<string>("port", "4803");
+    properties.set<ConverterSelectionStrategy<string>::Ptr>
+        ("converters",
+         converterRepository<string>()->getConvertersForDeserialization());
+    return properties;
+}
+
+TEST(FactoryTest, testWarmUp) {
+    LoopbackDaemonPtr daemon(new LoopbackDaemon());
+    LoopbackConnectionFactory connections(daemon);
+    Factory factory(boost::bind(&LoopbackConnectionFactory::create,
+                                &connections, _1, _2));
+
+    const string groupA = GroupNameCache::scopeToGroup(Scope("/a"));
+    const string groupB = GroupNameCache::scopeToGroup(Scope("/b"));
+
+    rsc::runtime::Properties properties = makeProperties();
+    properties.set<string>("warmupscopes", "/a, /b");
+    factory.warmUp(properties);
+    EXPECT_EQ(1u, connections.numCreated);
+    EXPECT_EQ(1u, daemon->getNumMembers(groupA));
+    EXPECT_EQ(1u, daemon->getNumMembers(groupB));
+
+    // Connectors with the same options reuse the warmed-up bus.
+    {
+        boost::shared_ptr<InConnector> connector
+            (dynamic_cast<InConnector*>
+             (factory.createInConnector(makeProperties())));
+        connector->setScope(Scope("/a"));
+        connector->activate();
+        EXPECT_EQ(1u, connections.numCreated);
+        EXPECT_EQ(1u, daemon->getNumMembers(groupA));
+        connector->deactivate();
+    }
+
+    // Releasing the warmed-up bus disconnects it once it is unused.
+    factory.releaseWarmBuses();
+    EXPECT_EQ(0u, daemon->getNumMembers(groupA));
+    EXPECT_EQ(0u, daemon->getNumMembers(groupB));
+}
+
+TEST(FactoryTest, testNotificationFilterOptions) {
+    LoopbackDaemonPtr daemon(new LoopbackDaemon());
+    LoopbackConnectionFactory connections(daemon);
+    Factory factory(boost::bind(&LoopbackConnectionFactory::create,
+                                &connections, _1, _2));
+
+    const Scope scope("/filtered");
+    WaitingObserver observer(scope, 1);
+
+    rsc::runtime::Properties inProperties = makeProperties();
+    inProperties.set<string>("filtermethod", "REQUEST");
+    inProperties.set<string>("filteruserinfo", "priority=high");
+    boost::shared_ptr<InConnector> in
+        (dynamic_cast<InConnector*>(factory.createInConnector(inProperties)));
+    in->setScope(scope);
+    in->activate();
+    in->addHandler(HandlerPtr(new EventFunctionHandler
+                              (boost::bind(&WaitingObserver::handler,
+                                           &observer, _1))));
+
+    rsc::runtime::Properties outProperties = makeProperties();
+    outProperties.set<ConverterSelectionStrategy<string>::Ptr>
+        ("converters",
+         converterRepository<string>()->getConvertersForSerialization());
+    boost::shared_ptr<OutConnector> out
+        (dynamic_cast<OutConnector*>(factory.createOutConnector(outProperties)));
+    out->activate();
+
+    // Only the last event matches both filters.
+    const char* methods[]    = { "PUBLISH", "REQUEST", "REQUEST" };
+    const char* priorities[] = { "high",    "low",     "high"    };
+    for (unsigned int i = 0; i < 3; ++i) {
+        EventPtr event(new Event(scope,
+                                 boost::shared_ptr<string>(new string("foo")),
+                                 rsc::runtime::typeName<string>()));
+        event->setId(rsc::misc::UUID(), i + 1);
+        event->setMethod(methods[i]);
+        event->mutableMetaData().setUserInfo("priority", priorities[i]);
+        out->handle(event);
+    }
+
+    ASSERT_TRUE(observer.waitReceived(10000));
+    EventPtr received = observer.getEvents()[0];
+    EXPECT_EQ(3u, received->getId().getSequenceNumber());
+
+    in->deactivate();
+    out->deactivate();
+}
+
+TEST(FactoryTest, testDistributeFailsOverReceiving) {
+    LoopbackDaemonsFactory connections;
+    connections.daemons[1].reset(new LoopbackDaemon());
+    connections.daemons[2].reset(new LoopbackDaemon());
+    Factory factory(boost::bind(&LoopbackDaemonsFactory::create,
+                                &connections, _1, _2));
+
+    rsc::runtime::Properties properties = makeProperties();
+    properties.set<string>("daemons", "localhost:1,localhost:2");
+    properties.set<string>("daemonmode", "distribute");
+    properties.set<string>("reconnect", "50");
+    boost::shared_ptr<InConnector> connector
+        (dynamic_cast<InConnector*>(factory.createInConnector(properties)));
+    connector->setScope(Scope("/a"));
+    connector->activate();
+
+    const string group = GroupNameCache::scopeToGroup(Scope("/a"));
+    EXPECT_EQ(1u, connections.daemons[1]->getNumMembers(group));
+    EXPECT_EQ(0u, connections.daemons[2]->getNumMembers(group));
+
+    // The receiving connection moves to the remaining daemon and
+    // joins the group there.
+    connections.daemons[1]->stop();
+    for (unsigned int i = 0;
+         (i < 500) && (connections.daemons[2]->getNumMembers(group) == 0);
+         ++i) {
+        boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+    }
+    EXPECT_EQ(1u, connections.daemons[2]->getNumMembers(group));
+
+    connector->deactivate();
+}
@@ -0,0 +1,96 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#include <gtest/gtest.h>
+
+#include "rsb/transport/spread/FailoverConnection.h"
+#include "rsb/transport/spread/LoopbackConnection.h"
+#include "rsb/CommException.h"
+
+using namespace std;
+using namespace rsb::transport::spread;
+using namespace testing;
+
+class FailoverConnectionTest : public ::testing::Test {
+protected:
+    virtual void SetUp() {
+        std::vector<ConnectionPtr> connections;
+        for (unsigned int i = 0; i < 2; ++i) {
+            this->daemons.push_back(LoopbackDaemonPtr(new LoopbackDaemon()));
+            connections.push_back(LoopbackConnectionPtr
+                                  (new LoopbackConnection(this->daemons.back())));
+        }
+        this->connection.reset(new FailoverConnection(connections));
+    }
+
+    std::vector<LoopbackDaemonPtr> daemons;
+    FailoverConnectionPtr          connection;
+};
+
+TEST_F(FailoverConnectionTest, testPreferFirst) {
+    this->connection->activate();
+    EXPECT_EQ(0u, this->connection->getCurrentIndex());
+    EXPECT_TRUE(this->connection->isActive());
+
+    // Without errors, reactivating keeps using the same daemon.
+    this->connection->deactivate();
+    EXPECT_FALSE(this->connection->isActive());
+    this->connection->activate();
+    EXPECT_EQ(0u, this->connection->getCurrentIndex());
+}
+
+TEST_F(FailoverConnectionTest, testConnectError) {
+    this->daemons[0]->stop();
+    this->connection->activate();
+    EXPECT_EQ(1u, this->connection->getCurrentIndex());
+    this->connection->deactivate();
+
+    this->daemons[1]->stop();
+    EXPECT_THROW(this->connection->activate(), rsb::CommException);
+    EXPECT_FALSE(this->connection->isActive());
+}
+
+TEST_F(FailoverConnectionTest, testReceiveError) {
+    this->connection->activate();
+
+    // The first daemon is running again by the time of reconnecting,
+    // but the connection continues with the next one.
+    this->daemons[0]->stop();
+    this->daemons[0]->start();
+    SpreadMessage message;
+    EXPECT_THROW(this->connection->receive(message), rsb::CommException);
+    this->connection->deactivate();
+    this->connection->activate();
+    EXPECT_EQ(1u, this->connection->getCurrentIndex());
+
+    // Wrap around to the first daemon.
+    this->daemons[1]->stop();
+    message.addGroup("a");
+    EXPECT_THROW(this->connection->send(message), rsb::CommException);
+    this->connection->deactivate();
+    this->connection->activate();
+    EXPECT_EQ(0u, this->connection->getCurrentIndex());
+}
@@ -0,0 +1,83 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <rsb/transport/spread/FragmentPool.h>
+
+using namespace std;
+
+using namespace rsb;
+using namespace rsb::transport::spread;
+
+using namespace testing;
+
+TEST(FragmentPoolTest, testRecycle)
+{
+    FragmentPoolPtr pool(new FragmentPool(2));
+    EXPECT_EQ(0u, pool->size());
+
+    rsb::protocol::FragmentedNotification* raw;
+    {
+        rsb::protocol::FragmentedNotificationPtr fragment = pool->acquire();
+        raw = fragment.get();
+    }
+    EXPECT_EQ(1u, pool->size());
+
+    rsb::protocol::FragmentedNotificationPtr fragment = pool->acquire();
+    EXPECT_EQ(raw, fragment.get());
+    EXPECT_EQ(0u, pool->size());
+}
+
+TEST(FragmentPoolTest, testBounded)
+{
+    FragmentPoolPtr pool(new FragmentPool(2));
+    {
+        rsb::protocol::FragmentedNotificationPtr fragment1 = pool->acquire();
+        rsb::protocol::FragmentedNotificationPtr fragment2 = pool->acquire();
+        rsb::protocol::FragmentedNotificationPtr fragment3 = pool->acquire();
+    }
+    EXPECT_EQ(2u, pool->size());
+}
+
+TEST(FragmentPoolTest, testLargePayloadNotRetained)
+{
+    FragmentPoolPtr pool(new FragmentPool(2, 1000));
+    {
+        rsb::protocol::FragmentedNotificationPtr fragment = pool->acquire();
+        fragment->mutable_notification()->set_data(string(2000, 'a'));
+    }
+    EXPECT_EQ(0u, pool->size());
+}
+
+TEST(FragmentPoolTest, testOutlivesPool)
+{
+    FragmentPoolPtr pool(new FragmentPool());
+    rsb::protocol::FragmentedNotificationPtr fragment = pool->acquire();
+    pool.reset();
+    fragment.reset();
+}
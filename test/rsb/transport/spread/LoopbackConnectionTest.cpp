@@ -0,0 +1,283 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#include <gtest/gtest.h>
+
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
+#include <rsc/misc/IllegalStateException.h>
+#include <rsc/misc/langutils.h>
+
+#include "rsb/transport/spread/LoopbackConnection.h"
+#include "rsb/CommException.h"
+
+using namespace std;
+using namespace rsb::transport::spread;
+using namespace testing;
+
+class LoopbackConnectionTest : public ::testing::Test {
+protected:
+    virtual void SetUp() {
+        this->daemon.reset(new LoopbackDaemon(42));
+        this->sender.reset(new LoopbackConnection(this->daemon));
+        this->sender->activate();
+        this->receiver.reset(new LoopbackConnection(this->daemon));
+        this->receiver->activate();
+    }
+
+    SpreadMessage makeMessage(const string& data,
+                              const string& group,
+                              SpreadMessage::QOS qos = SpreadMessage::RELIABLE) {
+        SpreadMessage message(data);
+        message.setQOS(qos);
+        message.addGroup(group);
+        return message;
+    }
+
+    // Receives and counts the messages which are due for delivery.
+    unsigned int drain(LoopbackConnectionPtr connection) {
+        unsigned int count = 0;
+        while (connection->getPendingBytes() > 0) {
+            SpreadMessage message;
+            connection->receive(message);
+            ++count;
+        }
+        return count;
+    }
+
+    LoopbackDaemonPtr     daemon;
+    LoopbackConnectionPtr sender;
+    LoopbackConnectionPtr receiver;
+};
+
+TEST_F(LoopbackConnectionTest, testActivationStateChecks) {
+    LoopbackConnection connection(this->daemon);
+
+    SpreadMessage message("foo");
+    message.addGroup("blubb");
+    EXPECT_THROW(connection.send(message), rsc::misc::IllegalStateException);
+    EXPECT_THROW(connection.receive(message), rsc::misc::IllegalStateException);
+    EXPECT_THROW(connection.join("blubb"), rsc::misc::IllegalStateException);
+    EXPECT_THROW(connection.interruptReceive(),
+                 rsc::misc::IllegalStateException);
+    EXPECT_THROW(connection.deactivate(), rsc::misc::IllegalStateException);
+
+    connection.activate();
+    EXPECT_THROW(connection.activate(), rsc::misc::IllegalStateException);
+    EXPECT_EQ("spread://loopback", connection.getTransportURL());
+}
+
+TEST_F(LoopbackConnectionTest, testPrivateGroups) {
+    EXPECT_EQ('#', this->sender->getPrivateGroup()[0]);
+    EXPECT_NE(this->sender->getPrivateGroup(),
+              this->receiver->getPrivateGroup());
+
+    this->sender->send(makeMessage("foo", this->receiver->getPrivateGroup()));
+
+    SpreadMessage message;
+    this->receiver->receive(message);
+    EXPECT_EQ(SpreadMessage::REGULAR, message.getType());
+    EXPECT_EQ(SpreadMessage::RELIABLE, message.getQOS());
+    EXPECT_EQ("foo", message.getData());
+    EXPECT_EQ(this->sender->getPrivateGroup(), message.getSender());
+    EXPECT_EQ(1u, message.getGroups().count(this->receiver->getPrivateGroup()));
+}
+
+TEST_F(LoopbackConnectionTest, testJoinLeave) {
+    this->sender->send(makeMessage("before", "a"));
+    EXPECT_EQ(0u, drain(this->receiver));
+
+    this->receiver->join("a");
+    this->sender->send(makeMessage("member", "a"));
+    EXPECT_EQ(1u, drain(this->receiver));
+
+    this->receiver->leave("a");
+    this->sender->send(makeMessage("after", "a"));
+    EXPECT_EQ(0u, drain(this->receiver));
+
+    EXPECT_THROW(this->receiver->leave("a"), rsb::CommException);
+}
+
+TEST_F(LoopbackConnectionTest, testMultigroupDeliversOnce) {
+    this->receiver->join("a");
+    this->receiver->join("b");
+
+    SpreadMessage message = makeMessage("foo", "a");
+    message.addGroup("b");
+    message.addGroup("c");
+    this->sender->send(message);
+
+    SpreadMessage received;
+    this->receiver->receive(received);
+    EXPECT_EQ(message.getGroups(), received.getGroups());
+    EXPECT_EQ(0u, drain(this->receiver));
+}
+
+TEST_F(LoopbackConnectionTest, testSelfDiscard) {
+    this->sender->join("a");
+    this->receiver->join("a");
+
+    this->sender->send(makeMessage("foo", "a"));
+    EXPECT_EQ(0u, drain(this->sender));
+    EXPECT_EQ(1u, drain(this->receiver));
+}
+
+TEST_F(LoopbackConnectionTest, testDeactivateLeavesGroups) {
+    this->receiver->join("a");
+    this->receiver->deactivate();
+
+    LoopbackConnectionPtr other(new LoopbackConnection(this->daemon));
+    other->activate();
+    other->join("a");
+    this->sender->send(makeMessage("foo", "a"));
+    EXPECT_EQ(1u, drain(other));
+}
+
+TEST_F(LoopbackConnectionTest, testDaemonRestart) {
+    this->receiver->join("a");
+
+    this->daemon->stop();
+    SpreadMessage message;
+    EXPECT_THROW(this->receiver->receive(message), rsb::CommException);
+    EXPECT_THROW(this->sender->send(makeMessage("foo", "a")),
+                 rsb::CommException);
+    EXPECT_THROW(this->receiver->join("b"), rsb::CommException);
+    this->receiver->deactivate();
+    EXPECT_THROW(this->receiver->activate(), rsb::CommException);
+
+    // Memberships do not survive the restart.
+    this->daemon->start();
+    this->sender->deactivate();
+    this->sender->activate();
+    this->receiver->activate();
+    this->sender->send(makeMessage("foo", "a"));
+    EXPECT_EQ(0u, drain(this->receiver));
+
+    this->receiver->join("a");
+    this->sender->send(makeMessage("foo", "a"));
+    EXPECT_EQ(1u, drain(this->receiver));
+}
+
+void receiveUntilInterrupted(LoopbackConnectionPtr connection,
+                             unsigned int*         count) {
+    try {
+        SpreadMessage message;
+        while (true) {
+            connection->receive(message);
+            ++*count;
+        }
+    } catch (boost::thread_interrupted&) {
+    }
+}
+
+TEST_F(LoopbackConnectionTest, testInterruptReceive) {
+    this->receiver->join("a");
+    this->sender->send(makeMessage("foo", "a"));
+
+    unsigned int count = 0;
+    boost::thread receiveThread(boost::bind(&receiveUntilInterrupted,
+                                            this->receiver, &count));
+    boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+    this->receiver->interruptReceive();
+    receiveThread.join();
+    EXPECT_EQ(1u, count);
+}
+
+TEST_F(LoopbackConnectionTest, testLossOnlyAffectsUnreliable) {
+    LoopbackDaemon::Faults faults;
+    faults.loss = 1.0;
+    this->daemon->setFaults(faults);
+    this->receiver->join("a");
+
+    this->sender->send(makeMessage("foo", "a", SpreadMessage::UNRELIABLE));
+    EXPECT_EQ(0u, drain(this->receiver));
+
+    this->sender->send(makeMessage("foo", "a", SpreadMessage::RELIABLE));
+    EXPECT_EQ(1u, drain(this->receiver));
+}
+
+TEST_F(LoopbackConnectionTest, testPartialLossIsReproducible) {
+    LoopbackDaemon::Faults faults;
+    faults.loss = 0.5;
+
+    unsigned int counts[2];
+    for (unsigned int run = 0; run < 2; ++run) {
+        SetUp();
+        this->daemon->setFaults(faults);
+        this->receiver->join("a");
+        for (unsigned int i = 0; i < 100; ++i) {
+            this->sender->send(makeMessage("foo", "a",
+                                           SpreadMessage::UNRELIABLE));
+        }
+        counts[run] = drain(this->receiver);
+    }
+    EXPECT_LT(0u, counts[0]);
+    EXPECT_GT(100u, counts[0]);
+    EXPECT_EQ(counts[0], counts[1]);
+}
+
+TEST_F(LoopbackConnectionTest, testDuplication) {
+    LoopbackDaemon::Faults faults;
+    faults.duplication = 1.0;
+    this->daemon->setFaults(faults);
+    this->receiver->join("a");
+
+    this->sender->send(makeMessage("foo", "a", SpreadMessage::UNRELIABLE));
+    EXPECT_EQ(2u, drain(this->receiver));
+}
+
+TEST_F(LoopbackConnectionTest, testLatency) {
+    LoopbackDaemon::Faults faults;
+    faults.latency = 200000;
+    this->daemon->setFaults(faults);
+    this->receiver->join("a");
+
+    boost::uint64_t start = rsc::misc::currentTimeMicros();
+    this->sender->send(makeMessage("foo", "a"));
+    EXPECT_EQ(0, this->receiver->getPendingBytes());
+
+    SpreadMessage message;
+    this->receiver->receive(message);
+    EXPECT_LE(start + faults.latency, rsc::misc::currentTimeMicros());
+}
+
+TEST_F(LoopbackConnectionTest, testReordering) {
+    LoopbackDaemon::Faults faults;
+    faults.reordering   = 1.0;
+    faults.reorderDelay = 50000;
+    this->daemon->setFaults(faults);
+    this->receiver->join("a");
+
+    this->sender->send(makeMessage("first", "a", SpreadMessage::UNRELIABLE));
+    this->sender->send(makeMessage("second", "a", SpreadMessage::RELIABLE));
+
+    SpreadMessage message;
+    this->receiver->receive(message);
+    EXPECT_EQ("second", message.getData());
+    this->receiver->receive(message);
+    EXPECT_EQ("first", message.getData());
+}
@@ -27,7 +27,9 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
+#include <rsb/transport/spread/LoopbackConnection.h>
 #include <rsb/transport/spread/MembershipManager.h>
+#include <rsb/transport/spread/SpreadConnection.h>
 
 #include "testconfig.h"
 
@@ -58,3 +60,50 @@ TEST(MembershipManagerTest, testRoundtrip)
     // left b as well
     ASSERT_NO_THROW(mm.leave("b"));
 }
+
+TEST(MembershipManagerTest, testSuspendRejoin)
+{
+    LoopbackDaemonPtr daemon(new LoopbackDaemon());
+    LoopbackConnectionPtr sender(new LoopbackConnection(daemon));
+    sender->activate();
+    LoopbackConnectionPtr receiver(new LoopbackConnection(daemon));
+    receiver->activate();
+
+    MembershipManager mm(receiver);
+    mm.join("a");
+    mm.join("a");
+    mm.join("b");
+
+    // Changes while suspended are only recorded, even if the
+    // connection is unusable.
+    mm.suspend();
+    receiver->deactivate();
+    mm.leave("a");
+    mm.leave("b");
+    mm.join("c");
+    EXPECT_TRUE(mm.isMember("a"));
+    EXPECT_FALSE(mm.isMember("b"));
+    EXPECT_TRUE(mm.isMember("c"));
+    receiver->activate();
+    mm.rejoin();
+
+    SpreadMessage message("foo");
+    message.addGroup("a");
+    message.addGroup("b");
+    sender->send(message);
+    SpreadMessage received;
+    receiver->receive(received);
+    EXPECT_EQ(1u, received.getGroups().count("a"));
+    EXPECT_EQ(0, receiver->getPendingBytes());
+
+    SpreadMessage other("bar");
+    other.addGroup("c");
+    sender->send(other);
+    receiver->receive(received);
+    EXPECT_EQ("bar", received.getData());
+
+    // Not suspended anymore.
+    mm.leave("a");
+    sender->send(message);
+    EXPECT_EQ(0, receiver->getPendingBytes());
+}
@@ -0,0 +1,170 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#include <sstream>
+#include <stdexcept>
+
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <rsb/transport/spread/Metrics.h>
+
+using namespace std;
+
+using namespace rsb;
+using namespace rsb::transport::spread;
+
+using namespace testing;
+
+TEST(MetricsTest, testCounter)
+{
+    Counter counter;
+    EXPECT_EQ(0u, counter.get());
+    counter.increment();
+    counter.increment(41);
+    EXPECT_EQ(42u, counter.get());
+}
+
+TEST(MetricsTest, testGauge)
+{
+    Gauge gauge;
+    gauge.add(5);
+    gauge.add(-7);
+    EXPECT_EQ(-2, gauge.get());
+    gauge.set(3);
+    EXPECT_EQ(3, gauge.get());
+}
+
+TEST(MetricsTest, testHistogram)
+{
+    Histogram histogram;
+    EXPECT_EQ(0u, histogram.getQuantile(0.5));
+
+    histogram.record(0);
+    histogram.record(1);
+    histogram.record(3);
+    histogram.record(1000);
+    EXPECT_EQ(4u, histogram.getCount());
+    EXPECT_EQ(1004u, histogram.getSum());
+    EXPECT_EQ(1u, histogram.getBucketCount(0));
+    EXPECT_EQ(1u, histogram.getBucketCount(1));
+    EXPECT_EQ(1u, histogram.getBucketCount(3));
+    EXPECT_EQ(1u, histogram.getBucketCount(Histogram::getBucketIndex(1000)));
+
+    EXPECT_EQ(1u, histogram.getQuantile(0.5));
+    EXPECT_EQ(1023u, histogram.getQuantile(1.0));
+}
+
+TEST(MetricsTest, testHistogramBuckets)
+{
+    // Every value lies in its bucket and the relative width of the
+    // buckets is bounded.
+    for (boost::uint64_t value = 1; value < (boost::uint64_t(1) << 40);
+         value = value * 3 / 2 + 1) {
+        unsigned int index = Histogram::getBucketIndex(value);
+        EXPECT_LE(value, Histogram::getBucketUpperBound(index));
+        if (index > 0) {
+            EXPECT_GT(value, Histogram::getBucketUpperBound(index - 1));
+        }
+        EXPECT_LE(Histogram::getBucketUpperBound(index) - value,
+                  value / 8);
+    }
+
+    EXPECT_EQ(Histogram::NUM_BUCKETS - 1,
+              Histogram::getBucketIndex(~boost::uint64_t(0)));
+}
+
+namespace {
+
+void recordSamples(Histogram* histogram) {
+    for (unsigned int i = 0; i < 10000; ++i) {
+        histogram->record(i);
+    }
+}
+
+}
+
+TEST(MetricsTest, testHistogramConcurrent)
+{
+    Histogram histogram;
+    boost::thread_group threads;
+    for (unsigned int i = 0; i < 4; ++i) {
+        threads.create_thread(boost::bind(&recordSamples, &histogram));
+    }
+    threads.join_all();
+
+    EXPECT_EQ(40000u, histogram.getCount());
+    EXPECT_EQ(4u * 9999u * 10000u / 2u, histogram.getSum());
+}
+
+TEST(MetricsTest, testRegistry)
+{
+    MetricsRegistry registry;
+
+    Counter& counter = registry.getCounter("requests_total", "Requests.",
+                                           MetricLabels().add("scope", "/a"));
+    EXPECT_EQ(&counter,
+              &registry.getCounter("requests_total", "Requests.",
+                                   MetricLabels().add("scope", "/a")));
+    EXPECT_NE(&counter,
+              &registry.getCounter("requests_total", "Requests.",
+                                   MetricLabels().add("scope", "/b")));
+
+    EXPECT_THROW(registry.getGauge("requests_total", "Requests."),
+                 std::logic_error);
+
+    EXPECT_EQ(&counter,
+              registry.findCounter("requests_total",
+                                   MetricLabels().add("scope", "/a")));
+    EXPECT_EQ(0, registry.findCounter("requests_total",
+                                      MetricLabels().add("scope", "/c")));
+    EXPECT_EQ(0, registry.findHistogram("requests_total",
+                                        MetricLabels().add("scope", "/a")));
+}
+
+TEST(MetricsTest, testPrometheus)
+{
+    MetricsRegistry registry;
+    registry.getCounter("requests_total", "Requests.",
+                        MetricLabels().add("scope", "/a\"b")).increment(2);
+    registry.getHistogram("duration", "Duration.").record(2);
+
+    ostringstream stream;
+    registry.writePrometheus(stream);
+    EXPECT_EQ("# HELP duration Duration.\n"
+              "# TYPE duration histogram\n"
+              "duration_bucket{le=\"2\"} 1\n"
+              "duration_bucket{le=\"+Inf\"} 1\n"
+              "duration_sum 2\n"
+              "duration_count 1\n"
+              "# HELP requests_total Requests.\n"
+              "# TYPE requests_total counter\n"
+              "requests_total{scope=\"/a\\\"b\"} 2\n",
+              stream.str());
+}
@@ -0,0 +1,116 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <rsc/misc/UUID.h>
+
+#include <rsb/transport/spread/NotificationFilter.h>
+
+using namespace std;
+
+using namespace rsb;
+using namespace rsb::transport::spread;
+
+using namespace testing;
+
+namespace {
+
+string uuidBytes(const rsc::misc::UUID& id) {
+    boost::uuids::uuid raw = id.getId();
+    return string(raw.begin(), raw.end());
+}
+
+}
+
+class NotificationFilterTest : public ::testing::Test {
+protected:
+    void SetUp() {
+        this->header.mutable_event_id()->set_sender_id(uuidBytes(this->origin));
+        this->header.mutable_event_id()->set_sequence_number(1);
+        this->header.set_scope("/a/b");
+        this->header.set_method("REQUEST");
+
+        this->notification.scope        = Scope("/a/b");
+        this->notification.notification = &this->header;
+    }
+
+    rsc::misc::UUID             origin;
+    rsb::protocol::Notification header;
+    Notification                notification;
+};
+
+TEST_F(NotificationFilterTest, testScope)
+{
+    EXPECT_TRUE(ScopeNotificationFilter(Scope("/a/b")).match(this->notification));
+    EXPECT_TRUE(ScopeNotificationFilter(Scope("/a")).match(this->notification));
+    EXPECT_FALSE(ScopeNotificationFilter(Scope("/a/b/c")).match(this->notification));
+    EXPECT_FALSE(ScopeNotificationFilter(Scope("/c")).match(this->notification));
+}
+
+TEST_F(NotificationFilterTest, testOrigin)
+{
+    rsc::misc::UUID other;
+
+    EXPECT_TRUE(OriginNotificationFilter(this->origin).match(this->notification));
+    EXPECT_FALSE(OriginNotificationFilter(other).match(this->notification));
+    EXPECT_FALSE(OriginNotificationFilter(this->origin, true).match(this->notification));
+    EXPECT_TRUE(OriginNotificationFilter(other, true).match(this->notification));
+}
+
+TEST_F(NotificationFilterTest, testMethod)
+{
+    EXPECT_TRUE(MethodNotificationFilter("REQUEST").match(this->notification));
+    EXPECT_FALSE(MethodNotificationFilter("REPLY").match(this->notification));
+    EXPECT_FALSE(MethodNotificationFilter("").match(this->notification));
+}
+
+TEST_F(NotificationFilterTest, testCause)
+{
+    rsc::misc::UUID causeOrigin;
+    rsb::protocol::EventId* cause = this->header.add_causes();
+    cause->set_sender_id(uuidBytes(causeOrigin));
+    cause->set_sequence_number(5);
+
+    EXPECT_TRUE(CauseNotificationFilter(EventId(causeOrigin, 5)).match(this->notification));
+    EXPECT_FALSE(CauseNotificationFilter(EventId(causeOrigin, 6)).match(this->notification));
+    EXPECT_FALSE(CauseNotificationFilter(EventId(this->origin, 5)).match(this->notification));
+}
+
+TEST_F(NotificationFilterTest, testUserInfo)
+{
+    rsb::protocol::EventMetaData* metaData = this->header.mutable_meta_data();
+    metaData->set_create_time(0);
+    rsb::protocol::UserInfo* info = metaData->add_user_infos();
+    info->set_key("key");
+    info->set_value("value");
+
+    EXPECT_TRUE(UserInfoNotificationFilter("key").match(this->notification));
+    EXPECT_TRUE(UserInfoNotificationFilter("key", "value").match(this->notification));
+    EXPECT_FALSE(UserInfoNotificationFilter("key", "other").match(this->notification));
+    EXPECT_FALSE(UserInfoNotificationFilter("other").match(this->notification));
+}
@@ -0,0 +1,94 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#include <boost/thread.hpp>
+
+#include <gtest/gtest.h>
+
+#include <rsb/transport/spread/RetransmitBuffer.h>
+
+using namespace std;
+
+using namespace rsb;
+using namespace rsb::transport::spread;
+
+namespace {
+
+rsb::protocol::EventId makeEventId(boost::uint32_t sequenceNumber) {
+    rsb::protocol::EventId eventId;
+    eventId.set_sender_id("0123456789abcdef");
+    eventId.set_sequence_number(sequenceNumber);
+    return eventId;
+}
+
+OutgoingNotificationPtr makeNotification(boost::uint32_t sequenceNumber) {
+    OutgoingNotificationPtr notification(new OutgoingNotification());
+    notification->fragments.resize(1);
+    notification->notification
+        = notification->fragments[0].mutable_notification();
+    notification->notification->mutable_event_id()
+        ->CopyFrom(makeEventId(sequenceNumber));
+    return notification;
+}
+
+}
+
+TEST(RetransmitBufferTest, testFind)
+{
+    RetransmitBuffer buffer;
+    OutgoingNotificationPtr notification = makeNotification(1);
+    buffer.add(notification);
+    EXPECT_EQ(1u, buffer.size());
+    EXPECT_EQ(notification, buffer.find(makeEventId(1)));
+    EXPECT_FALSE(buffer.find(makeEventId(2)));
+
+    rsb::protocol::EventId otherSender = makeEventId(1);
+    otherSender.set_sender_id("fedcba9876543210");
+    EXPECT_FALSE(buffer.find(otherSender));
+}
+
+TEST(RetransmitBufferTest, testCountLimit)
+{
+    RetransmitBuffer buffer(3);
+    for (boost::uint32_t i = 0; i < 5; ++i) {
+        buffer.add(makeNotification(i));
+    }
+    EXPECT_EQ(3u, buffer.size());
+    EXPECT_FALSE(buffer.find(makeEventId(0)));
+    EXPECT_FALSE(buffer.find(makeEventId(1)));
+    EXPECT_TRUE(buffer.find(makeEventId(2)));
+    EXPECT_TRUE(buffer.find(makeEventId(4)));
+}
+
+TEST(RetransmitBufferTest, testAgeLimit)
+{
+    RetransmitBuffer buffer(64, 100);
+    buffer.add(makeNotification(0));
+    EXPECT_TRUE(buffer.find(makeEventId(0)));
+    boost::this_thread::sleep(boost::posix_time::milliseconds(200));
+    EXPECT_FALSE(buffer.find(makeEventId(0)));
+    EXPECT_EQ(0u, buffer.size());
+}
@@ -0,0 +1,125 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#include <gtest/gtest.h>
+
+#include <rsb/transport/spread/SequenceTracker.h>
+
+using namespace std;
+
+using namespace rsb::transport::spread;
+
+namespace {
+
+typedef SequenceTracker::Observation Observation;
+
+}
+
+TEST(SequenceTrackerTest, testInOrder)
+{
+    SequenceTracker tracker;
+    for (boost::uint32_t i = 5; i < 10; ++i) {
+        EXPECT_EQ(Observation::IN_ORDER, tracker.observe("a", i).kind);
+    }
+    SequenceTracker::Stats stats = tracker.getStats();
+    EXPECT_EQ(5u, stats.received);
+    EXPECT_EQ(0u, stats.missing);
+    EXPECT_EQ(0u, stats.reordered);
+    EXPECT_EQ(0u, stats.duplicates);
+}
+
+TEST(SequenceTrackerTest, testGapAndReordering)
+{
+    SequenceTracker tracker;
+    tracker.observe("a", 0);
+
+    Observation observation = tracker.observe("a", 4);
+    EXPECT_EQ(Observation::GAP, observation.kind);
+    EXPECT_EQ(3u, observation.numMissing);
+
+    observation = tracker.observe("a", 2);
+    EXPECT_EQ(Observation::REORDERED, observation.kind);
+    EXPECT_EQ(0u, observation.numMissing);
+
+    EXPECT_EQ(Observation::DUPLICATE, tracker.observe("a", 2).kind);
+    EXPECT_EQ(Observation::DUPLICATE, tracker.observe("a", 4).kind);
+    EXPECT_EQ(Observation::IN_ORDER, tracker.observe("a", 5).kind);
+
+    SequenceTracker::Stats stats = tracker.getStats();
+    EXPECT_EQ(3u, stats.missing);
+    EXPECT_EQ(1u, stats.reordered);
+    EXPECT_EQ(2u, stats.duplicates);
+}
+
+TEST(SequenceTrackerTest, testSendersAreIndependent)
+{
+    SequenceTracker tracker;
+    tracker.observe("a", 0);
+    EXPECT_EQ(Observation::IN_ORDER, tracker.observe("b", 100).kind);
+    EXPECT_EQ(Observation::IN_ORDER, tracker.observe("a", 1).kind);
+    EXPECT_EQ(Observation::IN_ORDER, tracker.observe("b", 101).kind);
+    EXPECT_EQ(2u, tracker.getNumSenders());
+}
+
+TEST(SequenceTrackerTest, testWindow)
+{
+    SequenceTracker tracker;
+    tracker.observe("a", 0);
+    EXPECT_EQ(Observation::GAP, tracker.observe("a", 1000).kind);
+
+    // Outside the window, duplicates cannot be told apart from
+    // reordered notifications.
+    EXPECT_EQ(Observation::REORDERED, tracker.observe("a", 0).kind);
+    EXPECT_EQ(Observation::REORDERED, tracker.observe("a", 937).kind);
+    EXPECT_EQ(Observation::DUPLICATE, tracker.observe("a", 937).kind);
+}
+
+TEST(SequenceTrackerTest, testWrapAround)
+{
+    SequenceTracker tracker;
+    tracker.observe("a", 0xfffffffeu);
+    EXPECT_EQ(Observation::IN_ORDER, tracker.observe("a", 0xffffffffu).kind);
+    EXPECT_EQ(Observation::IN_ORDER, tracker.observe("a", 0).kind);
+
+    Observation observation = tracker.observe("a", 2);
+    EXPECT_EQ(Observation::GAP, observation.kind);
+    EXPECT_EQ(1u, observation.numMissing);
+    EXPECT_EQ(Observation::DUPLICATE, tracker.observe("a", 0xffffffffu).kind);
+}
+
+TEST(SequenceTrackerTest, testMaxSenders)
+{
+    SequenceTracker tracker(2);
+    tracker.observe("a", 0);
+    tracker.observe("b", 0);
+    tracker.observe("a", 1);
+    tracker.observe("c", 0);
+    EXPECT_EQ(2u, tracker.getNumSenders());
+
+    // b has been evicted and starts over.
+    EXPECT_EQ(Observation::IN_ORDER, tracker.observe("b", 10).kind);
+    EXPECT_EQ(Observation::IN_ORDER, tracker.observe("a", 2).kind);
+}
@@ -28,13 +28,28 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
+#include <rsc/misc/UUID.h>
+#include <rsc/runtime/TypeStringTools.h>
+
+#include <rsb/CommException.h>
+#include <rsb/Handler.h>
+
 #include "rsb/converter/Repository.h"
 
 #include <rsb/transport/spread/BusImpl.h>
+#include <rsb/transport/spread/GroupNameCache.h>
+#include <rsb/transport/spread/LoopbackConnection.h>
+#include <rsb/transport/spread/SpreadConnection.h>
 #include <rsb/transport/spread/InConnector.h>
 #include <rsb/transport/spread/OutConnector.h>
+#include <rsb/transport/spread/LazyPayload.h>
+#include <rsb/transport/spread/SequenceTracker.h>
 
 #include "../ConnectorTest.h"
+#include "../../InformerTask.h"
 
 #include "testconfig.h"
 
@@ -42,9 +57,11 @@ using namespace std;
 
 using namespace testing;
 
+using namespace rsb;
 using namespace rsb::converter;
 using namespace rsb::transport;
 using namespace rsb::transport::spread;
+using namespace rsb::test;
 
 static int dummy = pullInConnectorTest();
 
@@ -71,6 +88,37 @@ OutConnectorPtr createConnectingOutConnector() {
                             bus));
 }
 
+// Like createConnectingOutConnector but the Bus uses additional
+// connections for sending.
+OutConnectorPtr createConnectingPooledOutConnector() {
+    std::vector<ConnectionPtr> sendConnections;
+    for (unsigned int i = 0; i < 3; ++i) {
+        sendConnections.push_back(SpreadConnectionPtr
+                                  (new SpreadConnection(defaultHost(), SPREAD_PORT)));
+    }
+    BusPtr bus(BusImpl::create(SpreadConnectionPtr(new SpreadConnection(
+            defaultHost(), SPREAD_PORT)), sendConnections));
+    bus->activate();
+    return OutConnectorPtr(new rsb::transport::spread::OutConnector
+                           (converterRepository<string>()
+                            ->getConvertersForSerialization(),
+                            bus));
+}
+
+// Like createConnectingOutConnector but sends compact continuation
+// fragments.
+OutConnectorPtr createConnectingCompactOutConnector() {
+    BusPtr bus(BusImpl::create(SpreadConnectionPtr(new SpreadConnection(
+            defaultHost(), SPREAD_PORT))));
+    bus->activate();
+    boost::shared_ptr<rsb::transport::spread::OutConnector> connector
+        (new rsb::transport::spread::OutConnector
+         (converterRepository<string>()->getConvertersForSerialization(),
+          bus));
+    connector->setCompactFragments(true);
+    return connector;
+}
+
 // Creates and returns an InConnector that uses a given Bus (which
 // will typically be a mock object.)
 InConnectorPtr createInConnectorWithBus(BusPtr bus) {
@@ -98,3 +146,502 @@ INSTANTIATE_TEST_CASE_P(SpreadConnector,
         ConnectorTest,
         ::testing::Values(spreadSetup))
 ;
+
+const
+ConnectorTestSetup pooledSpreadSetup(createConnectingInConnector,
+                                     createConnectingPooledOutConnector,
+                                     createInConnectorWithBus,
+                                     createOutConnectorWithBus);
+
+INSTANTIATE_TEST_CASE_P(PooledSpreadConnector,
+        ConnectorTest,
+        ::testing::Values(pooledSpreadSetup))
+;
+
+const
+ConnectorTestSetup compactSpreadSetup(createConnectingInConnector,
+                                      createConnectingCompactOutConnector,
+                                      createInConnectorWithBus,
+                                      createOutConnectorWithBus);
+
+INSTANTIATE_TEST_CASE_P(CompactFragmentsSpreadConnector,
+        ConnectorTest,
+        ::testing::Values(compactSpreadSetup))
+;
+
+// Returns the daemon which is shared by all loopback connections of
+// the loopback connector tests.
+LoopbackDaemonPtr loopbackDaemon() {
+    static LoopbackDaemonPtr daemon(new LoopbackDaemon());
+    return daemon;
+}
+
+// Like createConnectingInConnector but the Bus uses an in-process
+// loopback connection instead of a Spread daemon.
+InConnectorPtr createLoopbackInConnector() {
+    BusPtr bus(BusImpl::create(ConnectionPtr(new LoopbackConnection(
+            loopbackDaemon()))));
+    bus->activate();
+    return InConnectorPtr(new rsb::transport::spread::InConnector
+                              (converterRepository<string>()
+                               ->getConvertersForDeserialization(),
+                               bus));
+}
+
+// Like createLoopbackInConnector but creates an OutConnector.
+OutConnectorPtr createLoopbackOutConnector() {
+    BusPtr bus(BusImpl::create(ConnectionPtr(new LoopbackConnection(
+            loopbackDaemon()))));
+    bus->activate();
+    return OutConnectorPtr(new rsb::transport::spread::OutConnector
+                           (converterRepository<string>()
+                            ->getConvertersForSerialization(),
+                            bus));
+}
+
+const
+ConnectorTestSetup loopbackSetup(createLoopbackInConnector,
+                                 createLoopbackOutConnector,
+                                 createInConnectorWithBus,
+                                 createOutConnectorWithBus);
+
+INSTANTIATE_TEST_CASE_P(LoopbackConnector,
+        ConnectorTest,
+        ::testing::Values(loopbackSetup))
+;
+
+// Returns an active bus which uses a loopback connection to
+// @a daemon.
+boost::shared_ptr<BusImpl> createLoopbackBus(LoopbackDaemonPtr daemon) {
+    boost::shared_ptr<BusImpl> bus = boost::static_pointer_cast<BusImpl>
+        (BusImpl::create(ConnectionPtr(new LoopbackConnection(daemon))));
+    bus->activate();
+    return bus;
+}
+
+// Returns an active bus which uses a loopback connection to
+// @a daemon and reconnects after losing the connection.
+boost::shared_ptr<BusImpl> createReconnectingBus(LoopbackDaemonPtr daemon) {
+    boost::shared_ptr<BusImpl> bus = boost::static_pointer_cast<BusImpl>
+        (BusImpl::create(ConnectionPtr(new LoopbackConnection(daemon))));
+    bus->setReconnect(200, 10);
+    bus->activate();
+    return bus;
+}
+
+// An active InConnector on @a scope whose handler records the
+// received events.
+class Listener {
+public:
+    Listener(BusPtr bus, const Scope& scope, unsigned int expectedEvents = 1) :
+        observer(scope, expectedEvents),
+        connector(new rsb::transport::spread::InConnector
+                  (converterRepository<string>()
+                   ->getConvertersForDeserialization(),
+                   bus)) {
+        this->connector->setScope(scope);
+        this->connector->activate();
+        this->connector->addHandler
+            (HandlerPtr(new EventFunctionHandler
+                        (boost::bind(&WaitingObserver::handler,
+                                     &this->observer, _1))));
+    }
+
+    // Waits for the expected events and returns the first one or an
+    // empty pointer after a timeout.
+    EventPtr waitFirst() {
+        if (!this->observer.waitReceived(10000)) {
+            return EventPtr();
+        }
+        return this->observer.getEvents()[0];
+    }
+
+    // Destroyed after the connector which refers to it.
+    WaitingObserver                                        observer;
+    boost::shared_ptr<rsb::transport::spread::InConnector> connector;
+};
+
+typedef boost::shared_ptr<Listener> ListenerPtr;
+
+// Returns an active OutConnector which sends via @a bus.
+OutConnectorPtr createActiveOutConnector(BusPtr       bus,
+                                         unsigned int maxFragmentSize = 100000) {
+    OutConnectorPtr out(new rsb::transport::spread::OutConnector
+                        (converterRepository<string>()
+                         ->getConvertersForSerialization(),
+                         bus, maxFragmentSize));
+    out->activate();
+    return out;
+}
+
+// Sends an event with @a data on @a scope via @a out.
+void sendString(OutConnectorPtr           out,
+                const Scope&              scope,
+                boost::shared_ptr<string> data,
+                boost::uint64_t           sequenceNumber = 1) {
+    EventPtr event(new Event(scope, data, rsc::runtime::typeName<string>()));
+    event->setId(rsc::misc::UUID(), sequenceNumber);
+    out->handle(event);
+}
+
+TEST(SpreadConnectorTest, testShareLocalData) {
+    boost::shared_ptr<BusImpl> bus
+        = createLoopbackBus(LoopbackDaemonPtr(new LoopbackDaemon()));
+    Listener listener(bus, Scope("/local"));
+    listener.connector->setShareLocalData(true);
+
+    boost::shared_ptr<string> data(new string("foo"));
+    sendString(createActiveOutConnector(bus), Scope("/local"), data);
+
+    EventPtr received = listener.waitFirst();
+    ASSERT_TRUE(received);
+    EXPECT_EQ(data, received->getData());
+}
+
+TEST(SpreadConnectorTest, testLazyDeserialization) {
+    LoopbackDaemonPtr daemon(new LoopbackDaemon());
+    Listener listener(createLoopbackBus(daemon), Scope("/lazy"));
+    listener.connector->setLazyDeserialization(true);
+
+    sendString(createActiveOutConnector(createLoopbackBus(daemon)),
+               Scope("/lazy"), boost::shared_ptr<string>(new string("foo")));
+
+    EventPtr received = listener.waitFirst();
+    ASSERT_TRUE(received);
+    EXPECT_EQ(rsc::runtime::typeName<LazyPayload>(), received->getType());
+    LazyPayloadPtr payload
+        = boost::static_pointer_cast<LazyPayload>(received->getData());
+    EXPECT_EQ("foo", payload->getSerializedPayload());
+    EXPECT_EQ(rsc::runtime::typeName<string>(), payload->get().first);
+    EXPECT_EQ("foo", *payload->getAs<string>());
+}
+
+TEST(SpreadConnectorTest, testLazyDeserializationWithSharedLocalData) {
+    LoopbackDaemonPtr daemon(new LoopbackDaemon());
+    boost::shared_ptr<BusImpl> bus = createLoopbackBus(daemon);
+    Listener listener(bus, Scope("/lazy"), 2);
+    listener.connector->setShareLocalData(true);
+    listener.connector->setLazyDeserialization(true);
+
+    boost::shared_ptr<string> local(new string("local"));
+    sendString(createActiveOutConnector(bus), Scope("/lazy"), local);
+    sendString(createActiveOutConnector(createLoopbackBus(daemon)),
+               Scope("/lazy"), boost::shared_ptr<string>(new string("remote")));
+
+    // Local and remote events are both delivered as LazyPayload.
+    ASSERT_TRUE(listener.waitFirst());
+    vector<EventPtr> events = listener.observer.getEvents();
+    ASSERT_EQ(2u, events.size());
+    for (unsigned int i = 0; i < events.size(); ++i) {
+        EXPECT_EQ(rsc::runtime::typeName<LazyPayload>(), events[i]->getType());
+    }
+    LazyPayloadPtr localPayload
+        = boost::static_pointer_cast<LazyPayload>(events[0]->getData());
+    EXPECT_EQ(rsc::runtime::typeName<string>(), localPayload->getDataType());
+    EXPECT_EQ(local, localPayload->getAs<string>());
+    LazyPayloadPtr remotePayload
+        = boost::static_pointer_cast<LazyPayload>(events[1]->getData());
+    EXPECT_EQ("remote", *remotePayload->getAs<string>());
+}
+
+// Waits until @a bus has reconnected at least once.
+bool waitReconnected(boost::shared_ptr<BusImpl> bus) {
+    for (unsigned int i = 0; i < 1000; ++i) {
+        const Counter* reconnects
+            = bus->getMetrics()->findCounter("rsb_spread_reconnects_total");
+        if (reconnects && (reconnects->get() > 0)) {
+            return true;
+        }
+        boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+    }
+    return false;
+}
+
+TEST(SpreadConnectorTest, testReconnectAfterDaemonRestart) {
+    LoopbackDaemonPtr daemon(new LoopbackDaemon());
+    boost::shared_ptr<BusImpl> inBus = createReconnectingBus(daemon);
+    boost::shared_ptr<BusImpl> outBus = createReconnectingBus(daemon);
+
+    Listener before(inBus, Scope("/reconnect"), 1);
+    Listener after(inBus, Scope("/reconnect"), 2);
+    OutConnectorPtr out = createActiveOutConnector(outBus);
+
+    boost::shared_ptr<string> data(new string("foo"));
+    sendString(out, Scope("/reconnect"), data, 1);
+    ASSERT_TRUE(before.waitFirst());
+
+    // The daemon forgets all memberships when restarted. The
+    // receiving bus has to restore the memberships of its
+    // connectors.
+    daemon->stop();
+    daemon->start();
+    ASSERT_TRUE(waitReconnected(inBus));
+
+    // The sending bus either has reconnected as well or buffers the
+    // notification until it has.
+    sendString(out, Scope("/reconnect"), data, 2);
+
+    ASSERT_TRUE(after.waitFirst());
+    EXPECT_TRUE(waitReconnected(outBus));
+}
+
+// A loopback connection which fails to send its failAt-th message.
+class FailingLoopbackConnection : public LoopbackConnection {
+public:
+    FailingLoopbackConnection(LoopbackDaemonPtr daemon, unsigned int failAt) :
+        LoopbackConnection(daemon), failAt(failAt), numSends(0) {
+    }
+
+    void send(const SpreadMessage& message) {
+        if (++this->numSends == this->failAt) {
+            throw rsb::CommException("Simulated send failure");
+        }
+        LoopbackConnection::send(message);
+    }
+private:
+    unsigned int failAt;
+    unsigned int numSends;
+};
+
+TEST(SpreadConnectorTest, testResumePartiallySentNotification) {
+    LoopbackDaemonPtr daemon(new LoopbackDaemon());
+    boost::shared_ptr<BusImpl> inBus = createReconnectingBus(daemon);
+    boost::shared_ptr<BusImpl> outBus = boost::static_pointer_cast<BusImpl>
+        (BusImpl::create(ConnectionPtr(new FailingLoopbackConnection(daemon, 3))));
+    outBus->setReconnect(200, 10);
+    outBus->activate();
+
+    Listener listener(inBus, Scope("/resume"));
+
+    // Small fragments such that sending fails after the first two of
+    // several fragments.
+    const string data(1000, 'x');
+    sendString(createActiveOutConnector(outBus, 200), Scope("/resume"),
+               boost::shared_ptr<string>(new string(data)));
+
+    // After reconnecting, only the remaining fragments are sent.
+    EventPtr received = listener.waitFirst();
+    ASSERT_TRUE(received);
+    EXPECT_EQ(data, *boost::static_pointer_cast<string>(received->getData()));
+    EXPECT_TRUE(waitReconnected(outBus));
+    const Counter* duplicates = inBus->getMetrics()->findCounter
+        ("rsb_spread_assembly_duplicate_fragments_total");
+    ASSERT_TRUE(duplicates);
+    EXPECT_EQ(0u, duplicates->get());
+}
+
+// Delivers one event from a remote bus to two connectors on another
+// bus and returns the data objects the connectors' handlers got.
+pair<VoidPtr, VoidPtr> receiveWithTwoListeners(bool share) {
+    LoopbackDaemonPtr daemon(new LoopbackDaemon());
+    BusPtr inBus = createLoopbackBus(daemon);
+
+    vector<ListenerPtr> listeners;
+    for (unsigned int i = 0; i < 2; ++i) {
+        ListenerPtr listener(new Listener(inBus, Scope("/shared")));
+        listener->connector->setShareLocalData(share);
+        listeners.push_back(listener);
+    }
+
+    sendString(createActiveOutConnector(createLoopbackBus(daemon)),
+               Scope("/shared"), boost::shared_ptr<string>(new string("foo")));
+
+    EventPtr first  = listeners[0]->waitFirst();
+    EventPtr second = listeners[1]->waitFirst();
+    if (!first || !second) {
+        return pair<VoidPtr, VoidPtr>();
+    }
+    return make_pair(first->getData(), second->getData());
+}
+
+TEST(SpreadConnectorTest, testDeserializedDataIsPrivate) {
+    pair<VoidPtr, VoidPtr> data = receiveWithTwoListeners(false);
+    ASSERT_TRUE(data.first);
+    ASSERT_TRUE(data.second);
+    EXPECT_NE(data.first, data.second);
+
+    // A handler modifying its data does not affect the other one.
+    *boost::static_pointer_cast<string>(data.first) = "bar";
+    EXPECT_EQ("foo", *boost::static_pointer_cast<string>(data.second));
+}
+
+TEST(SpreadConnectorTest, testDeserializedDataIsShared) {
+    pair<VoidPtr, VoidPtr> data = receiveWithTwoListeners(true);
+    ASSERT_TRUE(data.first);
+    EXPECT_EQ(data.first, data.second);
+    EXPECT_EQ("foo", *boost::static_pointer_cast<string>(data.first));
+}
+
+TEST(SpreadConnectorTest, testMalformedMessageIsDiscarded) {
+    LoopbackDaemonPtr daemon(new LoopbackDaemon());
+    boost::shared_ptr<BusImpl> bus = createLoopbackBus(daemon);
+    Listener listener(bus, Scope("/malformed"));
+
+    // Neither a protobuf message nor a compact message.
+    LoopbackConnectionPtr other(new LoopbackConnection(daemon));
+    other->activate();
+    SpreadMessage malformed(string("\xff\xff\xff", 3));
+    malformed.addGroup(GroupNameCache::scopeToGroup(Scope("/malformed")));
+    other->send(malformed);
+
+    // The bus keeps receiving without reconnecting.
+    sendString(createActiveOutConnector(createLoopbackBus(daemon)),
+               Scope("/malformed"), boost::shared_ptr<string>(new string("foo")));
+    ASSERT_TRUE(listener.waitFirst());
+
+    const Counter* discarded
+        = bus->getMetrics()->findCounter("rsb_spread_malformed_messages_total");
+    ASSERT_TRUE(discarded);
+    EXPECT_EQ(1u, discarded->get());
+    const Counter* failures
+        = bus->getMetrics()->findCounter("rsb_spread_receive_failures_total");
+    ASSERT_TRUE(failures);
+    EXPECT_EQ(0u, failures->get());
+}
+
+// Sends the events with sequence numbers 1 and 3 of one sender on
+// the scope /loss/events to a listener on @a listenScope and returns
+// the loss reports delivered to its loss handler.
+vector<EventPtr> receiveLossReports(const Scope& listenScope) {
+    LoopbackDaemonPtr daemon(new LoopbackDaemon());
+    Listener listener(createLoopbackBus(daemon), listenScope, 2);
+    WaitingObserver losses(listenScope, 1);
+    listener.connector->addLossHandler
+        (HandlerPtr(new EventFunctionHandler
+                    (boost::bind(&WaitingObserver::handler, &losses, _1))));
+
+    OutConnectorPtr out = createActiveOutConnector(createLoopbackBus(daemon));
+    rsc::misc::UUID sender;
+    for (boost::uint32_t sequenceNumber = 1; sequenceNumber <= 3;
+         sequenceNumber += 2) {
+        EventPtr event(new Event(Scope("/loss/events"),
+                                 boost::shared_ptr<string>(new string("foo")),
+                                 rsc::runtime::typeName<string>()));
+        event->setId(sender, sequenceNumber);
+        out->handle(event);
+    }
+
+    // Loss reports are delivered before the event which reveals the
+    // loss.
+    EXPECT_TRUE(listener.observer.waitReceived(10000));
+    vector<EventPtr> events = listener.observer.getEvents();
+    for (vector<EventPtr>::const_iterator it = events.begin();
+         it != events.end(); ++it) {
+        EXPECT_EQ(rsc::runtime::typeName<string>(), (*it)->getType());
+    }
+    return losses.getEvents();
+}
+
+TEST(SpreadConnectorTest, testLossHandler) {
+    vector<EventPtr> reports = receiveLossReports(Scope("/"));
+    ASSERT_EQ(1u, reports.size());
+    EXPECT_EQ(rsc::runtime::typeName<LossReport>(), reports[0]->getType());
+    LossReportPtr report
+        = boost::static_pointer_cast<LossReport>(reports[0]->getData());
+    EXPECT_EQ(2u, report->firstMissing);
+    EXPECT_EQ(1u, report->numMissing);
+
+    // A bus which is not a member of the group of the root scope may
+    // not receive all notifications of the sender and does not track
+    // them.
+    EXPECT_TRUE(receiveLossReports(Scope("/loss")).empty());
+}
+
+// Sends two events to a listener via a bus which labels metrics
+// with scopes if @a scopeMetrics is true and returns the metrics of
+// the bus.
+MetricsRegistryPtr transferWithScopeMetrics(bool scopeMetrics) {
+    boost::shared_ptr<BusImpl> bus = boost::static_pointer_cast<BusImpl>
+        (BusImpl::create(ConnectionPtr(new LoopbackConnection
+                                       (LoopbackDaemonPtr(new LoopbackDaemon())))));
+    bus->setScopeMetrics(scopeMetrics);
+    bus->activate();
+
+    Listener listener(bus, Scope("/metrics"), 2);
+    OutConnectorPtr out = createActiveOutConnector(bus);
+    for (unsigned int i = 1; i <= 2; ++i) {
+        sendString(out, Scope("/metrics"),
+                   boost::shared_ptr<string>(new string("foo")), i);
+    }
+    // The duration of the first handler call is recorded before the
+    // second event is dispatched.
+    EXPECT_TRUE(listener.waitFirst());
+
+    return bus->getMetrics();
+}
+
+// Checks that the histograms of the sending and receiving side
+// exist in @a metrics with exactly @a labels.
+void expectTransferHistograms(MetricsRegistryPtr  metrics,
+                              const MetricLabels& labels) {
+    const Histogram* fragments
+        = metrics->findHistogram("rsb_spread_fragments_per_notification",
+                                 labels);
+    ASSERT_TRUE(fragments);
+    EXPECT_EQ(2u, fragments->getCount());
+
+    const Histogram* sendToReceive
+        = metrics->findHistogram("rsb_spread_send_to_receive_latency_microseconds",
+                                 labels);
+    ASSERT_TRUE(sendToReceive);
+    EXPECT_EQ(2u, sendToReceive->getCount());
+
+    const Histogram* receiveToHandler
+        = metrics->findHistogram("rsb_spread_receive_to_handler_latency_microseconds",
+                                 labels);
+    ASSERT_TRUE(receiveToHandler);
+    EXPECT_EQ(2u, receiveToHandler->getCount());
+
+    MetricLabels handlerLabels = labels;
+    handlerLabels.add("handler",
+                      rsc::runtime::typeName(typeid(EventFunctionHandler)));
+    const Histogram* handlerDuration
+        = metrics->findHistogram("rsb_spread_handler_duration_microseconds",
+                                 handlerLabels);
+    ASSERT_TRUE(handlerDuration);
+    EXPECT_LE(1u, handlerDuration->getCount());
+}
+
+TEST(SpreadConnectorTest, testScopeMetrics) {
+    MetricLabels scopeLabels;
+    scopeLabels.add("scope", Scope("/metrics").toString());
+
+    MetricsRegistryPtr metrics = transferWithScopeMetrics(false);
+    expectTransferHistograms(metrics, MetricLabels());
+    EXPECT_FALSE(metrics->findHistogram("rsb_spread_fragments_per_notification",
+                                        scopeLabels));
+    EXPECT_FALSE(metrics->findHistogram
+                 ("rsb_spread_send_to_receive_latency_microseconds",
+                  scopeLabels));
+
+    metrics = transferWithScopeMetrics(true);
+    expectTransferHistograms(metrics, scopeLabels);
+    EXPECT_FALSE(metrics->findHistogram
+                 ("rsb_spread_send_to_receive_latency_microseconds"));
+}
+
+TEST(SpreadConnectorTest, testClockMetrics) {
+    LoopbackDaemonPtr daemon(new LoopbackDaemon());
+    boost::shared_ptr<BusImpl> bus = boost::static_pointer_cast<BusImpl>
+        (BusImpl::create(ConnectionPtr(new LoopbackConnection(daemon))));
+    bus->setClockSyncInterval(20);
+    bus->activate();
+    Listener listener(bus, Scope("/clock"));
+
+    // The sending bus has to answer the clock synchronization
+    // requests.
+    OutConnectorPtr out = createActiveOutConnector(createLoopbackBus(daemon));
+    sendString(out, Scope("/clock"), boost::shared_ptr<string>(new string("foo")));
+    ASSERT_TRUE(listener.waitFirst());
+
+    // The gauges are aggregated over the peers instead of labeled
+    // with each of them.
+    const Gauge* peers = bus->getMetrics()->findGauge("rsb_spread_clock_peers");
+    ASSERT_TRUE(peers);
+    for (unsigned int i = 0; (i < 500) && (peers->get() == 0); ++i) {
+        boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+    }
+    EXPECT_EQ(1, peers->get());
+    EXPECT_TRUE(bus->getMetrics()->findGauge
+                ("rsb_spread_clock_round_trip_max_microseconds"));
+}
@@ -51,6 +51,7 @@ TEST(SpreadMessageTest, testConstruction)
         EXPECT_EQ(SpreadMessage::UNRELIABLE, m.getQOS());
         EXPECT_EQ(string(""), string(m.getData()));
         EXPECT_TRUE(m.getGroups().empty());
+        EXPECT_EQ(string(""), m.getSender());
     }
 
     {
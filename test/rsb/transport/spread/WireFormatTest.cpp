@@ -0,0 +1,217 @@
+/* ============================================================
+ *
+ * This file is part of the rsb-spread project.
+ *
+ * Copyright (C) 2018 Jan Moringen <jmoringe@techfak.uni-bielefeld.de>
+ *
+ * This file may be licensed under the terms of the
+ * GNU Lesser General Public License Version 3 (the ``LGPL''),
+ * or (at your option) any later version.
+ *
+ * Software distributed under the License is distributed
+ * on an ``AS IS'' basis, WITHOUT WARRANTY OF ANY KIND, either
+ * express or implied. See the LGPL for the specific language
+ * governing rights and limitations.
+ *
+ * You should have received a copy of the LGPL along with this
+ * program. If not, go to http://www.gnu.org/licenses/lgpl.html
+ * or write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The development of this software was supported by:
+ *   CoR-Lab, Research Institute for Cognition and Robotics
+ *     Bielefeld University
+ *
+ * ============================================================ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <rsb/transport/spread/WireFormat.h>
+
+using namespace std;
+
+using namespace rsb;
+using namespace rsb::transport::spread;
+
+using namespace testing;
+
+namespace {
+
+rsb::protocol::EventId makeEventId() {
+    rsb::protocol::EventId eventId;
+    eventId.set_sender_id(string("0123456789abcdef", 16));
+    eventId.set_sequence_number(0x01020304);
+    return eventId;
+}
+
+}
+
+TEST(WireFormatTest, testProtobufIsNotCompact)
+{
+    rsb::protocol::FragmentedNotification fragment;
+    *fragment.mutable_notification()->mutable_event_id() = makeEventId();
+    fragment.set_data_part(0);
+    fragment.set_num_data_parts(1);
+    string serialized;
+    ASSERT_TRUE(fragment.SerializeToString(&serialized));
+
+    EXPECT_FALSE(isCompactMessage(serialized));
+    EXPECT_FALSE(isCompactMessage(""));
+}
+
+TEST(WireFormatTest, testContinuationFragmentRoundtrip)
+{
+    rsb::protocol::EventId eventId = makeEventId();
+    const string data(1000, 'x');
+
+    string encoded;
+    encodeContinuationFragment(eventId, 2, 5, data, encoded);
+    EXPECT_TRUE(isCompactMessage(encoded));
+    EXPECT_EQ(COMPACT_CONTINUATION_FRAGMENT, compactMessageKind(encoded));
+    EXPECT_EQ(continuationFragmentHeaderSize(eventId) + data.size(),
+              encoded.size());
+
+    rsb::protocol::FragmentedNotification fragment;
+    fragment.mutable_notification()->set_scope("/stale");
+    ASSERT_TRUE(decodeContinuationFragment(encoded, fragment));
+    EXPECT_EQ(eventId.sender_id(),
+              fragment.notification().event_id().sender_id());
+    EXPECT_EQ(eventId.sequence_number(),
+              fragment.notification().event_id().sequence_number());
+    EXPECT_EQ(2u, fragment.data_part());
+    EXPECT_EQ(5u, fragment.num_data_parts());
+    EXPECT_EQ(data, fragment.notification().data());
+    EXPECT_FALSE(fragment.notification().has_scope());
+}
+
+TEST(WireFormatTest, testMalformedContinuationFragment)
+{
+    string encoded;
+    encodeContinuationFragment(makeEventId(), 1, 2, "data", encoded);
+
+    rsb::protocol::FragmentedNotification fragment;
+
+    // Truncated.
+    for (size_t size = 0; size < encoded.size(); ++size) {
+        EXPECT_FALSE(decodeContinuationFragment(encoded.substr(0, size),
+                                                fragment));
+    }
+
+    // Unsupported version.
+    string unsupported = encoded;
+    unsupported[2] = COMPACT_FORMAT_VERSION + 1;
+    EXPECT_FALSE(decodeContinuationFragment(unsupported, fragment));
+
+    // Trailing garbage.
+    EXPECT_FALSE(decodeContinuationFragment(encoded + "x", fragment));
+
+    // Part index out of range.
+    string invalidPart;
+    encodeContinuationFragment(makeEventId(), 2, 2, "data", invalidPart);
+    EXPECT_FALSE(decodeContinuationFragment(invalidPart, fragment));
+}
+
+TEST(WireFormatTest, testClockPingPongRoundtrip)
+{
+    string ping;
+    encodeClockPing(0x0102030405060708ull, ping);
+    EXPECT_TRUE(isCompactMessage(ping));
+    EXPECT_TRUE(isControlMessage(ping));
+    EXPECT_EQ(COMPACT_CLOCK_PING, compactMessageKind(ping));
+
+    boost::uint64_t sendTime = 0;
+    ASSERT_TRUE(decodeClockPing(ping, sendTime));
+    EXPECT_EQ(0x0102030405060708ull, sendTime);
+
+    string pong;
+    encodeClockPong(1, 2, 3, pong);
+    EXPECT_TRUE(isControlMessage(pong));
+    EXPECT_EQ(COMPACT_CLOCK_PONG, compactMessageKind(pong));
+
+    boost::uint64_t t1 = 0, t2 = 0, t3 = 0;
+    ASSERT_TRUE(decodeClockPong(pong, t1, t2, t3));
+    EXPECT_EQ(1u, t1);
+    EXPECT_EQ(2u, t2);
+    EXPECT_EQ(3u, t3);
+
+    // Kinds must not be confused and truncation must be detected.
+    EXPECT_FALSE(decodeClockPing(pong, sendTime));
+    EXPECT_FALSE(decodeClockPong(ping, t1, t2, t3));
+    EXPECT_FALSE(decodeClockPing(ping.substr(0, ping.size() - 1), sendTime));
+
+    // Continuation fragments are not control messages.
+    string fragment;
+    encodeContinuationFragment(makeEventId(), 1, 2, "data", fragment);
+    EXPECT_FALSE(isControlMessage(fragment));
+}
+
+TEST(WireFormatTest, testParityFragmentRoundtrip)
+{
+    ParityFragment fragment;
+    fragment.eventId        = makeEventId();
+    fragment.numDataParts   = 5;
+    fragment.numParityParts = 2;
+    fragment.parityIndex    = 1;
+    fragment.lengthParity   = 0x1234;
+    fragment.header         = "header";
+    fragment.data           = string(100, 'p');
+
+    string encoded;
+    encodeParityFragment(fragment, encoded);
+    EXPECT_TRUE(isCompactMessage(encoded));
+    EXPECT_FALSE(isControlMessage(encoded));
+    EXPECT_EQ(COMPACT_PARITY_FRAGMENT, compactMessageKind(encoded));
+
+    ParityFragment decoded;
+    ASSERT_TRUE(decodeParityFragment(encoded, decoded));
+    EXPECT_EQ(fragment.eventId.sender_id(), decoded.eventId.sender_id());
+    EXPECT_EQ(fragment.eventId.sequence_number(),
+              decoded.eventId.sequence_number());
+    EXPECT_EQ(5u, decoded.numDataParts);
+    EXPECT_EQ(2u, decoded.numParityParts);
+    EXPECT_EQ(1u, decoded.parityIndex);
+    EXPECT_EQ(0x1234u, decoded.lengthParity);
+    EXPECT_EQ("header", decoded.header);
+    EXPECT_EQ(fragment.data, decoded.data);
+
+    // Truncated.
+    EXPECT_FALSE(decodeParityFragment(encoded.substr(0, encoded.size() - 1),
+                                      decoded));
+
+    // Parity index out of range.
+    fragment.parityIndex = 2;
+    encodeParityFragment(fragment, encoded);
+    EXPECT_FALSE(decodeParityFragment(encoded, decoded));
+}
+
+TEST(WireFormatTest, testNackRoundtrip)
+{
+    vector<boost::uint32_t> parts;
+    parts.push_back(0);
+    parts.push_back(3);
+    parts.push_back(0x01020304);
+
+    string encoded;
+    encodeNack(makeEventId(), parts, encoded);
+    EXPECT_TRUE(isCompactMessage(encoded));
+    EXPECT_TRUE(isControlMessage(encoded));
+    EXPECT_EQ(COMPACT_NACK, compactMessageKind(encoded));
+
+    rsb::protocol::EventId eventId;
+    vector<boost::uint32_t> decoded;
+    ASSERT_TRUE(decodeNack(encoded, eventId, decoded));
+    EXPECT_EQ(makeEventId().sender_id(), eventId.sender_id());
+    EXPECT_EQ(makeEventId().sequence_number(), eventId.sequence_number());
+    EXPECT_EQ(parts, decoded);
+
+    // Truncated and trailing garbage.
+    EXPECT_FALSE(decodeNack(encoded.substr(0, encoded.size() - 1),
+                            eventId, decoded));
+    EXPECT_FALSE(decodeNack(encoded + "x", eventId, decoded));
+
+    // Other kinds of compact messages.
+    string ping;
+    encodeClockPing(1, ping);
+    EXPECT_FALSE(decodeNack(ping, eventId, decoded));
+}